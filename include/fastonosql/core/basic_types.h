@@ -18,9 +18,11 @@
 
 #pragma once
 
+#include <bitset>
 #include <deque>
 #include <limits>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <common/byte_writer.h>
@@ -43,6 +45,8 @@ typedef char command_buffer_char_t;
 typedef common::ByteArray<command_buffer_char_t> command_buffer_t;
 typedef common::ByteWriter<command_buffer_char_t, 512> command_buffer_writer_t;
 typedef std::deque<command_buffer_t> commands_args_t;
+typedef std::string_view command_arg_view_t;
+typedef std::vector<command_arg_view_t> command_args_views_t;
 typedef command_buffer_t readable_string_t;
 
 typedef readable_string_t raw_key_t;
@@ -55,7 +59,42 @@ typedef readable_string_t db_name_t;
 typedef std::vector<db_name_t> db_names_t;
 
 typedef uint32_t keys_limit_t;  // UIntegerValue
-typedef keys_limit_t cursor_t;
+
+// opaque scan continuation, every backend fills the part it needs:
+// server cursor position, last returned key for embedded engines, cluster nodes with their cursors
+class ScanCursor {
+ public:
+  typedef uint64_t position_t;
+  typedef readable_string_t token_t;
+
+  ScanCursor();  // start or end of iteration
+  explicit ScanCursor(position_t position);
+  ScanCursor(position_t position, const token_t& token);
+
+  bool IsFinished() const;  // same as start, redis-like
+  position_t GetPosition() const;
+  token_t GetToken() const;
+  bool HasToken() const;
+
+  bool Equals(const ScanCursor& other) const;
+
+  readable_string_t ToString() const;  // position or position:hex(token)
+  static bool FromString(const readable_string_t& str, ScanCursor* out) WARN_UNUSED_RESULT;
+
+ private:
+  position_t position_;
+  token_t token_;
+};
+
+inline bool operator==(const ScanCursor& r, const ScanCursor& l) {
+  return r.Equals(l);
+}
+
+inline bool operator!=(const ScanCursor& r, const ScanCursor& l) {
+  return !(r == l);
+}
+
+typedef ScanCursor cursor_t;
 
 typedef int64_t ttl_t;  // in seconds or NO_TTL, EXPIRED_TTL
 typedef ttl_t pttl_t;
@@ -64,6 +103,35 @@ COMPILE_ASSERT(std::numeric_limits<ttl_t>::max() >= NO_TTL && NO_TTL >= std::num
 COMPILE_ASSERT(std::numeric_limits<ttl_t>::max() >= EXPIRED_TTL && EXPIRED_TTL >= std::numeric_limits<ttl_t>::min(),
                "EXPIRED_TTL define must be in ttl type range");
 
+// SCAN MATCH glob compiled once per scan, redis syntax: * ? [abc] [^a-z] and \ escapes;
+// the literal head is kept apart so ordered engines can seek to it and stop after it
+class ScanPattern {
+ public:
+  explicit ScanPattern(const pattern_t& pattern);
+
+  bool IsMatchAll() const;
+  const raw_key_t& GetPrefix() const;  // every matching key starts with it
+  bool HasPrefix(const char* data, size_t size) const;
+  bool IsMatch(const char* data, size_t size) const;
+
+ private:
+  enum NodeType : uint8_t { NODE_CHAR, NODE_ANY_CHAR, NODE_ANY_SEQUENCE, NODE_CHAR_CLASS };
+  struct Node {
+    NodeType type;
+    unsigned char ch;
+    size_t char_class;  // index in char_classes_
+  };
+  typedef std::bitset<256> char_class_t;
+
+  bool IsNodeMatch(const Node& node, unsigned char ch) const;
+
+  raw_key_t prefix_;
+  std::vector<Node> nodes_;  // the rest after prefix_
+  std::vector<char_class_t> char_classes_;
+  bool is_match_all_;
+};
+
+// one shot match, compiles pattern on every call, use ScanPattern in loops
 bool IsKeyMatchPattern(const char* data, size_t size, const pattern_t& pattern);
 
 extern const raw_key_t kRangeKeyEnd;
@@ -61,7 +61,7 @@ class CDBConnection : public internal::DBConnection<NConnection, Config, connect
   common::Error Help(commands_args_t argv,
                      readable_string_t* answer) WARN_UNUSED_RESULT;  //
 
-  common::Error Scan(cursor_t cursor_in,
+  common::Error Scan(const cursor_t& cursor_in,
                      const pattern_t& pattern,
                      keys_limit_t count_keys,
                      raw_keys_t* keys_out,
@@ -70,8 +70,13 @@ class CDBConnection : public internal::DBConnection<NConnection, Config, connect
                      const raw_key_t& key_end,
                      keys_limit_t limit,
                      raw_keys_t* ret) WARN_UNUSED_RESULT;  // nvi
+  common::Error ReverseKeys(const raw_key_t& key_start,
+                            const raw_key_t& key_end,
+                            keys_limit_t limit,
+                            raw_keys_t* ret) WARN_UNUSED_RESULT;  // nvi, from key_end down to key_start
 
-  common::Error DBKeysCount(keys_limit_t* size) WARN_UNUSED_RESULT;  // nvi
+  common::Error DBKeysCount(keys_limit_t* size) WARN_UNUSED_RESULT;             // nvi
+  common::Error ApproximateDBKeysCount(keys_limit_t* size) WARN_UNUSED_RESULT;  // nvi, estimation if it is cheaper
   common::Error FlushDB() WARN_UNUSED_RESULT;                        // nvi
   common::Error Select(const db_name_t& name,
                        IDataBaseInfo** info) WARN_UNUSED_RESULT;         // nvi, select + dblcount
@@ -85,18 +90,20 @@ class CDBConnection : public internal::DBConnection<NConnection, Config, connect
                     NDbKValue* loaded_key) WARN_UNUSED_RESULT;  // nvi
   common::Error GetUni(const NKey& key,
                        NDbKValue* loaded_key) WARN_UNUSED_RESULT;  // nvi
+  common::Error GetUniMany(const NKeys& keys,
+                           std::vector<NDbKValue>* loaded_keys) WARN_UNUSED_RESULT;  // nvi, in order of keys
   common::Error Rename(const NKey& key,
                        const nkey_t& new_key) WARN_UNUSED_RESULT;                      // nvi
   common::Error SetTTL(const NKey& key, ttl_t ttl) WARN_UNUSED_RESULT;                 // nvi
   common::Error GetTTL(const NKey& key, ttl_t* ttl) WARN_UNUSED_RESULT;                // nvi
   common::Error GetType(const NKey& key, readable_string_t* type) WARN_UNUSED_RESULT;  // nvi
   common::Error Quit() WARN_UNUSED_RESULT;                                             // nvi
-  common::Error CsvDump(cursor_t cursor_in,
+  common::Error CsvDump(const cursor_t& cursor_in,
                         const pattern_t& pattern,
                         keys_limit_t limit,
                         const common::file_system::ascii_file_string_path& path,
                         cursor_t* cursor_out) WARN_UNUSED_RESULT;
-  common::Error JsonDump(cursor_t cursor_in,
+  common::Error JsonDump(const cursor_t& cursor_in,
                          const pattern_t& pattern,
                          keys_limit_t limit,
                          const common::file_system::ascii_file_string_path& path,
@@ -114,7 +121,7 @@ class CDBConnection : public internal::DBConnection<NConnection, Config, connect
   CDBConnectionClient* client_;
 
  private:
-  virtual common::Error ScanImpl(cursor_t cursor_in,
+  virtual common::Error ScanImpl(const cursor_t& cursor_in,
                                  const pattern_t& pattern,
                                  keys_limit_t count_keys,
                                  raw_keys_t* keys_out,
@@ -123,7 +130,12 @@ class CDBConnection : public internal::DBConnection<NConnection, Config, connect
                                  const raw_key_t& key_end,
                                  keys_limit_t limit,
                                  raw_keys_t* ret) = 0;
+  virtual common::Error ReverseKeysImpl(const raw_key_t& key_start,
+                                        const raw_key_t& key_end,
+                                        keys_limit_t limit,
+                                        raw_keys_t* ret);  // optional
   virtual common::Error DBKeysCountImpl(keys_limit_t* size) = 0;
+  virtual common::Error ApproximateDBKeysCountImpl(keys_limit_t* size);  // have default implementation
   virtual common::Error FlushDBImpl() = 0;
 
   virtual common::Error SelectImpl(const db_name_t& name, IDataBaseInfo** info) = 0;
@@ -137,6 +149,8 @@ class CDBConnection : public internal::DBConnection<NConnection, Config, connect
   virtual common::Error SetImpl(const NDbKValue& key) = 0;
   virtual common::Error GetImpl(const NKey& key, NDbKValue* loaded_key) = 0;
   virtual common::Error GetUniImpl(const NKey& key, NDbKValue* loaded_key);  // have default implementation
+  virtual common::Error GetUniManyImpl(const NKeys& keys,
+                                       std::vector<NDbKValue>* loaded_keys);  // have default implementation
   virtual common::Error RenameImpl(const NKey& key, const nkey_t& new_key) = 0;
   virtual common::Error SetTTLImpl(const NKey& key, ttl_t ttl);                 // optional
   virtual common::Error GetTTLImpl(const NKey& key, ttl_t* ttl);                // optional
@@ -197,7 +211,7 @@ common::Error CDBConnection<NConnection, Config, ContType>::Help(commands_args_t
 }
 
 template <typename NConnection, typename Config, ConnectionType ContType>
-common::Error CDBConnection<NConnection, Config, ContType>::Scan(cursor_t cursor_in,
+common::Error CDBConnection<NConnection, Config, ContType>::Scan(const cursor_t& cursor_in,
                                                                  const pattern_t& pattern,
                                                                  keys_limit_t count_keys,
                                                                  raw_keys_t* keys_out,
@@ -243,6 +257,29 @@ common::Error CDBConnection<NConnection, Config, ContType>::Keys(const raw_key_t
   return common::Error();
 }
 
+template <typename NConnection, typename Config, ConnectionType ContType>
+common::Error CDBConnection<NConnection, Config, ContType>::ReverseKeys(const raw_key_t& key_start,
+                                                                        const raw_key_t& key_end,
+                                                                        keys_limit_t limit,
+                                                                        raw_keys_t* ret) {
+  if (!ret) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  common::Error err = CDBConnection<NConnection, Config, ContType>::TestIsAuthenticated();
+  if (err) {
+    return err;
+  }
+
+  err = ReverseKeysImpl(key_start, key_end, limit, ret);
+  if (err) {
+    return err;
+  }
+
+  return common::Error();
+}
+
 template <typename NConnection, typename Config, ConnectionType ContType>
 common::Error CDBConnection<NConnection, Config, ContType>::DBKeysCount(keys_limit_t* size) {
   if (!size) {
@@ -263,6 +300,26 @@ common::Error CDBConnection<NConnection, Config, ContType>::DBKeysCount(keys_lim
   return common::Error();
 }
 
+template <typename NConnection, typename Config, ConnectionType ContType>
+common::Error CDBConnection<NConnection, Config, ContType>::ApproximateDBKeysCount(keys_limit_t* size) {
+  if (!size) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  common::Error err = CDBConnection<NConnection, Config, ContType>::TestIsAuthenticated();
+  if (err) {
+    return err;
+  }
+
+  err = ApproximateDBKeysCountImpl(size);
+  if (err) {
+    return err;
+  }
+
+  return common::Error();
+}
+
 template <typename NConnection, typename Config, ConnectionType ContType>
 common::Error CDBConnection<NConnection, Config, ContType>::FlushDB() {
   common::Error err = CDBConnection<NConnection, Config, ContType>::TestIsAuthenticated();
@@ -480,11 +537,55 @@ common::Error CDBConnection<NConnection, Config, ContType>::GetUni(const NKey& k
   return common::Error();
 }
 
+template <typename NConnection, typename Config, ConnectionType ContType>
+common::Error CDBConnection<NConnection, Config, ContType>::GetUniMany(const NKeys& keys,
+                                                                     std::vector<NDbKValue>* loaded_keys) {
+  if (!loaded_keys) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  common::Error err = CDBConnection<NConnection, Config, ContType>::TestIsAuthenticated();
+  if (err) {
+    return err;
+  }
+
+  std::vector<NDbKValue> lloaded_keys;
+  err = GetUniManyImpl(keys, &lloaded_keys);
+  if (err) {
+    return err;
+  }
+
+  if (client_) {
+    for (size_t i = 0; i < lloaded_keys.size(); ++i) {
+      client_->OnLoadedKey(lloaded_keys[i]);
+    }
+  }
+
+  *loaded_keys = lloaded_keys;
+  return common::Error();
+}
+
 template <typename NConnection, typename Config, ConnectionType ContType>
 common::Error CDBConnection<NConnection, Config, ContType>::GetUniImpl(const NKey& key, NDbKValue* loaded_key) {
   return GetImpl(key, loaded_key);
 }
 
+template <typename NConnection, typename Config, ConnectionType ContType>
+common::Error CDBConnection<NConnection, Config, ContType>::GetUniManyImpl(const NKeys& keys,
+                                                                         std::vector<NDbKValue>* loaded_keys) {
+  std::vector<NDbKValue> lloaded_keys(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    common::Error err = GetUniImpl(keys[i], &lloaded_keys[i]);
+    if (err) {
+      return err;
+    }
+  }
+
+  *loaded_keys = lloaded_keys;
+  return common::Error();
+}
+
 template <typename NConnection, typename Config, ConnectionType ContType>
 common::Error CDBConnection<NConnection, Config, ContType>::GetType(const NKey& key, readable_string_t* type) {
   if (!type) {
@@ -600,7 +701,7 @@ common::Error CDBConnection<NConnection, Config, ContType>::Quit() {
 
 template <typename NConnection, typename Config, ConnectionType ContType>
 common::Error CDBConnection<NConnection, Config, ContType>::CsvDump(
-    cursor_t cursor_in,
+    const cursor_t& cursor_in,
     const pattern_t& pattern,
     keys_limit_t limit,
     const common::file_system::ascii_file_string_path& path,
@@ -634,17 +735,23 @@ common::Error CDBConnection<NConnection, Config, ContType>::CsvDump(
     return err;
   }
 
+  NKeys nkeys;
+  nkeys.reserve(keys.size());
   for (size_t i = 0; i < keys.size(); ++i) {
-    const nkey_t key_str(keys[i]);
-    const NKey key(key_str);
-    NDbKValue loaded_key;
-    err = GetUniImpl(key, &loaded_key);
-    if (err) {
-      fl.Close();
-      return err;
-    }
+    nkeys.push_back(NKey(nkey_t(keys[i])));
+  }
+
+  std::vector<NDbKValue> loaded_keys;
+  err = GetUniManyImpl(nkeys, &loaded_keys);
+  if (err) {
+    fl.Close();
+    return err;
+  }
 
-    const NValue value = loaded_key.GetValue();
+  for (size_t i = 0; i < loaded_keys.size(); ++i) {
+    // keys removed after the scan are skipped, so loaded_keys is not index aligned with nkeys
+    const nkey_t key_str = loaded_keys[i].GetKey().GetKey();
+    const NValue value = loaded_keys[i].GetValue();
     const auto stabled_key = key_str.GetForCommandLine();
     const auto stabled_value = value.GetForCommandLine();
     command_buffer_writer_t wr;
@@ -664,7 +771,7 @@ common::Error CDBConnection<NConnection, Config, ContType>::CsvDump(
 
 template <typename NConnection, typename Config, ConnectionType ContType>
 common::Error CDBConnection<NConnection, Config, ContType>::JsonDump(
-    cursor_t cursor_in,
+    const cursor_t& cursor_in,
     const pattern_t& pattern,
     keys_limit_t limit,
     const common::file_system::ascii_file_string_path& path,
@@ -704,22 +811,28 @@ common::Error CDBConnection<NConnection, Config, ContType>::JsonDump(
     return err;
   }
 
+  NKeys nkeys;
+  nkeys.reserve(keys.size());
   for (size_t i = 0; i < keys.size(); ++i) {
-    const nkey_t key_str(keys[i]);
-    const NKey key(key_str);
-    NDbKValue loaded_key;
-    err = GetUniImpl(key, &loaded_key);
-    if (err) {
-      fl.Close();
-      return err;
-    }
+    nkeys.push_back(NKey(nkey_t(keys[i])));
+  }
 
-    const NValue value = loaded_key.GetValue();
+  std::vector<NDbKValue> loaded_keys;
+  err = GetUniManyImpl(nkeys, &loaded_keys);
+  if (err) {
+    fl.Close();
+    return err;
+  }
+
+  for (size_t i = 0; i < loaded_keys.size(); ++i) {
+    // keys removed after the scan are skipped, so loaded_keys is not index aligned with nkeys
+    const nkey_t key_str = loaded_keys[i].GetKey().GetKey();
+    const NValue value = loaded_keys[i].GetValue();
     const auto stabled_key = key_str.GetForCommandLine();
     const auto stabled_value = value.GetForCommandLine();
     command_buffer_writer_t wr;
     wr << stabled_key << ":" << stabled_value;
-    if (i != keys.size() - 1) {
+    if (i != loaded_keys.size() - 1) {
       wr << ",";
     }
     wr << "\n";
@@ -812,6 +925,26 @@ common::Error CDBConnection<NConnection, Config, ContType>::RemoveDBImpl(const d
   return common::make_error(error_msg);
 }
 
+template <typename NConnection, typename Config, ConnectionType ContType>
+common::Error CDBConnection<NConnection, Config, ContType>::ApproximateDBKeysCountImpl(keys_limit_t* size) {
+  return DBKeysCountImpl(size);
+}
+
+template <typename NConnection, typename Config, ConnectionType ContType>
+common::Error CDBConnection<NConnection, Config, ContType>::ReverseKeysImpl(const raw_key_t& key_start,
+                                                                            const raw_key_t& key_end,
+                                                                            keys_limit_t limit,
+                                                                            raw_keys_t* ret) {
+  UNUSED(key_start);
+  UNUSED(key_end);
+  UNUSED(limit);
+  UNUSED(ret);
+  const std::string error_msg = common::MemSPrintf("Sorry, but now " PROJECT_NAME_TITLE
+                                                   " for %s not supported " DB_REVERSE_KEYS_COMMAND " commands.",
+                                                   connection_traits_class::GetDBName());
+  return common::make_error(error_msg);
+}
+
 template <typename NConnection, typename Config, ConnectionType ContType>
 common::Error CDBConnection<NConnection, Config, ContType>::CreateDBImpl(const db_name_t& name, IDataBaseInfo** info) {
   UNUSED(name);
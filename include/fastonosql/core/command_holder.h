@@ -34,8 +34,8 @@ namespace internal {
 class CommandHandler;
 }
 
-common::Error TestArgsInRange(const CommandInfo& cmd, commands_args_t argv);
-common::Error TestArgsModule2Equal1(const CommandInfo& cmd, commands_args_t argv);
+common::Error TestArgsInRange(const CommandInfo& cmd, const command_args_views_t& argv);
+common::Error TestArgsModule2Equal1(const CommandInfo& cmd, const command_args_views_t& argv);
 
 class CommandHolder : public CommandInfo {
  public:
@@ -43,7 +43,7 @@ class CommandHolder : public CommandInfo {
 
   typedef internal::CommandHandler command_handler_t;
   typedef std::function<common::Error(command_handler_t*, commands_args_t, FastoObject*)> function_t;
-  typedef std::function<common::Error(const CommandInfo&, commands_args_t)> test_function_t;
+  typedef std::function<common::Error(const CommandInfo&, const command_args_views_t&)> test_function_t;
   typedef std::vector<test_function_t> test_functions_t;
 
   CommandHolder(const command_buffer_t& name,
@@ -57,10 +57,10 @@ class CommandHolder : public CommandInfo {
                 function_t func,
                 test_functions_t tests = {&TestArgsInRange});
 
-  bool IsCommand(commands_args_t argv, size_t* offset) const;
+  bool IsCommand(const commands_args_t& argv, size_t* offset) const;
   bool IsEqualFirstName(const command_buffer_t& cmd_first_name) const;
 
-  common::Error TestArgs(commands_args_t argv) const WARN_UNUSED_RESULT;
+  common::Error TestArgs(const command_args_views_t& argv) const WARN_UNUSED_RESULT;
 
  private:
   const function_t func_;
@@ -58,16 +58,21 @@ class DBConnection : public CDBConnection<NativeConnection, Config, LEVELDB> {
   common::Error SetInner(const raw_key_t& key, const raw_value_t& value) WARN_UNUSED_RESULT;
   common::Error GetInner(const raw_key_t& key, raw_value_t* ret_val) WARN_UNUSED_RESULT;
 
-  common::Error ScanImpl(cursor_t cursor_in,
+  common::Error ScanImpl(const cursor_t& cursor_in,
                          const pattern_t& pattern,
                          keys_limit_t count_keys,
                          raw_keys_t* keys_out,
                          cursor_t* cursor_out) override;
   common::Error KeysImpl(const raw_key_t& key_start,
                          const raw_key_t& key_end,
-                         cursor_t limit,
+                         keys_limit_t limit,
                          raw_keys_t* ret) override;
+  common::Error ReverseKeysImpl(const raw_key_t& key_start,
+                                const raw_key_t& key_end,
+                                keys_limit_t limit,
+                                raw_keys_t* ret) override;
   common::Error DBKeysCountImpl(keys_limit_t* size) override;
+  common::Error ApproximateDBKeysCountImpl(keys_limit_t* size) override;
   common::Error FlushDBImpl() override;
   common::Error SelectImpl(const db_name_t& name, IDataBaseInfo** info) override;
   common::Error DeleteImpl(const NKeys& keys, NKeys* deleted_keys) override;
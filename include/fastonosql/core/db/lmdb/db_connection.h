@@ -19,6 +19,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include <fastonosql/core/cdb_connection.h>
 
@@ -56,7 +57,7 @@ class DBConnection : public CDBConnection<NativeConnection, Config, LMDB> {
   common::Error GetInner(const raw_key_t& key, raw_value_t* ret_val) WARN_UNUSED_RESULT;
   common::Error DelInner(const raw_key_t& key) WARN_UNUSED_RESULT;
 
-  common::Error ScanImpl(cursor_t cursor_in,
+  common::Error ScanImpl(const cursor_t& cursor_in,
                          const pattern_t& pattern,
                          keys_limit_t count_keys,
                          raw_keys_t* keys_out,
@@ -65,6 +66,10 @@ class DBConnection : public CDBConnection<NativeConnection, Config, LMDB> {
                          const raw_key_t& key_end,
                          keys_limit_t limit,
                          raw_keys_t* ret) override;
+  common::Error ReverseKeysImpl(const raw_key_t& key_start,
+                                const raw_key_t& key_end,
+                                keys_limit_t limit,
+                                raw_keys_t* ret) override;
   common::Error DBKeysCountImpl(keys_limit_t* size) override;
   common::Error FlushDBImpl() override;
   common::Error CreateDBImpl(const db_name_t& name, IDataBaseInfo** info) override;
@@ -72,6 +77,7 @@ class DBConnection : public CDBConnection<NativeConnection, Config, LMDB> {
   common::Error SelectImpl(const db_name_t& name, IDataBaseInfo** info) override;
   common::Error SetImpl(const NDbKValue& key) override;
   common::Error GetImpl(const NKey& key, NDbKValue* loaded_key) override;
+  common::Error GetUniManyImpl(const NKeys& keys, std::vector<NDbKValue>* loaded_keys) override;  // one read txn
   common::Error DeleteImpl(const NKeys& keys, NKeys* deleted_keys) override;
   common::Error RenameImpl(const NKey& key, const nkey_t& new_key) override;
   common::Error QuitImpl() override;
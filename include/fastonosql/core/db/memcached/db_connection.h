@@ -67,7 +67,7 @@ class DBConnection : public CDBConnection<NativeConnection, Config, MEMCACHED> {
   common::Error SetInner(const raw_key_t& key, const raw_value_t& value, time_t expiration, uint32_t flags)
       WARN_UNUSED_RESULT;
 
-  common::Error ScanImpl(cursor_t cursor_in,
+  common::Error ScanImpl(const cursor_t& cursor_in,
                          const pattern_t& pattern,
                          keys_limit_t count_keys,
                          raw_keys_t* keys_out,
@@ -0,0 +1,128 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fastonosql/core/db_key.h>
+
+#include <fastonosql/core/db/redis_compatible/config.h>
+
+struct redisAsyncContext;
+struct redisReply;
+
+namespace fastonosql {
+namespace core {
+namespace redis_compatible {
+
+class CommandTranslator;
+class AsyncConnection;
+
+// single threaded poll loop, one thread drives the sockets of any number of AsyncConnection
+class AsyncEventLoop {
+ public:
+  AsyncEventLoop();
+  ~AsyncEventLoop();
+
+  size_t RunOnce(int timeout_msec);  // waits up to timeout_msec (-1 forever), returns count of handled sockets
+  void Run();                        // until Stop() or nothing is left to wait for
+  void Stop();
+
+ private:
+  friend class AsyncConnection;
+
+  void Register(AsyncConnection* connection);
+  void Unregister(AsyncConnection* connection);
+  bool IsRegistered(AsyncConnection* connection) const;
+  bool HasWatchedSockets() const;
+
+  std::vector<AsyncConnection*> connections_;
+  bool stop_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncEventLoop);
+};
+
+// non blocking counterpart of DBConnection for direct tcp and unix socket connections (no ssh tunnel, no ssl),
+// callbacks run inside AsyncEventLoop::RunOnce, commands issued before the connect completes are queued
+class AsyncConnection {
+ public:
+  typedef std::function<void(common::Error err, redisReply* reply)> reply_callback_t;  // reply is freed after it
+  typedef std::function<void(common::Error err)> status_callback_t;
+  typedef std::function<void(common::Error err, const std::string& content)> info_callback_t;
+  typedef std::function<void(common::Error err, keys_limit_t size)> keys_count_callback_t;
+  typedef std::function<void(common::Error err, const raw_keys_t& keys, const cursor_t& cursor_out)> scan_callback_t;
+  typedef std::function<void(common::Error err, const readable_string_t& type)> type_callback_t;
+  typedef std::function<void(common::Error err, const NDbKValue& loaded_key)> load_callback_t;
+  typedef std::function<void(common::Error err, ttl_t ttl)> ttl_callback_t;
+
+  AsyncConnection(AsyncEventLoop* loop, std::shared_ptr<CommandTranslator> translator);
+  ~AsyncConnection();  // pending callbacks get an error, must not be called from inside a callback
+
+  // AUTH and SELECT go in front of any other command, on_connected fires after them
+  common::Error Connect(const Config& config, status_callback_t on_connected) WARN_UNUSED_RESULT;
+  void Disconnect();  // graceful, pending replies are still delivered
+  bool IsConnected() const;
+
+  common::Error ExecCommand(const commands_args_t& argv, reply_callback_t cb) WARN_UNUSED_RESULT;
+
+  common::Error Info(const std::string& section, info_callback_t cb) WARN_UNUSED_RESULT;  // empty section for all
+  common::Error DBKeysCount(keys_count_callback_t cb) WARN_UNUSED_RESULT;
+  common::Error Scan(const cursor_t& cursor_in,
+                     const pattern_t& pattern,
+                     keys_limit_t count_keys,
+                     scan_callback_t cb) WARN_UNUSED_RESULT;
+  common::Error GetType(const NKey& key, type_callback_t cb) WARN_UNUSED_RESULT;
+  common::Error GetUni(const NKey& key, load_callback_t cb) WARN_UNUSED_RESULT;  // TYPE, then the typed load
+  common::Error GetTTL(const NKey& key, ttl_callback_t cb) WARN_UNUSED_RESULT;
+  common::Error Set(const NDbKValue& key, status_callback_t cb) WARN_UNUSED_RESULT;
+  common::Error Delete(const NKey& key, status_callback_t cb) WARN_UNUSED_RESULT;
+
+ private:
+  friend class AsyncEventLoop;
+
+  // hiredis event hooks
+  static void AddRead(void* privdata);
+  static void DelRead(void* privdata);
+  static void AddWrite(void* privdata);
+  static void DelWrite(void* privdata);
+  static void Cleanup(void* privdata);
+
+  static void OnConnect(const redisAsyncContext* context, int status);
+  static void OnDisconnect(const redisAsyncContext* context, int status);
+  static void OnReply(redisAsyncContext* context, void* reply, void* privdata);
+
+  void FinishConnect(common::Error err);
+
+  AsyncEventLoop* const loop_;
+  const std::shared_ptr<CommandTranslator> translator_;
+  redisAsyncContext* context_;
+  bool is_connected_;
+  bool is_reading_;
+  bool is_writing_;
+  status_callback_t on_connected_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncConnection);
+};
+
+}  // namespace redis_compatible
+}  // namespace core
+}  // namespace fastonosql
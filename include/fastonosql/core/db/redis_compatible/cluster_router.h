@@ -0,0 +1,140 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <common/net/types.h>
+
+#include <fastonosql/core/basic_types.h>
+#include <fastonosql/core/ssh_info.h>
+
+#include <fastonosql/core/db/redis_compatible/config.h>
+
+struct redisContext;
+struct redisReply;
+
+namespace fastonosql {
+namespace core {
+namespace redis_compatible {
+
+enum { cluster_slots_count = 16384 };
+
+uint16_t Crc16(const char* buf, size_t len);                  // CRC16/XMODEM as used by redis cluster
+uint16_t KeyHashSlot(const char* key, size_t len);            // honours {hash tags}
+size_t KeyArgIndex(const commands_args_t& argv);              // 0 for commands without a key
+bool IsReadOnlyCommand(const commands_args_t& argv);          // may be served by a replica
+
+// cluster wide SCAN state, one server cursor per master that is not finished yet
+typedef std::vector<std::pair<common::net::HostAndPort, cursor_t::position_t>> node_cursors_t;
+cursor_t MakeClusterCursor(const node_cursors_t& nodes);  // cursor_t() when nodes is empty
+bool ParseClusterCursor(const cursor_t& cursor, node_cursors_t* nodes) WARN_UNUSED_RESULT;
+
+// slot map of a redis cluster plus one lazily opened context per node,
+// keyed commands go to the owner of their slot and MOVED/ASK are followed transparently;
+// with config.read_from read only commands go to a replica of that owner,
+// a plain master with replicas is handled as a cluster of one shard
+class ClusterRouter {
+ public:
+  typedef std::function<common::Error(size_t index, redisReply* reply)> reply_callback_t;
+
+  // config and ssh of the seed node, nodes are reached with the same auth and tunnel
+  ClusterRouter(const Config& config, const SSHInfo& sinfo);
+  ~ClusterRouter();
+
+  // CLUSTER SLOTS through the seed context (not owned), fails on servers without cluster support
+  common::Error LoadSlots(redisContext* seed) WARN_UNUSED_RESULT;
+  // ROLE through the seed context (not owned), fails when the seed is not a master with replicas
+  common::Error LoadReplicas(redisContext* seed) WARN_UNUSED_RESULT;
+  bool IsCluster() const;
+  void SelectDB(int num);  // replicas of a plain master follow SELECT on reconnect
+
+  // keyless commands go to the seed
+  common::Error ExecCommand(const commands_args_t& argv, redisReply** out_reply) WARN_UNUSED_RESULT;
+  // same as ExecCommand, but the command is known to be read only (e.g. a script without writes)
+  common::Error ExecReadCommand(const commands_args_t& argv, redisReply** out_reply) WARN_UNUSED_RESULT;
+  // pipelined per node, redirected replies are resent one by one, on_reply gets them in no particular order;
+  // reads of a replica that fails are finished on its primary
+  common::Error ExecPipeline(const std::vector<commands_args_t>& cmds,
+                             size_t window,
+                             reply_callback_t on_reply) WARN_UNUSED_RESULT;
+
+  // cmds[i] goes to hosts[i], all are written before the first reply is read so nodes work in parallel,
+  // every reply is read even after an error
+  common::Error ExecOnNodes(const std::vector<common::net::HostAndPort>& hosts,
+                            const std::vector<commands_args_t>& cmds,
+                            reply_callback_t on_reply) WARN_UNUSED_RESULT;
+
+  std::vector<common::net::HostAndPort> GetMasters() const;
+  size_t GetMastersCount() const;
+  std::vector<common::net::HostAndPort> GetReadNodes();  // one node per shard, chosen by config.read_from
+  common::net::HostAndPort GetSlotMaster(uint16_t slot) const;
+
+ private:
+  enum { max_redirects = 16 };
+
+  struct Node {
+    common::net::HostAndPort host;
+    redisContext* context;         // nullptr until first use
+    bool is_replica;
+    uint64_t latency_us;           // round trip, smoothed
+    std::vector<size_t> replicas;  // indexes in nodes_, for masters
+  };
+
+  struct SlotRange {
+    uint16_t start;
+    uint16_t end;
+    size_t master;                 // index in nodes_
+    std::vector<size_t> replicas;  // indexes in nodes_
+  };
+
+  size_t FindOrAddNode(const common::net::HostAndPort& host);
+  common::Error GetNodeContext(size_t node, redisContext** context) WARN_UNUSED_RESULT;
+  size_t GetNodeForArgs(const commands_args_t& argv, bool read_only);
+  size_t PickReadNode(size_t master);
+  void UpdateLatency(size_t node, uint64_t latency_us);
+  common::Error ExecCommandImpl(const commands_args_t& argv, bool read_only, redisReply** out_reply) WARN_UNUSED_RESULT;
+  void UpdateReplicas();
+  void DropReplica(size_t node);
+  common::Error RefreshSlots() WARN_UNUSED_RESULT;
+  bool RefreshAfterFailure();  // after an i/o error on a node, true when the slot map could be reloaded
+  // replies of contexts[from, to) are never read, node contexts are closed and the seed is drained
+  void DiscardPending(const std::vector<size_t>& nodes,
+                      const std::vector<redisContext*>& contexts,
+                      size_t from,
+                      size_t to);
+
+  Config config_;
+  const SSHInfo sinfo_;
+  redisContext* seed_;
+  bool is_cluster_;
+  size_t next_replica_;  // round robin position
+  std::vector<Node> nodes_;
+  std::vector<SlotRange> ranges_;
+  std::vector<size_t> slots_;  // slot -> index in nodes_, npos when uncovered
+
+  DISALLOW_COPY_AND_ASSIGN(ClusterRouter);
+};
+
+}  // namespace redis_compatible
+}  // namespace core
+}  // namespace fastonosql
@@ -45,6 +45,7 @@ class CommandTranslator : public ICommandTranslator {
   common::Error Smembers(const NKey& key, command_buffer_t* cmdstring) WARN_UNUSED_RESULT;
 
   common::Error Lrange(const NKey& key, int start, int stop, command_buffer_t* cmdstring) WARN_UNUSED_RESULT;
+  common::Error Lrange(const NKey& key, int start, int stop, commands_args_t* argv) WARN_UNUSED_RESULT;
 
   common::Error Append(const NKey& key, const NValue& value, command_buffer_t* cmdstring);
 
@@ -71,11 +72,20 @@ class CommandTranslator : public ICommandTranslator {
   common::Error Hmset(const NKey& key, const NValue& hash, command_buffer_t* cmdstring) const WARN_UNUSED_RESULT;
 
   common::Error Unlink(const NKey& key, command_buffer_t* cmdstring) WARN_UNUSED_RESULT;
+  common::Error Unlink(const NKey& key, commands_args_t* argv) WARN_UNUSED_RESULT;
 
   // zset
   common::Error ZpopMax(const NKey& key, size_t count, command_buffer_t* cmdstring) WARN_UNUSED_RESULT;
   common::Error ZpopMin(const NKey& key, size_t count, command_buffer_t* cmdstring) WARN_UNUSED_RESULT;
 
+  // paged collections: LLEN/SCARD/HLEN/ZCARD and SSCAN/HSCAN/ZSCAN, type is one of array, set, hash, zset
+  common::Error CollectionSize(const NKey& key, common::Value::Type type, commands_args_t* argv) WARN_UNUSED_RESULT;
+  common::Error CollectionScan(const NKey& key,
+                               common::Value::Type type,
+                               cursor_t::position_t cursor,
+                               keys_limit_t count,
+                               commands_args_t* argv) WARN_UNUSED_RESULT;
+
  private:
   common::Error CreateKeyCommandImpl(const NDbKValue& key, command_buffer_t* cmdstring) const override;
   common::Error LoadKeyCommandImpl(const NKey& key,
@@ -88,6 +98,15 @@ class CommandTranslator : public ICommandTranslator {
   common::Error ChangeKeyTTLCommandImpl(const NKey& key, ttl_t ttl, command_buffer_t* cmdstring) const override;
   common::Error LoadKeyTTLCommandImpl(const NKey& key, command_buffer_t* cmdstring) const override;
 
+  common::Error CreateKeyCommandArgsImpl(const NDbKValue& key, commands_args_t* argv) const override;
+  common::Error LoadKeyCommandArgsImpl(const NKey& key, common::Value::Type type, commands_args_t* argv) const override;
+  common::Error DeleteKeyCommandArgsImpl(const NKey& key, commands_args_t* argv) const override;
+  common::Error RenameKeyCommandArgsImpl(const NKey& key,
+                                         const trans_key_t& new_name,
+                                         commands_args_t* argv) const override;
+  common::Error ChangeKeyTTLCommandArgsImpl(const NKey& key, ttl_t ttl, commands_args_t* argv) const override;
+  common::Error LoadKeyTTLCommandArgsImpl(const NKey& key, commands_args_t* argv) const override;
+
   bool IsLoadKeyCommandImpl(const CommandInfo& cmd) const override;
 
   common::Error PublishCommandImpl(const trans_ps_channel_t& channel,
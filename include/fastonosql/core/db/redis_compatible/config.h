@@ -30,6 +30,8 @@ struct Config : public RemoteConfig {
   typedef RemoteConfig base_class;
 
   enum { kDefaultDbNum = 0 };
+  // where read only commands go when the server has replicas
+  enum ReadFrom { READ_FROM_MASTER = 0, READ_FROM_REPLICA_ROUND_ROBIN = 1, READ_FROM_REPLICA_LEAST_LATENCY = 2 };
   explicit Config(const common::net::HostAndPort& host);
   Config();
 
@@ -42,6 +44,9 @@ struct Config : public RemoteConfig {
   int db_num;
   std::string auth;
   bool is_ssl;
+  ReadFrom read_from;
+  std::string sentinel_master;  // when set host is a sentinel and the master with this name is used
+  int near_cache_size;          // max keys kept on the client with CLIENT TRACKING, 0 disables
 };
 
 inline bool operator==(const Config& r, const Config& l) {
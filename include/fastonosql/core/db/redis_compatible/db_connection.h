@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <functional>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -26,6 +28,7 @@
 #include <fastonosql/core/cdb_connection.h>
 
 #include <fastonosql/core/db/redis_compatible/config.h>
+#include <fastonosql/core/db/redis_compatible/resp_reader.h>
 
 #include <fastonosql/core/global.h>
 #include <fastonosql/core/ssh_info.h>
@@ -42,7 +45,10 @@ namespace fastonosql {
 namespace core {
 namespace redis_compatible {
 
+class ClusterRouter;
 class CommandTranslator;
+class NearCache;
+class SentinelWatcher;
 
 typedef redisContext NativeConnection;
 
@@ -50,12 +56,17 @@ bool ConvertFromString(const readable_string_t& value, common::Value::Type* out)
 bool ConvertFromType(common::Value::Type type, readable_string_t* out);
 
 const char* GetHiredisVersion();
+// error reply to SCRIPT LOAD/EVALSHA, anything but a transient one (BUSY, LOADING, OOM, ...) means scripts
+// will not work on this server (pika, forks without scripting, acl), the result is kept per connection
+bool IsScriptingUnavailableError(const std::string& description);
 
 common::Error CreateConnection(const Config& config, const SSHInfo& sinfo, NativeConnection** context);
 common::Error TestConnection(const Config& config, const SSHInfo& sinfo);
 
 common::Error PrintRedisContextError(NativeConnection* context);
 common::Error ValueFromReplay(redisReply* reply, common::Value** out);
+// string reply to string, array reply to list/set/hash/zset by type
+common::Error TypedValueFromReplay(redisReply* reply, common::Value::Type type, common::Value** out);
 common::Error ExecRedisCommand(NativeConnection* context,
                                size_t argc,
                                const char** argv,
@@ -63,6 +74,12 @@ common::Error ExecRedisCommand(NativeConnection* context,
                                redisReply** out_reply);
 common::Error ExecRedisCommand(NativeConnection* context, const commands_args_t& argv, redisReply** out_reply);
 common::Error ExecRedisCommand(NativeConnection* context, const command_buffer_t& command, redisReply** out_reply);
+// sends cmds in windows of at most window commands, each reply goes to on_reply in order and is freed after it
+typedef std::function<common::Error(size_t index, redisReply* reply)> pipeline_reply_callback_t;
+common::Error ExecRedisPipeline(NativeConnection* context,
+                                const std::vector<commands_args_t>& cmds,
+                                size_t window,
+                                pipeline_reply_callback_t on_reply);
 common::Error AuthContext(NativeConnection* context, const command_buffer_t& password);
 
 template <typename Config, ConnectionType connection_type>
@@ -74,6 +91,12 @@ class DBConnection : public CDBConnection<NativeConnection, Config, connection_t
   typedef typename base_class::config_t config_t;
 
   enum { invalid_db_num = -1 };
+  enum { pipeline_window = 1024 };  // max commands in flight for multi key operations
+  enum { collection_page_size = 1000 };  // default COUNT for paged collection reads
+  enum { large_collection_size = 10000 };  // bigger collections are loaded as their first page, see GetPartialLoad
+  enum { max_partial_loads = 1024 };
+
+  ~DBConnection() override;
 
   common::Error Connect(const config_t& config) override WARN_UNUSED_RESULT;
   common::Error Disconnect() override WARN_UNUSED_RESULT;
@@ -139,15 +162,64 @@ class DBConnection : public CDBConnection<NativeConnection, Config, connection_t
   common::Error DBSize(keys_limit_t* size) WARN_UNUSED_RESULT;
 
   common::Error ExecuteAsPipeline(const std::vector<FastoObjectCommandIPtr>& cmds,
-                                  void (*log_command_cb)(FastoObjectCommandIPtr)) WARN_UNUSED_RESULT;
+                                  void (*log_command_cb)(FastoObjectCommandIPtr),
+                                  size_t window = pipeline_window) WARN_UNUSED_RESULT;  // send window, read window
 
   IDataBaseInfo* MakeDatabaseInfo(const db_name_t& name, bool is_default, size_t size) const override;
 
   common::Error Unlink(const NKeys& keys, NKeys* deleted_keys) WARN_UNUSED_RESULT;
+  common::Error GetTTLMany(const NKeys& keys, std::vector<ttl_t>* ttls) WARN_UNUSED_RESULT;  // one pipeline
+
+  // paged reads of list, set, hash and zset keys (type as in common::Value), start with cursor_t(),
+  // finished when cursor_out IsFinished; the page may hold fewer or, for scans, a few more elements than asked
+  common::Error GetCollectionSize(const NKey& key, common::Value::Type type, size_t* size) WARN_UNUSED_RESULT;
+  common::Error GetCollectionPage(const NKey& key,
+                                  common::Value::Type type,
+                                  const cursor_t& cursor_in,
+                                  keys_limit_t page_size,
+                                  NValue* page,
+                                  cursor_t* cursor_out) WARN_UNUSED_RESULT;
+  // GetUni of a large collection loads only its first page, the next cursor and the total size are kept
+  // until the key is loaded again; false when the last load of key was complete
+  bool GetPartialLoad(const NKey& key, cursor_t* cursor_out, size_t* total) const;
 
  protected:
   DBConnection(CDBConnectionClient* client, ICommandTranslator* translator)
-      : base_class(client, translator), is_auth_(false), cur_db_(invalid_db_num) {}
+      : base_class(client, translator),
+        is_auth_(false),
+        cur_db_(invalid_db_num),
+        load_typed_value_sha_(),
+        is_scripting_supported_(true),
+        cluster_(nullptr),
+        sentinel_(nullptr),
+        near_cache_(nullptr),
+        partial_loads_() {}
+
+  // route through the cluster slot map when connected to a cluster node, otherwise to our own context
+  common::Error ExecCommand(const commands_args_t& argv, redisReply** out_reply) WARN_UNUSED_RESULT;
+  common::Error ExecCommand(const command_buffer_t& command, redisReply** out_reply) WARN_UNUSED_RESULT;
+  // known read only, may go to a replica with config read_from
+  common::Error ExecReadCommand(const commands_args_t& argv, redisReply** out_reply) WARN_UNUSED_RESULT;
+  common::Error ExecPipeline(const std::vector<commands_args_t>& cmds,
+                             size_t window,
+                             pipeline_reply_callback_t on_reply) WARN_UNUSED_RESULT;
+  // decodes the reply straight into values, with on_element the top level aggregate is streamed and out is nullptr
+  common::Error ExecCommandToValue(const commands_args_t& argv,
+                                   common::Value** out,
+                                   RespReader::element_callback_t on_element = RespReader::element_callback_t())
+      WARN_UNUSED_RESULT;
+  common::Error ExecCommandToValue(const command_buffer_t& command,
+                                   common::Value** out,
+                                   RespReader::element_callback_t on_element = RespReader::element_callback_t())
+      WARN_UNUSED_RESULT;
+  common::Error ExecReadCommandToValue(const commands_args_t& argv,
+                                       common::Value** out,
+                                       RespReader::element_callback_t on_element = RespReader::element_callback_t())
+      WARN_UNUSED_RESULT;
+  common::Error ExecPipelineToValues(const std::vector<commands_args_t>& cmds,
+                                     size_t window,
+                                     pipeline_value_callback_t on_value) WARN_UNUSED_RESULT;
+  bool IsClusterMode() const;
 
   common::Error CliFormatReplyRaw(FastoObject* out, redisReply* r) WARN_UNUSED_RESULT;
 
@@ -160,8 +232,22 @@ class DBConnection : public CDBConnection<NativeConnection, Config, connection_t
   common::Error GetTypeImpl(const NKey& key,
                             readable_string_t* type) override;  // TYPE works differently than in redis protocol
 
+  // type and value in one round trip through a cached script, loaded is false when the script is not available
+  // (type stays empty) or the type is not a core one (type is set, value is left to the caller)
+  common::Error LoadTypedValue(const NKey& key,
+                               readable_string_t* type,
+                               NDbKValue* loaded_key,
+                               bool* loaded) WARN_UNUSED_RESULT;
+  // list, set, hash and zset, a collection over large_collection_size is loaded as its first page
+  common::Error GetCollectionImpl(const NKey& key, common::Value::Type type, NDbKValue* loaded_key) WARN_UNUSED_RESULT;
+
  private:
-  common::Error ScanImpl(cursor_t cursor_in,
+  struct PartialLoad {
+    cursor_t cursor;
+    size_t total;
+  };
+
+  common::Error ScanImpl(const cursor_t& cursor_in,
                          const pattern_t& pattern,
                          keys_limit_t count_keys,
                          raw_keys_t* keys_out,
@@ -176,6 +262,7 @@ class DBConnection : public CDBConnection<NativeConnection, Config, connection_t
   common::Error DeleteImpl(const NKeys& keys, NKeys* deleted_keys) override;
   common::Error SetImpl(const NDbKValue& key) override;
   common::Error GetUniImpl(const NKey& key, NDbKValue* loaded_key) override;
+  common::Error GetUniManyImpl(const NKeys& keys, std::vector<NDbKValue>* loaded_keys) override;
   common::Error RenameImpl(const NKey& key, const nkey_t& new_key) override;
   common::Error SetTTLImpl(const NKey& key,
                            ttl_t ttl) override;  // EXPIRE works differently than in redis protocol
@@ -183,11 +270,54 @@ class DBConnection : public CDBConnection<NativeConnection, Config, connection_t
   common::Error QuitImpl() override;
   common::Error ConfigGetDatabasesImpl(db_names_t* dbs) override;
 
+  // per master cursors packed into one composite cursor, masters are scanned in parallel
+  common::Error ClusterScan(const cursor_t& cursor_in,
+                            const pattern_t& pattern,
+                            keys_limit_t count_keys,
+                            raw_keys_t* keys_out,
+                            cursor_t* cursor_out) WARN_UNUSED_RESULT;
   common::Error CliReadReply(FastoObject* out) WARN_UNUSED_RESULT;
-  common::Error SendSync(unsigned long long* payload) WARN_UNUSED_RESULT;
+  // MONITOR, SUBSCRIBE and replication feeds through a bounded ring, one child per message until interrupted
+  common::Error ListenStream(FastoObject* out) WARN_UNUSED_RESULT;
+  common::Error SendSync(unsigned long long* payload, std::string* eof_mark) WARN_UNUSED_RESULT;
+  common::Error ExecCommandToValueImpl(const commands_args_t& argv,
+                                       bool read_only,
+                                       common::Value** out,
+                                       RespReader::element_callback_t on_element) WARN_UNUSED_RESULT;
+  // raw elements of one page (hash and zset as flat pairs), items is owned by the caller
+  common::Error ReadCollectionPage(const NKey& key,
+                                   common::Value::Type type,
+                                   const cursor_t& cursor_in,
+                                   keys_limit_t page_size,
+                                   common::ArrayValue** items,
+                                   cursor_t* cursor_out) WARN_UNUSED_RESULT;
+  common::Error LoadCollectionFirstPage(const NKey& key,
+                                        common::Value::Type type,
+                                        size_t total,
+                                        NDbKValue* loaded_key) WARN_UNUSED_RESULT;
+  common::Error LoadTTLMany(const NKeys& keys, std::vector<ttl_t>* ttls) WARN_UNUSED_RESULT;
+  common::Error LoadTypedValueScript() WARN_UNUSED_RESULT;
+  common::Error LoadTypedValueImpl(const NKey& key,
+                                   readable_string_t* type,
+                                   NDbKValue* loaded_key,
+                                   bool* loaded) WARN_UNUSED_RESULT;
+  NearCache* GetNearCache();  // nullptr when disabled, applies pending invalidations
+  void InvalidateWrittenKey(const commands_args_t& argv);
+  void InvalidateWrittenKey(const command_args_views_t& argv);  // console lines, copies only with a near cache
+
+  common::Error ConnectToServer(const config_t& config) WARN_UNUSED_RESULT;
+  common::Error DisconnectFromServer() WARN_UNUSED_RESULT;
+  // reconnects to the new master after +switch-master or an i/o error, checked before every command
+  common::Error CheckFailover() WARN_UNUSED_RESULT;
 
   bool is_auth_;
   int cur_db_;
+  command_buffer_t load_typed_value_sha_;
+  bool is_scripting_supported_;  // false for servers without EVALSHA (pika, dynomite, scripting disabled)
+  ClusterRouter* cluster_;       // nullptr unless a cluster node or a master with replicas to read from
+  SentinelWatcher* sentinel_;    // nullptr unless config sentinel_master is set
+  NearCache* near_cache_;        // nullptr unless config near_cache_size is set and tracking works
+  std::map<std::string, PartialLoad> partial_loads_;  // by raw key, at most max_partial_loads
 };
 
 }  // namespace redis_compatible
@@ -0,0 +1,64 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+#include <common/value.h>
+
+namespace fastonosql {
+namespace core {
+namespace redis_compatible {
+
+// fixed size single producer, single consumer queue of stream messages (MONITOR, SUBSCRIBE, replication),
+// lock free so producer and consumer may live on different threads,
+// past the high watermark only every sample_rate-th message is kept, a full ring drops
+class MessageRing {
+ public:
+  enum { default_capacity = 4096, sample_rate = 8 };
+
+  explicit MessageRing(size_t capacity = default_capacity);
+  ~MessageRing();
+
+  // producer side, takes ownership, the message is deleted when dropped
+  bool Push(common::Value* message);
+  // consumer side, appends at most max_count messages to batch, ownership goes to the caller
+  size_t PopBatch(size_t max_count, std::vector<common::Value*>* batch);
+
+  size_t GetSize() const;
+  size_t GetCapacity() const;
+  uint64_t GetReceivedCount() const;
+  uint64_t GetDroppedCount() const;
+
+ private:
+  std::vector<common::Value*> slots_;
+  std::atomic<size_t> head_;  // next to pop, written by the consumer
+  std::atomic<size_t> tail_;  // next to push, written by the producer
+  std::atomic<uint64_t> received_;
+  std::atomic<uint64_t> dropped_;
+
+  DISALLOW_COPY_AND_ASSIGN(MessageRing);
+};
+
+}  // namespace redis_compatible
+}  // namespace core
+}  // namespace fastonosql
@@ -0,0 +1,90 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include <fastonosql/core/db_key.h>
+#include <fastonosql/core/ssh_info.h>
+
+#include <fastonosql/core/db/redis_compatible/config.h>
+
+struct redisContext;
+
+namespace fastonosql {
+namespace core {
+namespace redis_compatible {
+
+// bounded LRU of recently read keys kept coherent by CLIENT TRACKING,
+// invalidations arrive on a second context (RESP2 REDIRECT) that is drained without blocking by Poll
+class NearCache {
+ public:
+  NearCache(const Config& config, const SSHInfo& sinfo, size_t max_keys);
+  ~NearCache();
+
+  // opens the invalidation context and turns tracking on for the data context (not owned)
+  common::Error Start(redisContext* data) WARN_UNUSED_RESULT;
+  common::Error Poll() WARN_UNUSED_RESULT;  // applies pending invalidations, drops everything on failure
+
+  bool GetValue(const NKey& key, NDbKValue* value);
+  bool GetType(const NKey& key, readable_string_t* type);
+  bool GetTTL(const NKey& key, ttl_t* ttl);  // counted down since it was loaded
+
+  void SetValue(const NDbKValue& value, const readable_string_t& type);
+  void SetType(const NKey& key, const readable_string_t& type);
+  void SetTTL(const NKey& key, ttl_t ttl);
+
+  void Invalidate(const command_buffer_t& key);
+  void Clear();
+  size_t GetSize() const;
+
+ private:
+  struct Entry {
+    Entry();
+
+    std::string key;
+    readable_string_t type;  // empty when unknown
+    bool has_value;
+    NDbKValue value;
+    bool has_ttl;
+    ttl_t ttl;
+    std::chrono::steady_clock::time_point ttl_loaded;
+  };
+  typedef std::list<Entry> entries_t;
+
+  Entry* Find(const NKey& key);  // moves the entry to the front
+  Entry* FindOrAdd(const NKey& key);
+  void Stop();
+
+  const Config config_;
+  const SSHInfo sinfo_;
+  const size_t max_keys_;
+  redisContext* invalidations_;
+  entries_t entries_;  // most recently used first
+  std::unordered_map<std::string, entries_t::iterator> index_;
+
+  DISALLOW_COPY_AND_ASSIGN(NearCache);
+};
+
+}  // namespace redis_compatible
+}  // namespace core
+}  // namespace fastonosql
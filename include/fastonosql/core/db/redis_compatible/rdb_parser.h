@@ -0,0 +1,86 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <vector>
+
+#include <fastonosql/core/db_key.h>
+
+namespace fastonosql {
+namespace core {
+namespace redis_compatible {
+
+// streaming parser of RDB snapshots (SYNC/PSYNC payloads, dump files), pulls bytes through a callback
+// and hands out keys one by one, only the value being decoded is kept in memory,
+// compact encodings (zipmap, ziplist, listpack, intset, quicklist) are expanded into plain values,
+// streams and hashes with field expiry are skipped
+class RdbParser {
+ public:
+  // reads at most size bytes into buf, nread is zero only when nothing arrived yet
+  typedef std::function<common::Error(char* buf, size_t size, size_t* nread)> read_callback_t;
+  // value ownership goes to the callee, key ttl is in seconds from now, expired keys are not reported
+  typedef std::function<void(int db_num, const NKey& key, common::Value* value)> key_callback_t;
+
+  enum { buffer_size = 16 * 1024 };
+
+  RdbParser(read_callback_t reader, key_callback_t on_key);
+
+  // reads up to and including the EOF opcode and its checksum
+  common::Error Parse() WARN_UNUSED_RESULT;
+
+  // bytes read ahead past the end of the snapshot, belong to whatever follows it
+  std::vector<char> GetUnconsumed() const;
+
+  int GetVersion() const;
+  uint64_t GetKeysCount() const;
+  uint64_t GetSkippedKeysCount() const;  // expired, module, stream and field expiry hash keys
+  // Parse failed on something it cannot skip, the rest of the payload is left unread
+  bool IsStoppedOnUnsupported() const;
+
+ private:
+  common::Error Read(void* out, size_t size) WARN_UNUSED_RESULT;
+  common::Error ReadByte(uint8_t* out) WARN_UNUSED_RESULT;
+  common::Error ReadLength(uint64_t* len, bool* is_encoded = nullptr) WARN_UNUSED_RESULT;
+  common::Error ReadString(common::Value::string_t* out) WARN_UNUSED_RESULT;
+  common::Error ReadScore(bool is_binary, common::Value::string_t* out) WARN_UNUSED_RESULT;
+  common::Error ReadValue(uint8_t type, common::Value** out) WARN_UNUSED_RESULT;
+  common::Error SkipModuleValue() WARN_UNUSED_RESULT;
+  common::Error SkipStreamValue(uint8_t type) WARN_UNUSED_RESULT;
+  common::Error SkipHashWithFieldsTTL(uint8_t type) WARN_UNUSED_RESULT;
+  common::Error SkipLengths(size_t count) WARN_UNUSED_RESULT;
+
+  read_callback_t reader_;
+  key_callback_t on_key_;
+  std::vector<char> buf_;
+  size_t pos_;
+  size_t end_;
+  int version_;
+  uint64_t keys_count_;
+  uint64_t skipped_keys_count_;
+  bool is_unsupported_;
+
+  DISALLOW_COPY_AND_ASSIGN(RdbParser);
+};
+
+}  // namespace redis_compatible
+}  // namespace core
+}  // namespace fastonosql
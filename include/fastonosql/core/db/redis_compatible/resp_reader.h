@@ -0,0 +1,94 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <common/value.h>
+
+#include <fastonosql/core/basic_types.h>
+
+struct redisContext;
+
+namespace fastonosql {
+namespace core {
+namespace redis_compatible {
+
+// incremental RESP2/RESP3 parser that builds common::Value trees straight from the received bytes,
+// maps become flat key/value arrays like RESP2 HGETALL, attributes are skipped,
+// an error anywhere in the reply fails the whole reply once it is fully read
+class RespReader {
+ public:
+  // elements of the top level aggregate, ownership goes to the callee and nothing is kept in the reader
+  typedef std::function<void(size_t index, common::Value* element)> element_callback_t;
+
+  enum { max_depth = 64 };
+
+  explicit RespReader(element_callback_t on_element = element_callback_t());
+  ~RespReader();
+
+  void Feed(const char* buf, size_t len);
+
+  // complete is false while more input is needed, out is nullptr for a streamed aggregate
+  common::Error GetReply(common::Value** out, bool* complete) WARN_UNUSED_RESULT;
+
+ private:
+  struct Frame {
+    common::ArrayValue* array;  // nullptr for streamed or skipped aggregates
+    int64_t remaining;
+    size_t index;
+    bool is_streamed;
+    bool is_skipped;  // attributes
+  };
+
+  enum ParseResult { PARSE_MORE, PARSE_VALUE, PARSE_AGGREGATE };
+
+  ParseResult ParseOne(common::Value** value, common::Error* err);
+  bool Emit(common::Value* value, common::Value** out);  // true when the top level reply is complete
+  bool FindLine(size_t from, size_t* end) const;
+  void Reset();
+
+  element_callback_t on_element_;
+  std::vector<char> buf_;
+  size_t pos_;
+  std::vector<Frame> stack_;
+  common::Error reply_err_;
+
+  DISALLOW_COPY_AND_ASSIGN(RespReader);
+};
+
+// sends argv and decodes the reply with RespReader, the context must have no replies pending
+common::Error ExecRedisCommandToValue(redisContext* context,
+                                      const commands_args_t& argv,
+                                      common::Value** out,
+                                      RespReader::element_callback_t on_element = RespReader::element_callback_t())
+    WARN_UNUSED_RESULT;
+
+// sends cmds in windows of at most window commands and decodes each reply with one RespReader,
+// every value goes to on_value in order and is owned by the callee
+typedef std::function<common::Error(size_t index, common::Value* value)> pipeline_value_callback_t;
+common::Error ExecRedisPipelineToValues(redisContext* context,
+                                        const std::vector<commands_args_t>& cmds,
+                                        size_t window,
+                                        pipeline_value_callback_t on_value) WARN_UNUSED_RESULT;
+
+}  // namespace redis_compatible
+}  // namespace core
+}  // namespace fastonosql
@@ -0,0 +1,74 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include <common/net/types.h>
+
+#include <fastonosql/core/ssh_info.h>
+
+#include <fastonosql/core/db/redis_compatible/config.h>
+
+struct redisContext;
+
+namespace fastonosql {
+namespace core {
+namespace redis_compatible {
+
+// SENTINEL get-master-addr-by-name
+common::Error GetSentinelMaster(redisContext* sentinel, const std::string& name, common::net::HostAndPort* master)
+    WARN_UNUSED_RESULT;
+
+// resolves config.sentinel_master through the sentinel at config.host and keeps the address,
+// a second context stays subscribed to +switch-master and is drained without blocking by Poll,
+// a lost subscription is restored by Poll with a growing delay between attempts
+class SentinelWatcher {
+ public:
+  SentinelWatcher(const Config& config, const SSHInfo& sinfo);
+  ~SentinelWatcher();
+
+  common::Error Start(common::net::HostAndPort* master) WARN_UNUSED_RESULT;
+  common::Error Resolve(common::net::HostAndPort* master) WARN_UNUSED_RESULT;  // ask the sentinel again
+  common::Error Poll(bool* switched) WARN_UNUSED_RESULT;  // switched when a failover moved our master
+
+  common::net::HostAndPort GetMaster() const;
+
+ private:
+  common::Error OpenContext(redisContext** context) WARN_UNUSED_RESULT;
+  common::Error Subscribe() WARN_UNUSED_RESULT;
+  common::Error Resubscribe(bool* switched) WARN_UNUSED_RESULT;
+  void DropSubscriber();  // retried on the next Poll
+  void Stop();
+
+  const Config config_;
+  const SSHInfo sinfo_;
+  redisContext* query_;
+  redisContext* subscriber_;
+  common::net::HostAndPort master_;
+  std::chrono::steady_clock::time_point next_subscribe_;
+  std::chrono::milliseconds subscribe_backoff_;
+
+  DISALLOW_COPY_AND_ASSIGN(SentinelWatcher);
+};
+
+}  // namespace redis_compatible
+}  // namespace core
+}  // namespace fastonosql
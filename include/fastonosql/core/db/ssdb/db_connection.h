@@ -136,7 +136,7 @@ class DBConnection : public CDBConnection<NativeConnection, Config, SSDB> {
   common::Error DelInner(const raw_key_t& key) WARN_UNUSED_RESULT;
 
   common::Error ConfigGetDatabasesImpl(db_names_t* dbs) override;
-  common::Error ScanImpl(cursor_t cursor_in,
+  common::Error ScanImpl(const cursor_t& cursor_in,
                          const pattern_t& pattern,
                          keys_limit_t count_keys,
                          raw_keys_t* keys_out,
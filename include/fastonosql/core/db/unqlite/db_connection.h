@@ -54,7 +54,7 @@ class DBConnection : public CDBConnection<NativeConnection, Config, UNQLITE> {
   common::Error SetInner(const raw_key_t& key, const raw_value_t& value) WARN_UNUSED_RESULT;
   common::Error GetInner(const raw_key_t& key, raw_value_t* ret_val) WARN_UNUSED_RESULT;
 
-  common::Error ScanImpl(cursor_t cursor_in,
+  common::Error ScanImpl(const cursor_t& cursor_in,
                          const pattern_t& pattern,
                          keys_limit_t count_keys,
                          raw_keys_t* keys_out,
@@ -64,6 +64,7 @@ class DBConnection : public CDBConnection<NativeConnection, Config, UNQLITE> {
                          keys_limit_t limit,
                          raw_keys_t* out) override;
   common::Error DBKeysCountImpl(keys_limit_t* size) override;
+  common::Error ApproximateDBKeysCountImpl(keys_limit_t* size) override;
   common::Error FlushDBImpl() override;
   common::Error SelectImpl(const db_name_t& name, IDataBaseInfo** info) override;
   common::Error DeleteImpl(const NKeys& keys, NKeys* deleted_keys) override;
@@ -62,6 +62,7 @@ class FastoObject : public common::intrusive_ptr_base<FastoObject> {
 
   childs_t GetChildrens() const;
   void AddChildren(child_t child);
+  void TrimChildrens(size_t keep);  // forget all but the last keep childrens, observers already have them
   FastoObject* GetParent() const;
   void Clear();
   std::string GetDelimiter() const;
@@ -19,6 +19,8 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include <fastonosql/core/command_holder.h>
@@ -32,6 +34,8 @@
 #define DB_DBKCOUNT_COMMAND "DBKCOUNT"  // exist for all
 #define DB_QUIT_COMMAND "QUIT"          // exist for all
 
+#define DB_DBKCOUNT_APPROX_ARG "APPROX"
+
 #define DB_CSVDUMP_COMMAND "DUMPTOCSVFILE"    // exist for all
 #define DB_JSONDUMP_COMMAND "DUMPTOJSONFILE"  // exist for all
 #define DB_STORE_VALUE_COMMAND "DUMPTOFILE"   // exist for all
@@ -53,6 +57,7 @@
 #define DB_DELETE_KEY_COMMAND "DEL"     // exist for all
 #define DB_RENAME_KEY_COMMAND "RENAME"  // exist for all
 #define DB_KEYS_COMMAND "KEYS"          // exist for all
+#define DB_REVERSE_KEYS_COMMAND "RKEYS"
 #define DB_SCAN_COMMAND "SCAN"          // exist for all
 
 #define DB_GET_CONFIG_COMMAND "CONFIG GET"
@@ -61,7 +66,7 @@
 namespace fastonosql {
 namespace core {
 
-command_buffer_t GetKeysPattern(cursor_t cursor_in, const pattern_t& pattern,
+command_buffer_t GetKeysPattern(const cursor_t& cursor_in, const pattern_t& pattern,
                                 keys_limit_t count_keys);  // for SCAN
 
 class ICommandTranslator {
@@ -92,9 +97,22 @@ class ICommandTranslator {
   common::Error ChangeKeyTTLCommand(const NKey& key, ttl_t ttl, command_buffer_t* cmdstring) const WARN_UNUSED_RESULT;
   common::Error LoadKeyTTLCommand(const NKey& key, command_buffer_t* cmdstring) const WARN_UNUSED_RESULT;
 
+  // argv variants, raw bytes per argument without escaping
+  common::Error CreateKeyCommand(const NDbKValue& key, commands_args_t* argv) const WARN_UNUSED_RESULT;
+  common::Error LoadKeyCommand(const NKey& key,
+                               common::Value::Type type,
+                               commands_args_t* argv) const WARN_UNUSED_RESULT;
+  common::Error DeleteKeyCommand(const NKey& key, commands_args_t* argv) const WARN_UNUSED_RESULT;
+  common::Error RenameKeyCommand(const NKey& key,
+                                 const trans_key_t& new_name,
+                                 commands_args_t* argv) const WARN_UNUSED_RESULT;
+  common::Error ChangeKeyTTLCommand(const NKey& key, ttl_t ttl, commands_args_t* argv) const WARN_UNUSED_RESULT;
+  common::Error LoadKeyTTLCommand(const NKey& key, commands_args_t* argv) const WARN_UNUSED_RESULT;
+
   bool IsLoadKeyCommand(const command_buffer_t& cmd, command_buffer_t* key) const WARN_UNUSED_RESULT;
 
   common::Error GetTypeCommand(const NKey& key, command_buffer_t* cmdstring) const WARN_UNUSED_RESULT;
+  common::Error GetTypeCommand(const NKey& key, commands_args_t* argv) const WARN_UNUSED_RESULT;
 
   common::Error PublishCommand(const trans_ps_channel_t& channel,
                                const std::string& message,
@@ -110,13 +128,13 @@ class ICommandTranslator {
                             const CommandHolder** info,
                             commands_args_t* argv = nullptr,
                             size_t* off = nullptr) const WARN_UNUSED_RESULT;
-  common::Error FindCommand(commands_args_t argv,
+  common::Error FindCommand(const commands_args_t& argv,
                             const CommandHolder** info,
                             size_t* off = nullptr) const WARN_UNUSED_RESULT;
 
-  common::Error TestCommandArgs(const CommandHolder* cmd, commands_args_t argv) const WARN_UNUSED_RESULT;
+  common::Error TestCommandArgs(const CommandHolder* cmd, const command_args_views_t& argv) const WARN_UNUSED_RESULT;
   common::Error TestCommandLine(const command_buffer_t& cmd) const WARN_UNUSED_RESULT;
-  common::Error TestCommandLineArgs(commands_args_t argv,
+  common::Error TestCommandLineArgs(const commands_args_t& argv,
                                     const CommandHolder** info,
                                     size_t* off) const WARN_UNUSED_RESULT;
 
@@ -136,6 +154,17 @@ class ICommandTranslator {
                                              command_buffer_t* cmdstring) const = 0;
   virtual common::Error ChangeKeyTTLCommandImpl(const NKey& key, ttl_t ttl, command_buffer_t* cmdstring) const = 0;
   virtual common::Error LoadKeyTTLCommandImpl(const NKey& key, command_buffer_t* cmdstring) const = 0;
+
+  // default argv impls parse the command line, translators should override them
+  virtual common::Error CreateKeyCommandArgsImpl(const NDbKValue& key, commands_args_t* argv) const;
+  virtual common::Error LoadKeyCommandArgsImpl(const NKey& key, common::Value::Type type, commands_args_t* argv) const;
+  virtual common::Error DeleteKeyCommandArgsImpl(const NKey& key, commands_args_t* argv) const;
+  virtual common::Error RenameKeyCommandArgsImpl(const NKey& key,
+                                                 const trans_key_t& new_name,
+                                                 commands_args_t* argv) const;
+  virtual common::Error ChangeKeyTTLCommandArgsImpl(const NKey& key, ttl_t ttl, commands_args_t* argv) const;
+  virtual common::Error LoadKeyTTLCommandArgsImpl(const NKey& key, commands_args_t* argv) const;
+
   virtual common::Error PublishCommandImpl(const trans_ps_channel_t& channel,
                                            const std::string& message,
                                            command_buffer_t* cmdstring) const = 0;
@@ -143,7 +172,21 @@ class ICommandTranslator {
 
   virtual bool IsLoadKeyCommandImpl(const CommandInfo& cmd) const = 0;
 
+  // case insensitive, keys are views into commands_ names
+  struct CommandNameHash {
+    size_t operator()(std::string_view name) const;
+  };
+  struct CommandNameEqual {
+    bool operator()(std::string_view lhs, std::string_view rhs) const;
+  };
+  typedef std::unordered_map<std::string_view, size_t, CommandNameHash, CommandNameEqual> commands_index_t;
+
   const std::vector<CommandHolder> commands_;
+  commands_index_t names_index_;        // full name -> first position in commands_
+  commands_index_t first_names_index_;  // first word -> first position in commands_
+  size_t max_name_words_;
+
+  DISALLOW_COPY_AND_ASSIGN(ICommandTranslator);
 };
 
 typedef std::shared_ptr<ICommandTranslator> translator_t;
@@ -27,6 +27,8 @@ namespace fastonosql {
 namespace core {
 
 bool ParseCommandLine(const command_buffer_t& command_line, commands_args_t* out);
+// views point into command_line, or into unescaped for arguments that needed decoding
+bool ParseCommandLine(const command_buffer_t& command_line, command_args_views_t* out, commands_args_t* unescaped);
 
 namespace detail {
 bool is_binary_data(const readable_string_t& data);
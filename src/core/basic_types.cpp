@@ -18,17 +18,201 @@
 
 #include <fastonosql/core/basic_types.h>
 
-#include <common/string_util.h>
+#include <algorithm>
+
+#include <common/convert2string.h>
+#include <common/utils.h>
 
 namespace fastonosql {
 namespace core {
 
-bool IsKeyMatchPattern(const char* data, size_t size, const pattern_t& pattern) {
+ScanCursor::ScanCursor() : position_(0), token_() {}
+
+ScanCursor::ScanCursor(position_t position) : position_(position), token_() {}
+
+ScanCursor::ScanCursor(position_t position, const token_t& token) : position_(position), token_(token) {}
+
+bool ScanCursor::IsFinished() const {
+  return position_ == 0 && token_.empty();
+}
+
+ScanCursor::position_t ScanCursor::GetPosition() const {
+  return position_;
+}
+
+ScanCursor::token_t ScanCursor::GetToken() const {
+  return token_;
+}
+
+bool ScanCursor::HasToken() const {
+  return !token_.empty();
+}
+
+bool ScanCursor::Equals(const ScanCursor& other) const {
+  return position_ == other.position_ && token_ == other.token_;
+}
+
+readable_string_t ScanCursor::ToString() const {
+  command_buffer_writer_t wr;
+  wr << common::ConvertToBytes(position_);
+  if (!token_.empty()) {
+    readable_string_t hexed;
+    bool is_ok = common::utils::hex::encode(token_, true, &hexed);
+    DCHECK(is_ok) << "Can't hexed: " << token_;
+    wr << ":" << hexed;
+  }
+  return wr.str();
+}
+
+bool ScanCursor::FromString(const readable_string_t& str, ScanCursor* out) {
+  if (str.empty() || !out) {
+    return false;
+  }
+
+  const auto delem = std::find(str.begin(), str.end(), ':');
+  position_t position;
+  if (!common::ConvertFromBytes(readable_string_t(str.begin(), delem), &position)) {
+    return false;
+  }
+
+  token_t token;
+  if (delem != str.end()) {
+    const readable_string_t hexed(delem + 1, str.end());
+    if (hexed.empty() || !common::utils::hex::decode(hexed, &token)) {
+      return false;
+    }
+  }
+
+  *out = ScanCursor(position, token);
+  return true;
+}
+
+ScanPattern::ScanPattern(const pattern_t& pattern)
+    : prefix_(), nodes_(), char_classes_(), is_match_all_(false) {
+  std::vector<Node> nodes;
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    const unsigned char ch = pattern[i];
+    if (ch == '*') {
+      if (nodes.empty() || nodes.back().type != NODE_ANY_SEQUENCE) {
+        nodes.push_back({NODE_ANY_SEQUENCE, 0, 0});
+      }
+    } else if (ch == '?') {
+      nodes.push_back({NODE_ANY_CHAR, 0, 0});
+    } else if (ch == '[') {
+      char_class_t char_class;
+      bool is_negative = false;
+      i++;
+      if (i < pattern.size() && pattern[i] == '^') {
+        is_negative = true;
+        i++;
+      }
+      for (; i < pattern.size() && pattern[i] != ']'; ++i) {  // not closed class lasts till the end, like redis
+        unsigned char start = pattern[i];
+        if (start == '\\' && i + 1 < pattern.size()) {
+          char_class.set(static_cast<unsigned char>(pattern[++i]));
+        } else if (i + 2 < pattern.size() && pattern[i + 1] == '-') {
+          unsigned char end = pattern[i + 2];
+          if (start > end) {
+            std::swap(start, end);
+          }
+          for (unsigned c = start; c <= end; ++c) {
+            char_class.set(c);
+          }
+          i += 2;
+        } else {
+          char_class.set(start);
+        }
+      }
+      if (is_negative) {
+        char_class.flip();
+      }
+      nodes.push_back({NODE_CHAR_CLASS, 0, char_classes_.size()});
+      char_classes_.push_back(char_class);
+    } else if (ch == '\\' && i + 1 < pattern.size()) {
+      nodes.push_back({NODE_CHAR, static_cast<unsigned char>(pattern[++i]), 0});
+    } else {
+      nodes.push_back({NODE_CHAR, ch, 0});
+    }
+  }
+
+  auto it = nodes.begin();
+  for (; it != nodes.end() && it->type == NODE_CHAR; ++it) {
+    prefix_.push_back(static_cast<raw_key_t::value_type>(it->ch));
+  }
+  nodes_.assign(it, nodes.end());
+  is_match_all_ = prefix_.empty() && nodes_.size() == 1 && nodes_[0].type == NODE_ANY_SEQUENCE;
+}
+
+bool ScanPattern::IsMatchAll() const {
+  return is_match_all_;
+}
+
+const raw_key_t& ScanPattern::GetPrefix() const {
+  return prefix_;
+}
+
+bool ScanPattern::HasPrefix(const char* data, size_t size) const {
+  return size >= prefix_.size() && std::equal(prefix_.begin(), prefix_.end(), data);
+}
+
+bool ScanPattern::IsMatch(const char* data, size_t size) const {
   if (!data || size == 0) {
     return false;
   }
 
-  return common::MatchPattern(common::StringPiece(data, size), pattern);
+  if (is_match_all_) {
+    return true;
+  }
+
+  if (!HasPrefix(data, size)) {
+    return false;
+  }
+
+  // every node except * takes one char, so backtracking to the last * is enough
+  const size_t npos = nodes_.size();
+  size_t node = 0;
+  size_t pos = prefix_.size();
+  size_t star_node = npos;
+  size_t star_pos = 0;
+  while (pos < size) {
+    if (node < nodes_.size() && nodes_[node].type == NODE_ANY_SEQUENCE) {
+      star_node = node++;
+      star_pos = pos;
+    } else if (node < nodes_.size() && IsNodeMatch(nodes_[node], static_cast<unsigned char>(data[pos]))) {
+      node++;
+      pos++;
+    } else if (star_node != npos) {
+      node = star_node + 1;
+      pos = ++star_pos;
+    } else {
+      return false;
+    }
+  }
+
+  while (node < nodes_.size() && nodes_[node].type == NODE_ANY_SEQUENCE) {
+    node++;
+  }
+  return node == nodes_.size();
+}
+
+bool ScanPattern::IsNodeMatch(const Node& node, unsigned char ch) const {
+  switch (node.type) {
+    case NODE_CHAR:
+      return node.ch == ch;
+    case NODE_ANY_CHAR:
+      return true;
+    case NODE_CHAR_CLASS:
+      return char_classes_[node.char_class].test(ch);
+    case NODE_ANY_SEQUENCE:
+      break;
+  }
+
+  DNOTREACHED();
+  return false;
+}
+
+bool IsKeyMatchPattern(const char* data, size_t size, const pattern_t& pattern) {
+  return ScanPattern(pattern).IsMatch(data, size);
 }
 
 const raw_key_t kRangeKeyEnd = raw_key_t();
@@ -19,6 +19,7 @@
 #include <fastonosql/core/command_holder.h>
 
 #include <algorithm>
+#include <cctype>
 
 #include <common/convert2string.h>
 #include <common/sprintf.h>
@@ -32,7 +33,7 @@ size_t count_space(const command_buffer_t& data) {
 }
 }  // namespace
 
-common::Error TestArgsInRange(const CommandInfo& cmd, commands_args_t argv) {
+common::Error TestArgsInRange(const CommandInfo& cmd, const command_args_views_t& argv) {
   const size_t argc = argv.size();
   const CommandInfo::args_size_t max = cmd.GetMaxArgumentsCount();
   const CommandInfo::args_size_t min = cmd.GetMinArgumentsCount();
@@ -48,7 +49,7 @@ common::Error TestArgsInRange(const CommandInfo& cmd, commands_args_t argv) {
   return common::Error();
 }
 
-common::Error TestArgsModule2Equal1(const CommandInfo& cmd, commands_args_t argv) {
+common::Error TestArgsModule2Equal1(const CommandInfo& cmd, const command_args_views_t& argv) {
   const size_t argc = argv.size();
   if (argc % 2 != 1) {
     const std::string cmd_name = common::ConvertToString(cmd.name);
@@ -77,26 +78,42 @@ CommandHolder::CommandHolder(const command_buffer_t& name,
       white_spaces_count_(count_space(name)),
       test_funcs_(tests) {}
 
-bool CommandHolder::IsCommand(commands_args_t argv, size_t* offset) const {
+bool CommandHolder::IsCommand(const commands_args_t& argv, size_t* offset) const {
   if (argv.empty()) {
     return false;
   }
 
   const size_t uargc = argv.size();
-  if (uargc == white_spaces_count_) {
+  if (uargc <= white_spaces_count_) {
     return false;
   }
 
-  CHECK(uargc > white_spaces_count_);
-  command_buffer_t merged;
+  // compare word by word against the name instead of merging argv
+  size_t pos = 0;
   for (size_t i = 0; i < white_spaces_count_ + 1; ++i) {
     if (i != 0) {
-      merged += ' ';
+      if (pos >= name.size() || name[pos] != ' ') {
+        return false;
+      }
+      pos++;
     }
-    merged += argv[i];
+
+    const command_buffer_t& word = argv[i];
+    if (pos + word.size() > name.size()) {
+      return false;
+    }
+
+    for (size_t j = 0; j < word.size(); ++j) {
+      const unsigned char lc = word[j];
+      const unsigned char rc = name[pos + j];
+      if (std::tolower(lc) != std::tolower(rc)) {
+        return false;
+      }
+    }
+    pos += word.size();
   }
 
-  if (!IsEqualName(merged)) {
+  if (pos != name.size()) {
     return false;
   }
 
@@ -123,10 +140,9 @@ bool CommandHolder::IsEqualFirstName(const command_buffer_t& cmd_first_name) con
   return IsEqualName(cmd_first_name);
 }
 
-common::Error CommandHolder::TestArgs(commands_args_t argv) const {
-  const CommandInfo inf = *this;
-  for (test_function_t func : test_funcs_) {
-    common::Error err = func(inf, argv);
+common::Error CommandHolder::TestArgs(const command_args_views_t& argv) const {
+  for (const test_function_t& func : test_funcs_) {
+    common::Error err = func(*this, argv);
     if (err) {
       return err;
     }
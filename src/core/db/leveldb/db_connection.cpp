@@ -18,8 +18,11 @@
 
 #include <fastonosql/core/db/leveldb/db_connection.h>
 
+#include <algorithm>
+
 #include <leveldb/c.h>
 #include <leveldb/db.h>
+#include <leveldb/write_batch.h>
 
 #include <common/convert2string.h>
 #include <common/file_system/string_path_utils.h>
@@ -122,14 +125,23 @@ const ConstantCommandsArray kCommands = {CommandHolder(GEN_CMD_STRING(DB_HELP_CO
                                                        0,
                                                        CommandInfo::Native,
                                                        &CommandsApi::Keys),
+                                         CommandHolder(GEN_CMD_STRING(DB_REVERSE_KEYS_COMMAND),
+                                                       "<key_start> <key_end> <limit>",
+                                                       "Find keys matching the given limits in descending order.",
+                                                       UNDEFINED_SINCE,
+                                                       DB_REVERSE_KEYS_COMMAND " a z 10",
+                                                       3,
+                                                       0,
+                                                       CommandInfo::Native,
+                                                       &CommandsApi::ReverseKeys),
                                          CommandHolder(GEN_CMD_STRING(DB_DBKCOUNT_COMMAND),
-                                                       "-",
+                                                       "[" DB_DBKCOUNT_APPROX_ARG "]",
                                                        "Return the number of keys in the "
                                                        "selected database",
                                                        UNDEFINED_SINCE,
                                                        DB_DBKCOUNT_COMMAND,
                                                        0,
-                                                       0,
+                                                       1,
                                                        CommandInfo::Native,
                                                        &CommandsApi::DBKeysCount),
                                          CommandHolder(GEN_CMD_STRING(DB_FLUSHDB_COMMAND),
@@ -205,6 +217,18 @@ const ConstantCommandsArray kCommands = {CommandHolder(GEN_CMD_STRING(DB_HELP_CO
                                                        0,
                                                        CommandInfo::Native,
                                                        &CommandsApi::Quit)};
+
+const ::leveldb::Comparator* GetComparator(ComparatorType type) {
+  if (type == COMP_INDEXED_DB) {
+    static comparator::IndexedDB indexed_db;
+    return &indexed_db;
+  }
+
+  return ::leveldb::BytewiseComparator();
+}
+
+const keys_limit_t kApproximateCountSamples = 1024;
+const size_t kFlushBatchSize = 4096;  // deletes per write, keeps batch memory bounded
 }  // namespace
 }  // namespace leveldb
 template <>
@@ -268,11 +292,7 @@ common::Error CreateConnection(const Config& config, NativeConnection** context)
 
   ::leveldb::Options lv;
   lv.create_if_missing = config.create_if_missing;
-  if (config.comparator == COMP_BYTEWISE) {
-    lv.comparator = ::leveldb::BytewiseComparator();
-  } else if (config.comparator == COMP_INDEXED_DB) {
-    lv.comparator = new comparator::IndexedDB;
-  }
+  lv.comparator = GetComparator(config.comparator);
   if (config.compression == kNoCompression) {
     lv.compression = ::leveldb::kNoCompression;
   } else if (config.compression == kSnappyCompression) {
@@ -426,20 +446,48 @@ common::Error DBConnection::GetInner(const raw_key_t& key, raw_value_t* ret_val)
   return common::Error();
 }
 
-common::Error DBConnection::ScanImpl(cursor_t cursor_in,
+common::Error DBConnection::ScanImpl(const cursor_t& cursor_in,
                                      const pattern_t& pattern,
                                      keys_limit_t count_keys,
                                      raw_keys_t* keys_out,
                                      cursor_t* cursor_out) {
+  const ScanPattern matcher(pattern);
+  const raw_key_t& prefix = matcher.GetPrefix();
+  const ::leveldb::Slice prefix_slice(prefix.data(), prefix.size());
+  const config_t conf = GetConfig();
+  // in bytewise order all keys with the literal prefix are adjacent
+  const bool is_prefix_range = !prefix.empty() && (!conf || conf->comparator == COMP_BYTEWISE);
   ::leveldb::ReadOptions ro;
   ::leveldb::Iterator* it = connection_.handle_->NewIterator(ro);
-  uint64_t offset_pos = cursor_in;
-  cursor_t lcursor_out = 0;
+  cursor_t::position_t offset_pos = cursor_in.GetPosition();
+  if (cursor_in.HasToken()) {  // continue right after the last returned key
+    const raw_key_t last_key = cursor_in.GetToken();
+    const ::leveldb::Slice last_key_slice(last_key.data(), last_key.size());
+    if (is_prefix_range && last_key_slice.compare(prefix_slice) < 0) {
+      it->Seek(prefix_slice);
+    } else {
+      it->Seek(last_key_slice);
+      if (it->Valid() && it->key() == last_key_slice) {
+        it->Next();
+      }
+    }
+    offset_pos = 0;
+  } else if (is_prefix_range) {
+    it->Seek(prefix_slice);
+  } else {
+    it->SeekToFirst();
+  }
+
+  cursor_t lcursor_out;
   raw_keys_t lkeys_out;
-  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+  for (; it->Valid(); it->Next()) {
     const ::leveldb::Slice key_slice = it->key();
+    if (is_prefix_range && !key_slice.starts_with(prefix_slice)) {  // the rest of db is out of the pattern
+      break;
+    }
+
     if (lkeys_out.size() < count_keys) {
-      if (IsKeyMatchPattern(key_slice.data(), key_slice.size(), pattern)) {
+      if (matcher.IsMatch(key_slice.data(), key_slice.size())) {
         if (offset_pos == 0) {
           const raw_key_t key = GEN_READABLE_STRING_SIZE(key_slice.data(), key_slice.size());
           lkeys_out.push_back(key);
@@ -448,7 +496,8 @@ common::Error DBConnection::ScanImpl(cursor_t cursor_in,
         }
       }
     } else {
-      lcursor_out = cursor_in + count_keys;
+      lcursor_out =
+          lkeys_out.empty() ? cursor_in : cursor_t(cursor_in.GetPosition() + count_keys, lkeys_out.back());
       break;
     }
   }
@@ -470,19 +519,22 @@ common::Error DBConnection::KeysImpl(const raw_key_t& key_start,
                                      const raw_key_t& key_end,
                                      keys_limit_t limit,
                                      raw_keys_t* ret) {
+  const config_t conf = GetConfig();
+  const ::leveldb::Comparator* cmp = GetComparator(conf ? conf->comparator : COMP_BYTEWISE);
   const ::leveldb::Slice key_start_slice(key_start.data(), key_start.size());
+  const ::leveldb::Slice key_end_slice(key_end.data(), key_end.size());
+  const bool is_end_limited = key_end != kRangeKeyEnd;
   ::leveldb::ReadOptions ro;
   ::leveldb::Iterator* it = connection_.handle_->NewIterator(ro);  // keys(key_start, key_end, limit, ret);
-  for (it->Seek(key_start_slice); it->Valid(); it->Next()) {
+  for (it->Seek(key_start_slice); it->Valid() && ret->size() < limit; it->Next()) {
     auto slice = it->key();
-    raw_key_t key = GEN_CMD_STRING_SIZE(slice.data(), slice.size());
-    if (ret->size() < limit) {
-      if (IsKeyInEndRange(key, key_end)) {
-        ret->push_back(key);
-      }
-    } else {
+    if (is_end_limited && cmp->Compare(slice, key_end_slice) > 0) {  // the rest of db is out of range
       break;
     }
+
+    if (!slice.empty()) {
+      ret->push_back(GEN_CMD_STRING_SIZE(slice.data(), slice.size()));
+    }
   }
 
   auto st = it->status();
@@ -491,6 +543,46 @@ common::Error DBConnection::KeysImpl(const raw_key_t& key_start,
   return CheckResultCommand(DB_KEYS_COMMAND, st);
 }
 
+common::Error DBConnection::ReverseKeysImpl(const raw_key_t& key_start,
+                                            const raw_key_t& key_end,
+                                            keys_limit_t limit,
+                                            raw_keys_t* ret) {
+  const config_t conf = GetConfig();
+  const ::leveldb::Comparator* cmp = GetComparator(conf ? conf->comparator : COMP_BYTEWISE);
+  const ::leveldb::Slice key_start_slice(key_start.data(), key_start.size());
+  const ::leveldb::Slice key_end_slice(key_end.data(), key_end.size());
+  const bool is_start_limited = key_start != kRangeKeyStart;
+  ::leveldb::ReadOptions ro;
+  ::leveldb::Iterator* it = connection_.handle_->NewIterator(ro);
+  // leveldb has no SeekForPrev: seek to the first key >= key_end and step back if it is past it
+  if (key_end == kRangeKeyEnd) {
+    it->SeekToLast();
+  } else {
+    it->Seek(key_end_slice);
+    if (!it->Valid()) {
+      it->SeekToLast();
+    } else if (cmp->Compare(it->key(), key_end_slice) > 0) {
+      it->Prev();
+    }
+  }
+
+  for (; it->Valid() && ret->size() < limit; it->Prev()) {
+    auto slice = it->key();
+    if (is_start_limited && cmp->Compare(slice, key_start_slice) < 0) {
+      break;
+    }
+
+    if (!slice.empty()) {
+      ret->push_back(GEN_CMD_STRING_SIZE(slice.data(), slice.size()));
+    }
+  }
+
+  auto st = it->status();
+  delete it;
+
+  return CheckResultCommand(DB_REVERSE_KEYS_COMMAND, st);
+}
+
 common::Error DBConnection::DBKeysCountImpl(keys_limit_t* size) {
   ::leveldb::ReadOptions ro;
   ::leveldb::Iterator* it = connection_.handle_->NewIterator(ro);
@@ -511,23 +603,90 @@ common::Error DBConnection::DBKeysCountImpl(keys_limit_t* size) {
   return common::Error();
 }
 
+common::Error DBConnection::ApproximateDBKeysCountImpl(keys_limit_t* size) {
+  // average entry size from the head of db, total size from the tables
+  ::leveldb::ReadOptions ro;
+  ro.fill_cache = false;
+  ::leveldb::Iterator* it = connection_.handle_->NewIterator(ro);
+  keys_limit_t sampled = 0;
+  uint64_t sampled_bytes = 0;
+  std::string first_key;
+  for (it->SeekToFirst(); it->Valid() && sampled < kApproximateCountSamples; it->Next()) {
+    if (sampled == 0) {
+      first_key = it->key().ToString();
+    }
+    sampled++;
+    sampled_bytes += it->key().size() + it->value().size();
+  }
+
+  const bool is_sampled_all = !it->Valid();
+  std::string last_key;
+  if (!is_sampled_all) {
+    it->SeekToLast();
+    if (it->Valid()) {
+      last_key = it->key().ToString();
+    }
+  }
+
+  auto st = it->status();
+  delete it;
+
+  common::Error err = CheckResultCommand(DB_DBKCOUNT_COMMAND, st);
+  if (err) {
+    return err;
+  }
+
+  if (is_sampled_all) {
+    *size = sampled;
+    return common::Error();
+  }
+
+  const ::leveldb::Range range(first_key, last_key);
+  uint64_t db_bytes = 0;
+  connection_.handle_->GetApproximateSizes(&range, 1, &db_bytes);
+  if (db_bytes == 0 || sampled_bytes == 0) {  // only memtable yet, it is small enough to walk
+    return DBKeysCountImpl(size);
+  }
+
+  // compressed tables make it an underestimation
+  const uint64_t estimation = std::max<uint64_t>(db_bytes * sampled / sampled_bytes, sampled);
+  *size = static_cast<keys_limit_t>(std::min<uint64_t>(estimation, std::numeric_limits<keys_limit_t>::max()));
+  return common::Error();
+}
+
 common::Error DBConnection::FlushDBImpl() {
   ::leveldb::ReadOptions ro;
+  ro.fill_cache = false;
   ::leveldb::WriteOptions wo;
-  ::leveldb::Iterator* it = connection_.handle_->NewIterator(ro);
+  ::leveldb::WriteBatch batch;
+  size_t batch_size = 0;
+  ::leveldb::Iterator* it = connection_.handle_->NewIterator(ro);  // iterates over implicit snapshot
   for (it->SeekToFirst(); it->Valid(); it->Next()) {
-    std::string key = it->key().ToString();
-    common::Error err = CheckResultCommand(DB_FLUSHDB_COMMAND, connection_.handle_->Delete(wo, key));
-    if (err) {
-      delete it;
-      return err;
+    batch.Delete(it->key());
+    if (++batch_size == kFlushBatchSize) {
+      common::Error err = CheckResultCommand(DB_FLUSHDB_COMMAND, connection_.handle_->Write(wo, &batch));
+      if (err) {
+        delete it;
+        return err;
+      }
+      batch.Clear();
+      batch_size = 0;
     }
   }
 
   auto st = it->status();
   delete it;
 
-  return CheckResultCommand(DB_FLUSHDB_COMMAND, st);
+  common::Error err = CheckResultCommand(DB_FLUSHDB_COMMAND, st);
+  if (err) {
+    return err;
+  }
+
+  if (batch_size == 0) {
+    return common::Error();
+  }
+
+  return CheckResultCommand(DB_FLUSHDB_COMMAND, connection_.handle_->Write(wo, &batch));
 }
 
 common::Error DBConnection::SelectImpl(const db_name_t& name, IDataBaseInfo** info) {
@@ -536,7 +695,7 @@ common::Error DBConnection::SelectImpl(const db_name_t& name, IDataBaseInfo** in
   }
 
   keys_limit_t kcount = 0;
-  common::Error err = DBKeysCount(&kcount);
+  common::Error err = ApproximateDBKeysCount(&kcount);  // exact count walks the whole db
   DCHECK(!err) << err->GetDescription();
   *info = new DataBaseInfo(name, true, kcount);
   return common::Error();
@@ -18,6 +18,8 @@
 
 #include <fastonosql/core/db/lmdb/db_connection.h>
 
+#include <algorithm>
+
 #include <lmdb.h>
 
 #include <common/utils.h>
@@ -132,14 +134,23 @@ const ConstantCommandsArray kCommands = {CommandHolder(GEN_CMD_STRING(DB_HELP_CO
                                                        0,
                                                        CommandInfo::Native,
                                                        &CommandsApi::Keys),
+                                         CommandHolder(GEN_CMD_STRING(DB_REVERSE_KEYS_COMMAND),
+                                                       "<key_start> <key_end> <limit>",
+                                                       "Find keys matching the given limits in descending order.",
+                                                       UNDEFINED_SINCE,
+                                                       DB_REVERSE_KEYS_COMMAND " a z 10",
+                                                       3,
+                                                       0,
+                                                       CommandInfo::Native,
+                                                       &CommandsApi::ReverseKeys),
                                          CommandHolder(GEN_CMD_STRING(DB_DBKCOUNT_COMMAND),
-                                                       "-",
+                                                       "[" DB_DBKCOUNT_APPROX_ARG "]",
                                                        "Return the number of keys in the "
                                                        "selected database",
                                                        UNDEFINED_SINCE,
                                                        DB_DBKCOUNT_COMMAND,
                                                        0,
-                                                       0,
+                                                       1,
                                                        CommandInfo::Native,
                                                        &CommandsApi::DBKeysCount),
                                          CommandHolder(GEN_CMD_STRING(DB_FLUSHDB_COMMAND),
@@ -644,7 +655,7 @@ common::Error DBConnection::DelInner(const raw_key_t& key) {
   return CheckResultCommand(DB_DELETE_KEY_COMMAND, mdb_txn_commit(txn));
 }
 
-common::Error DBConnection::ScanImpl(cursor_t cursor_in,
+common::Error DBConnection::ScanImpl(const cursor_t& cursor_in,
                                      const pattern_t& pattern,
                                      keys_limit_t count_keys,
                                      raw_keys_t* keys_out,
@@ -663,14 +674,47 @@ common::Error DBConnection::ScanImpl(cursor_t cursor_in,
     return err;
   }
 
+  const ScanPattern matcher(pattern);
+  const raw_key_t& prefix = matcher.GetPrefix();
+  MDB_val prefix_key = ConvertToLMDBSlice(prefix.data(), prefix.size());
+  const raw_key_t last_rkey = cursor_in.GetToken();
+  MDB_val last_key = ConvertToLMDBSlice(last_rkey.data(), last_rkey.size());
+  // keys are sorted by memcmp, so all keys with the literal prefix are adjacent
+  bool is_after_last_key = !last_rkey.empty();
+  if (is_after_last_key && !prefix.empty() && mdb_cmp(txn, connection_.handle_->dbi, &last_key, &prefix_key) < 0) {
+    is_after_last_key = false;
+  }
+
   MDB_val key;
   MDB_val data;
-  uint64_t offset_pos = cursor_in;
-  uint64_t lcursor_out = 0;
+  MDB_cursor_op op = MDB_NEXT;
+  bool is_finished = false;
+  cursor_t::position_t offset_pos = last_rkey.empty() ? cursor_in.GetPosition() : 0;
+  if (is_after_last_key || !prefix.empty()) {  // continue right after the last returned key or from the prefix
+    key = is_after_last_key ? last_key : prefix_key;
+    int rc = mdb_cursor_get(cursor, &key, &data, MDB_SET_RANGE);
+    if (rc == LMDB_OK) {
+      const bool is_same_key = is_after_last_key && mdb_cmp(txn, connection_.handle_->dbi, &key, &last_key) == 0;
+      op = is_same_key ? MDB_NEXT : MDB_GET_CURRENT;
+    } else if (rc == MDB_NOTFOUND) {
+      is_finished = true;  // no keys after the seek point
+    } else {
+      mdb_cursor_close(cursor);
+      mdb_txn_abort(txn);
+      return CheckResultCommand(DB_SCAN_COMMAND, rc);
+    }
+  }
+
+  cursor_t lcursor_out;
   std::vector<command_buffer_t> lkeys_out;
-  while ((mdb_cursor_get(cursor, &key, &data, MDB_NEXT) == LMDB_OK)) {
+  for (; !is_finished && mdb_cursor_get(cursor, &key, &data, op) == LMDB_OK; op = MDB_NEXT) {
+    const char* key_data = static_cast<const char*>(key.mv_data);
+    if (!matcher.HasPrefix(key_data, key.mv_size)) {  // the rest of db is out of the pattern
+      break;
+    }
+
     if (lkeys_out.size() < count_keys) {
-      if (IsKeyMatchPattern(static_cast<const char*>(key.mv_data), key.mv_size, pattern)) {
+      if (matcher.IsMatch(key_data, key.mv_size)) {
         if (offset_pos == 0) {
           const raw_key_t rkey =
               GEN_CMD_STRING_SIZE(static_cast<const raw_key_t::value_type*>(key.mv_data), key.mv_size);
@@ -680,7 +724,8 @@ common::Error DBConnection::ScanImpl(cursor_t cursor_in,
         }
       }
     } else {
-      lcursor_out = cursor_in + count_keys;
+      lcursor_out =
+          lkeys_out.empty() ? cursor_in : cursor_t(cursor_in.GetPosition() + count_keys, lkeys_out.back());
       break;
     }
   }
@@ -710,13 +755,19 @@ common::Error DBConnection::KeysImpl(const raw_key_t& key_start,
     return err;
   }
 
-  MDB_val key;
+  MDB_val key = ConvertToLMDBSlice(key_start.data(), key_start.size());
+  MDB_val end_key = ConvertToLMDBSlice(key_end.data(), key_end.size());
+  const bool is_end_limited = key_end != kRangeKeyEnd;
   MDB_val data;
-  while ((mdb_cursor_get(cursor, &key, &data, MDB_NEXT) == LMDB_OK) && limit > ret->size()) {
-    const raw_key_t rkey =
-        GEN_CMD_STRING_SIZE(reinterpret_cast<const command_buffer_t::value_type*>(key.mv_data), key.mv_size);
-    if (IsKeyInRange(key_start, rkey, key_end)) {
-      ret->push_back(rkey);
+  MDB_cursor_op op = key_start == kRangeKeyStart ? MDB_FIRST : MDB_SET_RANGE;
+  for (; limit > ret->size() && mdb_cursor_get(cursor, &key, &data, op) == LMDB_OK; op = MDB_NEXT) {
+    if (is_end_limited && mdb_cmp(txn, connection_.handle_->dbi, &key, &end_key) > 0) {  // sorted, nothing left
+      break;
+    }
+
+    if (key.mv_size) {
+      ret->push_back(
+          GEN_CMD_STRING_SIZE(reinterpret_cast<const command_buffer_t::value_type*>(key.mv_data), key.mv_size));
     }
   }
 
@@ -725,31 +776,74 @@ common::Error DBConnection::KeysImpl(const raw_key_t& key_start,
   return common::Error();
 }
 
-common::Error DBConnection::DBKeysCountImpl(keys_limit_t* size) {
+common::Error DBConnection::ReverseKeysImpl(const raw_key_t& key_start,
+                                            const raw_key_t& key_end,
+                                            keys_limit_t limit,
+                                            raw_keys_t* ret) {
   MDB_cursor* cursor = nullptr;
   MDB_txn* txn = nullptr;
   common::Error err =
-      CheckResultCommand(DB_DBKCOUNT_COMMAND, mdb_txn_begin(connection_.handle_->env, nullptr, MDB_RDONLY, &txn));
+      CheckResultCommand(DB_REVERSE_KEYS_COMMAND, mdb_txn_begin(connection_.handle_->env, nullptr, MDB_RDONLY, &txn));
   if (err) {
     return err;
   }
 
-  err = CheckResultCommand(DB_DBKCOUNT_COMMAND, mdb_cursor_open(txn, connection_.handle_->dbi, &cursor));
+  err = CheckResultCommand(DB_REVERSE_KEYS_COMMAND, mdb_cursor_open(txn, connection_.handle_->dbi, &cursor));
   if (err) {
     mdb_txn_abort(txn);
     return err;
   }
 
-  MDB_val key;
+  MDB_val key = ConvertToLMDBSlice(key_end.data(), key_end.size());
+  MDB_val start_key = ConvertToLMDBSlice(key_start.data(), key_start.size());
+  const bool is_start_limited = key_start != kRangeKeyStart;
   MDB_val data;
-  size_t sz = 0;
-  while (mdb_cursor_get(cursor, &key, &data, MDB_NEXT) == LMDB_OK) {
-    sz++;
+  MDB_cursor_op op = MDB_LAST;
+  if (key_end != kRangeKeyEnd) {
+    // position on the first key >= key_end, step back if it is past key_end
+    int rc = mdb_cursor_get(cursor, &key, &data, MDB_SET_RANGE);
+    if (rc == LMDB_OK) {
+      MDB_val end_key = ConvertToLMDBSlice(key_end.data(), key_end.size());
+      op = mdb_cmp(txn, connection_.handle_->dbi, &key, &end_key) > 0 ? MDB_PREV : MDB_GET_CURRENT;
+    } else if (rc != MDB_NOTFOUND) {
+      mdb_cursor_close(cursor);
+      mdb_txn_abort(txn);
+      return CheckResultCommand(DB_REVERSE_KEYS_COMMAND, rc);
+    }
   }
+
+  for (; limit > ret->size() && mdb_cursor_get(cursor, &key, &data, op) == LMDB_OK; op = MDB_PREV) {
+    if (is_start_limited && mdb_cmp(txn, connection_.handle_->dbi, &key, &start_key) < 0) {
+      break;
+    }
+
+    if (key.mv_size) {
+      ret->push_back(
+          GEN_CMD_STRING_SIZE(reinterpret_cast<const command_buffer_t::value_type*>(key.mv_data), key.mv_size));
+    }
+  }
+
   mdb_cursor_close(cursor);
   mdb_txn_abort(txn);
+  return common::Error();
+}
 
-  *size = sz;
+common::Error DBConnection::DBKeysCountImpl(keys_limit_t* size) {
+  MDB_txn* txn = nullptr;
+  common::Error err =
+      CheckResultCommand(DB_DBKCOUNT_COMMAND, mdb_txn_begin(connection_.handle_->env, nullptr, MDB_RDONLY, &txn));
+  if (err) {
+    return err;
+  }
+
+  MDB_stat stat;  // b-tree keeps the number of entries, no need to walk it
+  err = CheckResultCommand(DB_DBKCOUNT_COMMAND, mdb_stat(txn, connection_.handle_->dbi, &stat));
+  mdb_txn_abort(txn);
+  if (err) {
+    return err;
+  }
+
+  *size = static_cast<keys_limit_t>(std::min<uint64_t>(stat.ms_entries, std::numeric_limits<keys_limit_t>::max()));
   return common::Error();
 }
 
@@ -782,7 +876,6 @@ common::Error DBConnection::RemoveDBImpl(const db_name_t& name, IDataBaseInfo**
 }
 
 common::Error DBConnection::FlushDBImpl() {
-  MDB_cursor* cursor = nullptr;
   MDB_txn* txn = nullptr;
   auto conf = GetConfig();
   int env_flags = conf->env_flags;
@@ -793,32 +886,14 @@ common::Error DBConnection::FlushDBImpl() {
     return err;
   }
 
-  err = CheckResultCommand(DB_FLUSHDB_COMMAND, mdb_cursor_open(txn, connection_.handle_->dbi, &cursor));
+  // empty the db in one go, dbi stays open
+  err = CheckResultCommand(DB_FLUSHDB_COMMAND, mdb_drop(txn, connection_.handle_->dbi, 0));
   if (err) {
     mdb_txn_abort(txn);
     return err;
   }
 
-  MDB_val key;
-  MDB_val data;
-  size_t sz = 0;
-  while (mdb_cursor_get(cursor, &key, &data, MDB_NEXT) == LMDB_OK) {
-    sz++;
-    err = CheckResultCommand(DB_FLUSHDB_COMMAND, mdb_del(txn, connection_.handle_->dbi, &key, nullptr));
-    if (err) {
-      mdb_cursor_close(cursor);
-      mdb_txn_abort(txn);
-      return err;
-    }
-  }
-
-  mdb_cursor_close(cursor);
-  if (sz != 0) {
-    return CheckResultCommand(DB_DELETE_KEY_COMMAND, mdb_txn_commit(txn));
-  }
-
-  mdb_txn_abort(txn);
-  return common::Error();
+  return CheckResultCommand(DB_FLUSHDB_COMMAND, mdb_txn_commit(txn));
 }
 
 common::Error DBConnection::SelectImpl(const db_name_t& name, IDataBaseInfo** info) {
@@ -866,6 +941,44 @@ common::Error DBConnection::GetImpl(const NKey& key, NDbKValue* loaded_key) {
   return common::Error();
 }
 
+common::Error DBConnection::GetUniManyImpl(const NKeys& keys, std::vector<NDbKValue>* loaded_keys) {
+  MDB_txn* txn = nullptr;
+  common::Error err =
+      CheckResultCommand(DB_GET_KEY_COMMAND, mdb_txn_begin(connection_.handle_->env, nullptr, MDB_RDONLY, &txn));
+  if (err) {
+    return err;
+  }
+
+  std::vector<NDbKValue> lloaded_keys;
+  lloaded_keys.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    const auto key_str = keys[i].GetKey();
+    const raw_key_t rkey = key_str.GetData();
+    MDB_val key_slice = ConvertToLMDBSlice(rkey.data(), rkey.size());
+    MDB_val mval;
+    const int rc = mdb_get(txn, connection_.handle_->dbi, &key_slice, &mval);
+    if (rc == MDB_NOTFOUND) {  // removed after the scan, skipped
+      continue;
+    }
+
+    err = CheckResultCommand(DB_GET_KEY_COMMAND, rc);
+    if (err) {
+      mdb_txn_abort(txn);
+      return err;
+    }
+
+    // mval points into the map, copy before the txn ends
+    const raw_value_t value_str =
+        GEN_CMD_STRING_SIZE(reinterpret_cast<const raw_value_t::value_type*>(mval.mv_data), mval.mv_size);
+    NValue val(common::Value::CreateStringValue(value_str));
+    lloaded_keys.push_back(NDbKValue(keys[i], val));
+  }
+
+  mdb_txn_abort(txn);
+  *loaded_keys = lloaded_keys;
+  return common::Error();
+}
+
 common::Error DBConnection::DeleteImpl(const NKeys& keys, NKeys* deleted_keys) {
   for (size_t i = 0; i < keys.size(); ++i) {
     NKey key = keys[i];
@@ -119,20 +119,22 @@ memcached_return_t memcached_dump_keys_callback(const memcached_st* ptr,
 }
 
 struct ScanHolder {
-  ScanHolder(fastonosql::core::cursor_t cursor_in, const std::string& pattern, fastonosql::core::keys_limit_t limit)
+  ScanHolder(fastonosql::core::cursor_t::position_t cursor_in,
+             const std::string& pattern,
+             fastonosql::core::keys_limit_t limit)
       : cursor_in(cursor_in), limit(limit), pattern(pattern), cursor_out(0), offset_pos(cursor_in), result() {}
 
-  const fastonosql::core::cursor_t cursor_in;
+  const fastonosql::core::cursor_t::position_t cursor_in;
   const fastonosql::core::keys_limit_t limit;
-  const std::string pattern;
-  fastonosql::core::cursor_t cursor_out;
-  fastonosql::core::cursor_t offset_pos;
+  const fastonosql::core::ScanPattern pattern;
+  fastonosql::core::cursor_t::position_t cursor_out;
+  fastonosql::core::cursor_t::position_t offset_pos;
   std::vector<fastonosql::core::command_buffer_t> result;
 
   memcached_return_t AddKey(const char* key, size_t key_length, time_t exp) {
     UNUSED(exp);
     if (result.size() < limit) {
-      if (fastonosql::core::IsKeyMatchPattern(key, key_length, pattern)) {
+      if (pattern.IsMatch(key, key_length)) {
         if (offset_pos == 0) {
           result.push_back(GEN_CMD_STRING_SIZE(key, key_length));
         } else {
@@ -875,12 +877,12 @@ common::Error DBConnection::TTLInner(const raw_key_t& key, ttl_t* expiration) {
   return common::Error();
 }
 
-common::Error DBConnection::ScanImpl(cursor_t cursor_in,
+common::Error DBConnection::ScanImpl(const cursor_t& cursor_in,
                                      const pattern_t& pattern,
                                      keys_limit_t count_keys,
                                      raw_keys_t* keys_out,
                                      cursor_t* cursor_out) {
-  ScanHolder hld(cursor_in, pattern, count_keys);
+  ScanHolder hld(cursor_in.GetPosition(), pattern, count_keys);
   memcached_dump_fn func[1] = {memcached_dump_scan_callback};
   common::Error err =
       CheckResultCommand(DB_SCAN_COMMAND, memcached_dump(connection_.handle_, func, &hld, SIZEOFMASS(func)));
@@ -889,7 +891,7 @@ common::Error DBConnection::ScanImpl(cursor_t cursor_in,
   }
 
   *keys_out = hld.result;
-  *cursor_out = hld.cursor_out;
+  *cursor_out = cursor_t(hld.cursor_out);
   return common::Error();
 }
 
@@ -3537,21 +3537,33 @@ DBConnection::DBConnection(CDBConnectionClient* client)
 
 common::Error DBConnection::GetUniImpl(const NKey& key, NDbKValue* loaded_key) {
   readable_string_t type_str;
-  common::Error err = base_class::GetType(key, &type_str);
+  bool loaded = false;
+  common::Error err = LoadTypedValue(key, &type_str, loaded_key, &loaded);
   if (err) {
     return err;
   }
 
+  if (loaded) {
+    return common::Error();
+  }
+
+  if (type_str.empty()) {
+    err = base_class::GetType(key, &type_str);
+    if (err) {
+      return err;
+    }
+  }
+
   if (type_str == GEN_CMD_STRING("string")) {
     return GetImpl(key, loaded_key);
   } else if (type_str == GEN_CMD_STRING("list")) {
-    return LrangeImpl(key, 0, -1, loaded_key);
+    return GetCollectionImpl(key, common::Value::TYPE_ARRAY, loaded_key);
   } else if (type_str == GEN_CMD_STRING("set")) {
-    return SmembersImpl(key, loaded_key);
+    return GetCollectionImpl(key, common::Value::TYPE_SET, loaded_key);
   } else if (type_str == GEN_CMD_STRING("hash")) {
-    return HgetallImpl(key, loaded_key);
+    return GetCollectionImpl(key, common::Value::TYPE_HASH, loaded_key);
   } else if (type_str == GEN_CMD_STRING("zset")) {
-    return ZrangeImpl(key, 0, -1, true, loaded_key);
+    return GetCollectionImpl(key, common::Value::TYPE_ZSET, loaded_key);
   }
 #if defined(PRO_VERSION)
   else if (type_str == GEN_CMD_STRING("stream")) {
@@ -3577,7 +3589,7 @@ common::Error DBConnection::GetUniImpl(const NKey& key, NDbKValue* loaded_key) {
 
 #if defined(PRO_VERSION)
 common::Error DBConnection::JsonSetImpl(const NDbKValue& key) {
-  command_buffer_t set_cmd;
+  commands_args_t set_cmd;
   redis_translator_t tran = GetSpecificTranslator<CommandTranslator>();
   common::Error err = tran->CreateKeyCommand(key, &set_cmd);
   if (err) {
@@ -3585,7 +3597,7 @@ common::Error DBConnection::JsonSetImpl(const NDbKValue& key) {
   }
 
   redisReply* reply = nullptr;
-  err = redis_compatible::ExecRedisCommand(connection_.handle_, set_cmd, &reply);
+  err = ExecCommand(set_cmd, &reply);
   if (err) {
     return err;
   }
@@ -3595,7 +3607,7 @@ common::Error DBConnection::JsonSetImpl(const NDbKValue& key) {
 }
 
 common::Error DBConnection::JsonGetImpl(const NKey& key, NDbKValue* loaded_key) {
-  command_buffer_t get_cmd;
+  commands_args_t get_cmd;
   redis_translator_t tran = GetSpecificTranslator<CommandTranslator>();
   common::Error err = tran->LoadKeyCommand(key, JsonValue::TYPE_JSON, &get_cmd);
   if (err) {
@@ -3603,7 +3615,7 @@ common::Error DBConnection::JsonGetImpl(const NKey& key, NDbKValue* loaded_key)
   }
 
   redisReply* reply = nullptr;
-  err = redis_compatible::ExecRedisCommand(connection_.handle_, get_cmd, &reply);
+  err = ExecCommand(get_cmd, &reply);
   if (err) {
     return err;
   }
@@ -3627,7 +3639,7 @@ common::Error DBConnection::JsonGetImpl(const NKey& key, NDbKValue* loaded_key)
 }
 
 common::Error DBConnection::JsonDelImpl(const NKey& key, long long* deleted) {
-  command_buffer_t del_cmd;
+  commands_args_t del_cmd;
   redis_translator_t tran = GetSpecificTranslator<CommandTranslator>();
   common::Error err = tran->DeleteKeyCommand(key, &del_cmd);
   if (err) {
@@ -3635,7 +3647,7 @@ common::Error DBConnection::JsonDelImpl(const NKey& key, long long* deleted) {
   }
 
   redisReply* reply = nullptr;
-  err = redis_compatible::ExecRedisCommand(connection_.handle_, del_cmd, &reply);
+  err = ExecCommand(del_cmd, &reply);
   if (err) {
     return err;
   }
@@ -3660,7 +3672,7 @@ common::Error DBConnection::XAddImpl(const NDbKValue& key, command_buffer_t* gen
   }
 
   redisReply* reply = nullptr;
-  err = redis_compatible::ExecRedisCommand(connection_.handle_, set_cmd, &reply);
+  err = ExecCommand(set_cmd, &reply);
   if (err) {
     return err;
   }
@@ -3678,7 +3690,7 @@ common::Error DBConnection::XAddImpl(const NDbKValue& key, command_buffer_t* gen
 }
 
 common::Error DBConnection::XRangeImpl(const NKey& key, NDbKValue* loaded_key, fastonosql::core::FastoObject* out) {
-  command_buffer_t get_cmd;
+  commands_args_t get_cmd;
   redis_translator_t tran = GetSpecificTranslator<CommandTranslator>();
   common::Error err = tran->LoadKeyCommand(key, StreamValue::TYPE_STREAM, &get_cmd);
   if (err) {
@@ -3686,7 +3698,7 @@ common::Error DBConnection::XRangeImpl(const NKey& key, NDbKValue* loaded_key, f
   }
 
   redisReply* reply = nullptr;
-  err = redis_compatible::ExecRedisCommand(connection_.handle_, get_cmd, &reply);
+  err = ExecCommand(get_cmd, &reply);
   if (err) {
     return err;
   }
@@ -3754,7 +3766,7 @@ common::Error DBConnection::XRangeImpl2(const NKey& key, NDbKValue* loaded_key)
   }
 
   redisReply* reply = nullptr;
-  err = redis_compatible::ExecRedisCommand(connection_.handle_, get_cmd, &reply);
+  err = ExecCommand(get_cmd, &reply);
   if (err) {
     return err;
   }
@@ -3831,7 +3843,7 @@ common::Error DBConnection::ModuleLoadImpl(const ModuleInfo& module) {
   }
 
   redisReply* reply = nullptr;
-  err = redis_compatible::ExecRedisCommand(connection_.handle_, module_load_cmd, &reply);
+  err = ExecCommand(module_load_cmd, &reply);
   if (err) {
     return err;
   }
@@ -3849,7 +3861,7 @@ common::Error DBConnection::ModuleUnLoadImpl(const ModuleInfo& module) {
   }
 
   redisReply* reply = nullptr;
-  err = redis_compatible::ExecRedisCommand(connection_.handle_, module_unload_cmd, &reply);
+  err = ExecCommand(module_unload_cmd, &reply);
   if (err) {
     return err;
   }
@@ -4086,7 +4098,7 @@ common::Error DBConnection::ClThrottle(const NKey& key,
   }
 
   redisReply* reply = nullptr;
-  err = redis_compatible::ExecRedisCommand(connection_.handle_, throttle_cmd, &reply);
+  err = ExecCommand(throttle_cmd, &reply);
   if (err) {
     return err;
   }
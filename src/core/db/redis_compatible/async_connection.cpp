@@ -0,0 +1,542 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <fastonosql/core/db/redis_compatible/async_connection.h>
+
+#include <algorithm>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#define poll WSAPoll
+#else
+#include <poll.h>
+#endif
+
+extern "C" {
+#include <hiredis/async.h>
+#include <hiredis/hiredis.h>
+}
+
+#include <common/convert2string.h>
+
+#include <fastonosql/core/db/redis_compatible/command_translator.h>
+#include <fastonosql/core/db/redis_compatible/db_connection.h>
+#include <fastonosql/core/icommand_translator.h>
+
+namespace fastonosql {
+namespace core {
+namespace redis_compatible {
+
+namespace {
+const int kRunTimeoutMsec = 100;  // how fast Run notices Stop
+
+common::Error KeyNotFound(const char* cmd) {
+  return common::make_error(common::MemSPrintf("%s function error: key not found.", cmd));
+}
+
+common::Error UnexpectedReply(redisReply* reply) {
+  return common::make_error(common::MemSPrintf("Unexpected reply type: %d", reply->type));
+}
+}  // namespace
+
+AsyncEventLoop::AsyncEventLoop() : connections_(), stop_(false) {}
+
+AsyncEventLoop::~AsyncEventLoop() {
+  DCHECK(connections_.empty()) << "connections must be destroyed before their loop";
+}
+
+size_t AsyncEventLoop::RunOnce(int timeout_msec) {
+  std::vector<pollfd> fds;
+  std::vector<AsyncConnection*> owners;
+  for (AsyncConnection* connection : connections_) {
+    if (!connection->context_ || (!connection->is_reading_ && !connection->is_writing_)) {
+      continue;
+    }
+
+    pollfd fd;
+    fd.fd = connection->context_->c.fd;
+    fd.events = (connection->is_reading_ ? POLLIN : 0) | (connection->is_writing_ ? POLLOUT : 0);
+    fd.revents = 0;
+    fds.push_back(fd);
+    owners.push_back(connection);
+  }
+
+  if (fds.empty()) {
+    return 0;
+  }
+
+  int res = poll(fds.data(), fds.size(), timeout_msec);
+  if (res <= 0) {
+    return 0;
+  }
+
+  size_t handled = 0;
+  for (size_t i = 0; i < fds.size(); ++i) {
+    if (!fds[i].revents) {
+      continue;
+    }
+
+    // a callback of an earlier socket may have closed this one
+    AsyncConnection* connection = owners[i];
+    if (!IsRegistered(connection)) {
+      continue;
+    }
+
+    if ((fds[i].revents & (POLLIN | POLLERR | POLLHUP)) && connection->context_) {
+      redisAsyncHandleRead(connection->context_);
+    }
+    if ((fds[i].revents & POLLOUT) && connection->context_) {
+      redisAsyncHandleWrite(connection->context_);
+    }
+    handled++;
+  }
+
+  return handled;
+}
+
+void AsyncEventLoop::Run() {
+  stop_ = false;
+  while (!stop_ && HasWatchedSockets()) {
+    RunOnce(kRunTimeoutMsec);
+  }
+}
+
+void AsyncEventLoop::Stop() {
+  stop_ = true;
+}
+
+void AsyncEventLoop::Register(AsyncConnection* connection) {
+  connections_.push_back(connection);
+}
+
+void AsyncEventLoop::Unregister(AsyncConnection* connection) {
+  connections_.erase(std::remove(connections_.begin(), connections_.end(), connection), connections_.end());
+}
+
+bool AsyncEventLoop::IsRegistered(AsyncConnection* connection) const {
+  return std::find(connections_.begin(), connections_.end(), connection) != connections_.end();
+}
+
+bool AsyncEventLoop::HasWatchedSockets() const {
+  for (AsyncConnection* connection : connections_) {
+    if (connection->context_ && (connection->is_reading_ || connection->is_writing_)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+AsyncConnection::AsyncConnection(AsyncEventLoop* loop, std::shared_ptr<CommandTranslator> translator)
+    : loop_(loop),
+      translator_(translator),
+      context_(nullptr),
+      is_connected_(false),
+      is_reading_(false),
+      is_writing_(false),
+      on_connected_() {
+  CHECK(loop_);
+  loop_->Register(this);
+}
+
+AsyncConnection::~AsyncConnection() {
+  if (context_) {
+    redisAsyncFree(context_);  // fires pending callbacks with an error and OnDisconnect
+    context_ = nullptr;
+  }
+  loop_->Unregister(this);
+}
+
+common::Error AsyncConnection::Connect(const Config& config, status_callback_t on_connected) {
+  if (context_) {
+    return common::make_error("Already connected");
+  }
+
+  if (config.is_ssl) {
+    return common::make_error("SSL connections are not supported in async mode");
+  }
+
+  redisAsyncContext* lcontext = nullptr;
+  const bool is_local = !config.hostsocket.empty();
+  if (is_local) {
+    lcontext = redisAsyncConnectUnix(config.hostsocket.c_str());
+  } else {
+    const std::string host_str = config.host.GetHost();
+    lcontext = redisAsyncConnect(host_str.c_str(), config.host.GetPort());
+  }
+
+  const std::string address = is_local ? config.hostsocket : common::ConvertToString(config.host);
+  if (!lcontext) {
+    return common::make_error(common::MemSPrintf("Could not connect to Redis at %s : no context", address));
+  }
+
+  if (lcontext->err) {
+    const std::string buff = common::MemSPrintf("Could not connect to Redis at %s : %s", address, lcontext->errstr);
+    redisAsyncFree(lcontext);
+    return common::make_error(buff);
+  }
+
+  lcontext->data = this;
+  lcontext->ev.data = this;
+  lcontext->ev.addRead = AddRead;
+  lcontext->ev.delRead = DelRead;
+  lcontext->ev.addWrite = AddWrite;
+  lcontext->ev.delWrite = DelWrite;
+  lcontext->ev.cleanup = Cleanup;
+  redisAsyncSetConnectCallback(lcontext, OnConnect);
+  redisAsyncSetDisconnectCallback(lcontext, OnDisconnect);
+  context_ = lcontext;
+  on_connected_ = on_connected;
+
+  // setup goes first in the queue, PING if there is nothing to set up so that on_connected always has a reply to
+  // wait for, a failed connect delivers an error to it
+  std::vector<commands_args_t> setup;
+  if (!config.auth.empty()) {
+    setup.push_back({GEN_CMD_STRING("AUTH"), common::ConvertToCharBytes(config.auth)});
+  }
+  if (config.db_num != Config::kDefaultDbNum) {
+    setup.push_back({GEN_CMD_STRING(DB_SELECTDB_COMMAND), common::ConvertToCharBytes(config.db_num)});
+  }
+  if (setup.empty()) {
+    setup.push_back({GEN_CMD_STRING("PING")});
+  }
+
+  auto setup_err = std::make_shared<common::Error>();
+  for (size_t i = 0; i < setup.size(); ++i) {
+    const bool is_last = i == setup.size() - 1;
+    common::Error err = ExecCommand(setup[i], [this, setup_err, is_last](common::Error reply_err, redisReply*) {
+      if (reply_err && !*setup_err) {
+        *setup_err = reply_err;
+      }
+      if (is_last) {
+        FinishConnect(*setup_err);
+      }
+    });
+    if (err) {
+      return err;
+    }
+  }
+
+  return common::Error();
+}
+
+void AsyncConnection::Disconnect() {
+  if (context_) {
+    redisAsyncDisconnect(context_);
+  }
+}
+
+bool AsyncConnection::IsConnected() const {
+  return context_ && is_connected_;
+}
+
+common::Error AsyncConnection::ExecCommand(const commands_args_t& argv, reply_callback_t cb) {
+  if (argv.empty() || !cb) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  if (!context_) {
+    return common::make_error("Not connected");
+  }
+
+  std::vector<const char*> argvc(argv.size());
+  std::vector<size_t> argvlen(argv.size());
+  for (size_t i = 0; i < argv.size(); ++i) {
+    argvc[i] = argv[i].data();
+    argvlen[i] = argv[i].size();
+  }
+
+  reply_callback_t* privdata = new reply_callback_t(cb);
+  if (redisAsyncCommandArgv(context_, OnReply, privdata, argv.size(), argvc.data(), argvlen.data()) == REDIS_ERR) {
+    delete privdata;
+    return common::make_error(context_->errstr[0] ? context_->errstr : "Failed to queue command");
+  }
+
+  return common::Error();
+}
+
+common::Error AsyncConnection::Info(const std::string& section, info_callback_t cb) {
+  commands_args_t info_cmd = {GEN_CMD_STRING(DB_INFO_COMMAND)};
+  if (!section.empty()) {
+    info_cmd.push_back(common::ConvertToCharBytes(section));
+  }
+
+  return ExecCommand(info_cmd, [cb](common::Error err, redisReply* reply) {
+    if (err) {
+      cb(err, std::string());
+      return;
+    }
+
+    if (reply->type != REDIS_REPLY_STRING) {
+      cb(UnexpectedReply(reply), std::string());
+      return;
+    }
+
+    cb(common::Error(), std::string(reply->str, reply->len));
+  });
+}
+
+common::Error AsyncConnection::DBKeysCount(keys_count_callback_t cb) {
+  return ExecCommand({GEN_CMD_STRING("DBSIZE")}, [cb](common::Error err, redisReply* reply) {
+    if (err) {
+      cb(err, 0);
+      return;
+    }
+
+    if (reply->type != REDIS_REPLY_INTEGER) {
+      cb(UnexpectedReply(reply), 0);
+      return;
+    }
+
+    cb(common::Error(), static_cast<keys_limit_t>(reply->integer));
+  });
+}
+
+common::Error AsyncConnection::Scan(const cursor_t& cursor_in,
+                                    const pattern_t& pattern,
+                                    keys_limit_t count_keys,
+                                    scan_callback_t cb) {
+  const commands_args_t scan_cmd = {GEN_CMD_STRING(DB_SCAN_COMMAND), common::ConvertToBytes(cursor_in.GetPosition()),
+                                     GEN_CMD_STRING("MATCH"), common::ConvertToCharBytes(pattern),
+                                     GEN_CMD_STRING("COUNT"), common::ConvertToBytes(count_keys)};
+  return ExecCommand(scan_cmd, [cb](common::Error err, redisReply* reply) {
+    if (err) {
+      cb(err, raw_keys_t(), cursor_t());
+      return;
+    }
+
+    if (reply->type != REDIS_REPLY_ARRAY || reply->elements != 2 || reply->element[0]->type != REDIS_REPLY_STRING ||
+        reply->element[1]->type != REDIS_REPLY_ARRAY) {
+      cb(UnexpectedReply(reply), raw_keys_t(), cursor_t());
+      return;
+    }
+
+    cursor_t::position_t lcursor_out;
+    const auto cursor_out_str = GEN_CMD_STRING_SIZE(reply->element[0]->str, reply->element[0]->len);
+    if (!common::ConvertFromBytes(cursor_out_str, &lcursor_out)) {
+      cb(common::make_error("I/O error"), raw_keys_t(), cursor_t());
+      return;
+    }
+
+    raw_keys_t keys;
+    redisReply* keys_reply = reply->element[1];
+    for (size_t i = 0; i < keys_reply->elements; ++i) {
+      redisReply* key = keys_reply->element[i];
+      if (key->type == REDIS_REPLY_STRING) {
+        keys.push_back(GEN_CMD_STRING_SIZE(key->str, key->len));
+      }
+    }
+
+    cb(common::Error(), keys, cursor_t(lcursor_out));
+  });
+}
+
+common::Error AsyncConnection::GetType(const NKey& key, type_callback_t cb) {
+  commands_args_t type_cmd;
+  common::Error err = translator_->GetTypeCommand(key, &type_cmd);
+  if (err) {
+    return err;
+  }
+
+  return ExecCommand(type_cmd, [cb](common::Error err, redisReply* reply) {
+    if (err) {
+      cb(err, readable_string_t());
+      return;
+    }
+
+    if (reply->type != REDIS_REPLY_STATUS) {
+      cb(UnexpectedReply(reply), readable_string_t());
+      return;
+    }
+
+    const auto type_str = GEN_CMD_STRING_SIZE(reply->str, reply->len);
+    if (type_str == GEN_CMD_STRING("none")) {
+      cb(KeyNotFound(DB_KEY_TYPE_COMMAND), readable_string_t());
+      return;
+    }
+
+    cb(common::Error(), type_str);
+  });
+}
+
+common::Error AsyncConnection::GetUni(const NKey& key, load_callback_t cb) {
+  return GetType(key, [this, key, cb](common::Error err, const readable_string_t& type_str) {
+    if (err) {
+      cb(err, NDbKValue());
+      return;
+    }
+
+    common::Value::Type type;
+    if (!ConvertFromString(type_str, &type)) {
+      cb(common::make_error("Unknown type: " + common::ConvertToString(type_str)), NDbKValue());
+      return;
+    }
+
+    commands_args_t load_cmd;
+    err = translator_->LoadKeyCommand(key, type, &load_cmd);
+    if (!err) {
+      err = ExecCommand(load_cmd, [key, type, cb](common::Error err, redisReply* reply) {
+        if (err) {
+          cb(err, NDbKValue());
+          return;
+        }
+
+        if (reply->type == REDIS_REPLY_NIL) {  // removed after TYPE
+          cb(KeyNotFound(DB_GET_KEY_COMMAND), NDbKValue());
+          return;
+        }
+
+        common::Value* val = nullptr;
+        err = TypedValueFromReplay(reply, type, &val);
+        if (err) {
+          cb(err, NDbKValue());
+          return;
+        }
+
+        cb(common::Error(), NDbKValue(key, NValue(val)));
+      });
+    }
+
+    if (err) {
+      cb(err, NDbKValue());
+    }
+  });
+}
+
+common::Error AsyncConnection::GetTTL(const NKey& key, ttl_callback_t cb) {
+  commands_args_t ttl_cmd;
+  common::Error err = translator_->LoadKeyTTLCommand(key, &ttl_cmd);
+  if (err) {
+    return err;
+  }
+
+  return ExecCommand(ttl_cmd, [cb](common::Error err, redisReply* reply) {
+    if (err) {
+      cb(err, EXPIRED_TTL);
+      return;
+    }
+
+    if (reply->type != REDIS_REPLY_INTEGER) {
+      cb(UnexpectedReply(reply), EXPIRED_TTL);
+      return;
+    }
+
+    cb(common::Error(), reply->integer);
+  });
+}
+
+common::Error AsyncConnection::Set(const NDbKValue& key, status_callback_t cb) {
+  commands_args_t set_cmd;
+  common::Error err = translator_->CreateKeyCommand(key, &set_cmd);
+  if (err) {
+    return err;
+  }
+
+  return ExecCommand(set_cmd, [cb](common::Error err, redisReply*) { cb(err); });
+}
+
+common::Error AsyncConnection::Delete(const NKey& key, status_callback_t cb) {
+  commands_args_t del_cmd;
+  common::Error err = translator_->DeleteKeyCommand(key, &del_cmd);
+  if (err) {
+    return err;
+  }
+
+  return ExecCommand(del_cmd, [cb](common::Error err, redisReply* reply) {
+    if (err) {
+      cb(err);
+      return;
+    }
+
+    if (reply->type != REDIS_REPLY_INTEGER) {
+      cb(UnexpectedReply(reply));
+      return;
+    }
+
+    cb(reply->integer == 0 ? KeyNotFound(DB_DELETE_KEY_COMMAND) : common::Error());
+  });
+}
+
+void AsyncConnection::AddRead(void* privdata) {
+  static_cast<AsyncConnection*>(privdata)->is_reading_ = true;
+}
+
+void AsyncConnection::DelRead(void* privdata) {
+  static_cast<AsyncConnection*>(privdata)->is_reading_ = false;
+}
+
+void AsyncConnection::AddWrite(void* privdata) {
+  static_cast<AsyncConnection*>(privdata)->is_writing_ = true;
+}
+
+void AsyncConnection::DelWrite(void* privdata) {
+  static_cast<AsyncConnection*>(privdata)->is_writing_ = false;
+}
+
+void AsyncConnection::Cleanup(void* privdata) {
+  AsyncConnection* self = static_cast<AsyncConnection*>(privdata);
+  self->is_reading_ = false;
+  self->is_writing_ = false;
+}
+
+void AsyncConnection::OnConnect(const redisAsyncContext* context, int status) {
+  AsyncConnection* self = static_cast<AsyncConnection*>(context->data);
+  if (status != REDIS_OK) {
+    // hiredis frees the context, the queued setup commands report the error
+    self->context_ = nullptr;
+    return;
+  }
+
+  self->is_connected_ = true;
+}
+
+void AsyncConnection::OnDisconnect(const redisAsyncContext* context, int status) {
+  UNUSED(status);
+  AsyncConnection* self = static_cast<AsyncConnection*>(context->data);
+  self->context_ = nullptr;
+  self->is_connected_ = false;
+}
+
+void AsyncConnection::OnReply(redisAsyncContext* context, void* reply, void* privdata) {
+  std::unique_ptr<reply_callback_t> cb(static_cast<reply_callback_t*>(privdata));
+  redisReply* rreply = static_cast<redisReply*>(reply);
+  if (!rreply) {  // disconnected or freed with the command in flight
+    const char* reason = context->err ? context->errstr : "Connection closed";
+    (*cb)(common::make_error(reason), nullptr);
+    return;
+  }
+
+  if (rreply->type == REDIS_REPLY_ERROR) {
+    (*cb)(common::make_error(std::string(rreply->str, rreply->len)), rreply);
+    return;
+  }
+
+  (*cb)(common::Error(), rreply);
+}
+
+void AsyncConnection::FinishConnect(common::Error err) {
+  status_callback_t on_connected = on_connected_;
+  on_connected_ = status_callback_t();
+  if (on_connected) {
+    on_connected(err);
+  }
+}
+
+}  // namespace redis_compatible
+}  // namespace core
+}  // namespace fastonosql
@@ -0,0 +1,936 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <fastonosql/core/db/redis_compatible/cluster_router.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+extern "C" {
+#include <hiredis/hiredis.h>
+}
+
+#include <common/convert2string.h>
+
+#include <fastonosql/core/db/redis_compatible/db_connection.h>
+
+namespace fastonosql {
+namespace core {
+namespace redis_compatible {
+
+namespace {
+const size_t kNoNode = std::numeric_limits<size_t>::max();
+
+const char* const kKeylessCommands[] = {
+    "ACL", "ASKING", "AUTH", "BGREWRITEAOF", "BGSAVE", "CLIENT", "CLUSTER", "COMMAND", "CONFIG", "DBSIZE", "DEBUG",
+    "DISCARD", "ECHO", "EXEC", "FLUSHALL", "FLUSHDB", "HELLO", "INFO", "KEYS", "LASTSAVE", "LATENCY", "LOLWUT",
+    "MODULE", "MONITOR", "MULTI", "PING", "PSUBSCRIBE", "PSYNC", "PUBLISH", "PUBSUB", "PUNSUBSCRIBE", "QUIT",
+    "RANDOMKEY", "READONLY", "READWRITE", "REPLICAOF", "ROLE", "SAVE", "SCAN", "SCRIPT", "SELECT", "SHUTDOWN",
+    "SLAVEOF", "SLOWLOG", "SUBSCRIBE", "SWAPDB", "SYNC", "TIME", "UNSUBSCRIBE", "UNWATCH", "WAIT"};
+
+// keyed reads that replicas serve after READONLY
+const char* const kReadOnlyCommands[] = {
+    "BITCOUNT", "BITPOS", "DUMP", "EXISTS", "GET", "GETBIT", "GETRANGE", "HEXISTS", "HGET", "HGETALL", "HKEYS",
+    "HLEN", "HMGET", "HSCAN", "HSTRLEN", "HVALS", "LINDEX", "LLEN", "LRANGE", "MGET", "PTTL", "SCARD", "SISMEMBER",
+    "SMEMBERS", "SRANDMEMBER", "SSCAN", "STRLEN", "TTL", "TYPE", "XLEN", "XRANGE", "XREVRANGE", "ZCARD", "ZCOUNT",
+    "ZRANGE", "ZRANGEBYLEX", "ZRANGEBYSCORE", "ZRANK", "ZREVRANGE", "ZREVRANGEBYSCORE", "ZREVRANK", "ZSCAN", "ZSCORE"};
+
+bool IsCommand(const command_buffer_t& arg, const char* name) {
+  const size_t len = strlen(name);
+  return arg.size() == len && strncasecmp(arg.data(), name, len) == 0;
+}
+
+struct Crc16Table {
+  Crc16Table() {
+    for (uint16_t i = 0; i < 256; ++i) {
+      uint16_t crc = i << 8;
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+      }
+      values[i] = crc;
+    }
+  }
+
+  uint16_t values[256];
+};
+
+struct Redirect {
+  bool is_ask;
+  uint16_t slot;
+  common::net::HostAndPort host;
+};
+
+// "MOVED 3999 127.0.0.1:6381" or "ASK 3999 127.0.0.1:6381"
+bool ParseRedirect(redisReply* reply, Redirect* out) {
+  if (reply->type != REDIS_REPLY_ERROR) {
+    return false;
+  }
+
+  const std::string str(reply->str, reply->len);
+  bool is_ask = false;
+  if (str.compare(0, 6, "MOVED ") == 0) {
+    is_ask = false;
+  } else if (str.compare(0, 4, "ASK ") == 0) {
+    is_ask = true;
+  } else {
+    return false;
+  }
+
+  const size_t slot_pos = str.find(' ') + 1;
+  const size_t host_pos = str.find(' ', slot_pos);
+  const size_t port_pos = str.rfind(':');
+  if (host_pos == std::string::npos || port_pos == std::string::npos || port_pos < host_pos) {
+    return false;
+  }
+
+  uint16_t slot;
+  uint16_t port;
+  if (!common::ConvertFromString(str.substr(slot_pos, host_pos - slot_pos), &slot) ||
+      !common::ConvertFromString(str.substr(port_pos + 1), &port)) {
+    return false;
+  }
+
+  out->is_ask = is_ask;
+  out->slot = slot;
+  out->host = common::net::HostAndPort(str.substr(host_pos + 1, port_pos - host_pos - 1), port);
+  return true;
+}
+
+bool IsSameHost(const common::net::HostAndPort& left, const common::net::HostAndPort& right) {
+  return left.GetHost() == right.GetHost() && left.GetPort() == right.GetPort();
+}
+
+// error replies are returned as replies, the caller decides about redirects
+common::Error SendCommand(redisContext* context, const commands_args_t& argv, redisReply** out_reply) {
+  std::vector<const char*> argvc(argv.size());
+  std::vector<size_t> argvlen(argv.size());
+  for (size_t i = 0; i < argv.size(); ++i) {
+    argvc[i] = argv[i].data();
+    argvlen[i] = argv[i].size();
+  }
+
+  if (redisAppendCommandArgv(context, argv.size(), argvc.data(), argvlen.data()) == REDIS_ERR) {
+    return PrintRedisContextError(context);
+  }
+
+  void* reply = nullptr;
+  if (redisGetReply(context, &reply) == REDIS_ERR) {
+    return PrintRedisContextError(context);
+  }
+
+  *out_reply = static_cast<redisReply*>(reply);
+  return common::Error();
+}
+}  // namespace
+
+uint16_t Crc16(const char* buf, size_t len) {
+  static const Crc16Table table;
+  uint16_t crc = 0;
+  for (size_t i = 0; i < len; ++i) {
+    crc = (crc << 8) ^ table.values[((crc >> 8) ^ static_cast<uint8_t>(buf[i])) & 0xff];
+  }
+  return crc;
+}
+
+uint16_t KeyHashSlot(const char* key, size_t len) {
+  size_t start = 0;
+  while (start < len && key[start] != '{') {
+    start++;
+  }
+
+  // only the part between the first { and the next } is hashed, unless it is empty or missing
+  if (start != len) {
+    size_t end = start + 1;
+    while (end < len && key[end] != '}') {
+      end++;
+    }
+
+    if (end != len && end != start + 1) {
+      return Crc16(key + start + 1, end - start - 1) & (cluster_slots_count - 1);
+    }
+  }
+
+  return Crc16(key, len) & (cluster_slots_count - 1);
+}
+
+bool IsReadOnlyCommand(const commands_args_t& argv) {
+  if (argv.empty()) {
+    return false;
+  }
+
+  for (const char* read_only : kReadOnlyCommands) {
+    if (IsCommand(argv[0], read_only)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t KeyArgIndex(const commands_args_t& argv) {
+  if (argv.size() < 2) {
+    return 0;
+  }
+
+  const command_buffer_t& name = argv[0];
+  for (const char* keyless : kKeylessCommands) {
+    if (IsCommand(name, keyless)) {
+      return 0;
+    }
+  }
+
+  if (IsCommand(name, "EVAL") || IsCommand(name, "EVALSHA")) {  // EVAL script numkeys key...
+    return argv.size() > 3 && !IsCommand(argv[2], "0") ? 3 : 0;
+  }
+
+  if (IsCommand(name, "OBJECT") || IsCommand(name, "XINFO") || IsCommand(name, "MEMORY")) {  // subcommand key
+    return argv.size() > 2 ? 2 : 0;
+  }
+
+  if (IsCommand(name, "XREAD") || IsCommand(name, "XREADGROUP")) {  // ... STREAMS key...
+    for (size_t i = 1; i + 1 < argv.size(); ++i) {
+      if (IsCommand(argv[i], "STREAMS")) {
+        return i + 1;
+      }
+    }
+    return 0;
+  }
+
+  return 1;
+}
+
+cursor_t MakeClusterCursor(const node_cursors_t& nodes) {
+  if (nodes.empty()) {
+    return cursor_t();
+  }
+
+  // host:port cursor,host:port cursor...
+  std::string token;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    if (i != 0) {
+      token += ',';
+    }
+    token += common::ConvertToString(nodes[i].first) + ' ' + common::ConvertToString(nodes[i].second);
+  }
+  return cursor_t(nodes.size(), common::ConvertToCharBytes(token));
+}
+
+bool ParseClusterCursor(const cursor_t& cursor, node_cursors_t* nodes) {
+  if (!nodes || !cursor.HasToken()) {
+    return false;
+  }
+
+  const cursor_t::token_t token = cursor.GetToken();
+  const std::string str(token.begin(), token.end());
+  node_cursors_t lnodes;
+  size_t start = 0;
+  while (start <= str.size()) {
+    size_t stop = str.find(',', start);
+    if (stop == std::string::npos) {
+      stop = str.size();
+    }
+
+    const std::string entry = str.substr(start, stop - start);
+    const size_t space = entry.rfind(' ');
+    if (space == std::string::npos) {
+      return false;
+    }
+
+    common::net::HostAndPort host;
+    cursor_t::position_t position;
+    if (!common::ConvertFromString(entry.substr(0, space), &host) ||
+        !common::ConvertFromString(entry.substr(space + 1), &position)) {
+      return false;
+    }
+
+    lnodes.push_back(std::make_pair(host, position));
+    start = stop + 1;
+  }
+
+  if (lnodes.size() != cursor.GetPosition()) {
+    return false;
+  }
+
+  *nodes = lnodes;
+  return true;
+}
+
+ClusterRouter::ClusterRouter(const Config& config, const SSHInfo& sinfo)
+    : config_(config),
+      sinfo_(sinfo),
+      seed_(nullptr),
+      is_cluster_(false),
+      next_replica_(0),
+      nodes_(),
+      ranges_(),
+      slots_(cluster_slots_count, kNoNode) {}
+
+ClusterRouter::~ClusterRouter() {
+  for (Node& node : nodes_) {
+    if (node.context && node.context != seed_) {
+      redisFree(node.context);
+    }
+  }
+}
+
+common::Error ClusterRouter::LoadSlots(redisContext* seed) {
+  if (!seed) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  seed_ = seed;
+  is_cluster_ = true;
+  redisReply* reply = nullptr;
+  common::Error err = ExecRedisCommand(seed_, commands_args_t{GEN_CMD_STRING("CLUSTER"), GEN_CMD_STRING("SLOTS")},
+                                       &reply);
+  if (err) {
+    return err;
+  }
+
+  if (reply->type != REDIS_REPLY_ARRAY || reply->elements == 0) {
+    freeReplyObject(reply);
+    return common::make_error("Cluster has no slots assigned");
+  }
+
+  // [start, end, [ip, port, id], [replica ip, port, id]...]
+  std::vector<SlotRange> ranges;
+  for (size_t i = 0; i < reply->elements; ++i) {
+    redisReply* entry = reply->element[i];
+    if (entry->type != REDIS_REPLY_ARRAY || entry->elements < 3) {
+      continue;
+    }
+
+    SlotRange range;
+    range.start = entry->element[0]->integer;
+    range.end = entry->element[1]->integer;
+    range.master = kNoNode;
+    for (size_t j = 2; j < entry->elements; ++j) {
+      redisReply* node = entry->element[j];
+      if (node->type != REDIS_REPLY_ARRAY || node->elements < 2) {
+        continue;
+      }
+
+      std::string host(node->element[0]->str, node->element[0]->len);
+      if (host.empty()) {  // unknown endpoint, same as the one we asked
+        host = config_.host.GetHost();
+      }
+      const size_t index = FindOrAddNode(common::net::HostAndPort(host, node->element[1]->integer));
+      if (j == 2) {
+        range.master = index;
+      } else {
+        range.replicas.push_back(index);
+      }
+    }
+    ranges.push_back(range);
+  }
+  freeReplyObject(reply);
+
+  std::fill(slots_.begin(), slots_.end(), kNoNode);
+  for (const SlotRange& range : ranges) {
+    for (size_t slot = range.start; slot <= range.end && slot < slots_.size(); ++slot) {
+      slots_[slot] = range.master;
+    }
+  }
+  ranges_ = ranges;
+  UpdateReplicas();
+  return common::Error();
+}
+
+common::Error ClusterRouter::LoadReplicas(redisContext* seed) {
+  if (!seed) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  seed_ = seed;
+  is_cluster_ = false;
+  redisReply* reply = nullptr;
+  common::Error err = ExecRedisCommand(seed_, commands_args_t{GEN_CMD_STRING("ROLE")}, &reply);
+  if (err) {
+    return err;
+  }
+
+  // ["master", offset, [[ip, port, offset]...]]
+  if (reply->type != REDIS_REPLY_ARRAY || reply->elements < 3 || reply->element[0]->type != REDIS_REPLY_STRING ||
+      strcmp(reply->element[0]->str, "master") != 0 || reply->element[2]->type != REDIS_REPLY_ARRAY) {
+    freeReplyObject(reply);
+    return common::make_error("Not a master");
+  }
+
+  SlotRange range;
+  range.start = 0;
+  range.end = cluster_slots_count - 1;
+  range.master = FindOrAddNode(config_.host);
+  redisReply* replicas = reply->element[2];
+  for (size_t i = 0; i < replicas->elements; ++i) {
+    redisReply* replica = replicas->element[i];
+    if (replica->type != REDIS_REPLY_ARRAY || replica->elements < 2 ||
+        replica->element[0]->type != REDIS_REPLY_STRING || replica->element[1]->type != REDIS_REPLY_STRING) {
+      continue;
+    }
+
+    uint16_t port;
+    if (common::ConvertFromString(std::string(replica->element[1]->str, replica->element[1]->len), &port)) {
+      const std::string host(replica->element[0]->str, replica->element[0]->len);
+      range.replicas.push_back(FindOrAddNode(common::net::HostAndPort(host, port)));
+    }
+  }
+  freeReplyObject(reply);
+
+  if (range.replicas.empty()) {
+    return common::make_error("Master has no replicas");
+  }
+
+  std::fill(slots_.begin(), slots_.end(), range.master);
+  ranges_ = std::vector<SlotRange>(1, range);
+  UpdateReplicas();
+  return common::Error();
+}
+
+bool ClusterRouter::IsCluster() const {
+  return is_cluster_;
+}
+
+void ClusterRouter::SelectDB(int num) {
+  config_.db_num = num;
+  if (is_cluster_) {
+    return;
+  }
+
+  for (Node& node : nodes_) {
+    if (node.context && node.context != seed_) {
+      redisFree(node.context);
+      node.context = nullptr;
+    }
+  }
+}
+
+common::Error ClusterRouter::ExecCommand(const commands_args_t& argv, redisReply** out_reply) {
+  return ExecCommandImpl(argv, IsReadOnlyCommand(argv), out_reply);
+}
+
+common::Error ClusterRouter::ExecReadCommand(const commands_args_t& argv, redisReply** out_reply) {
+  return ExecCommandImpl(argv, true, out_reply);
+}
+
+common::Error ClusterRouter::ExecCommandImpl(const commands_args_t& argv, bool read_only, redisReply** out_reply) {
+  if (argv.empty() || !out_reply) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  size_t node = GetNodeForArgs(argv, read_only);
+  bool asking = false;
+  bool refreshed = false;
+  for (size_t redirects = 0; redirects < max_redirects; ++redirects) {
+    redisContext* context = seed_;
+    if (node != kNoNode) {
+      common::Error err = GetNodeContext(node, &context);
+      if (err && nodes_[node].is_replica) {  // replica is gone, its master serves the read
+        DropReplica(node);
+        node = GetNodeForArgs(argv, read_only);
+        continue;
+      }
+      if (err) {
+        if (refreshed || !RefreshAfterFailure()) {
+          return err;
+        }
+        refreshed = true;
+        node = GetNodeForArgs(argv, read_only);
+        continue;
+      }
+    }
+
+    redisReply* reply = nullptr;
+    if (asking) {  // one shot permission for a slot being migrated
+      common::Error err = SendCommand(context, commands_args_t{GEN_CMD_STRING("ASKING")}, &reply);
+      if (err) {
+        return err;
+      }
+      freeReplyObject(reply);
+      reply = nullptr;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    common::Error err = SendCommand(context, argv, &reply);
+    if (err && node != kNoNode && nodes_[node].is_replica) {  // replica died after connecting, read from the primary
+      DropReplica(node);
+      node = GetNodeForArgs(argv, false);
+      continue;
+    }
+    if (err) {
+      // the node may be gone after a failover, ask the cluster once who owns the slot now
+      if (refreshed || node == kNoNode || context == seed_ || !RefreshAfterFailure()) {
+        return err;
+      }
+      refreshed = true;
+      node = GetNodeForArgs(argv, read_only);
+      continue;
+    }
+
+    if (node != kNoNode && nodes_[node].is_replica) {
+      const auto elapsed = std::chrono::steady_clock::now() - start;
+      UpdateLatency(node, std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    }
+
+    Redirect redirect;
+    if (ParseRedirect(reply, &redirect)) {
+      freeReplyObject(reply);
+      asking = redirect.is_ask;
+      if (!asking) {  // slot moved for good, our map is stale
+        err = RefreshSlots();
+        if (err) {
+          return err;
+        }
+      }
+      node = FindOrAddNode(redirect.host);
+      if (!asking) {
+        slots_[redirect.slot] = node;
+      }
+      continue;
+    }
+
+    if (reply->type == REDIS_REPLY_ERROR) {
+      std::string str(reply->str, reply->len);
+      freeReplyObject(reply);
+      return common::make_error(str);
+    }
+
+    *out_reply = reply;
+    return common::Error();
+  }
+
+  return common::make_error("Too many cluster redirects");
+}
+
+common::Error ClusterRouter::ExecPipeline(const std::vector<commands_args_t>& cmds,
+                                          size_t window,
+                                          reply_callback_t on_reply) {
+  if (window == 0 || !on_reply) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  // last bucket is the seed for keyless commands
+  std::vector<std::vector<size_t>> buckets(nodes_.size() + 1);
+  for (size_t i = 0; i < cmds.size(); ++i) {
+    const size_t node = GetNodeForArgs(cmds[i], IsReadOnlyCommand(cmds[i]));
+    buckets[node == kNoNode ? nodes_.size() : node].push_back(i);
+  }
+
+  std::vector<size_t> redirected;
+  std::vector<size_t> failed_over;  // read from a replica that went away
+  std::vector<const char*> argvc;
+  std::vector<size_t> argvlen;
+  for (size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+    const std::vector<size_t>& indexes = buckets[bucket];
+    if (indexes.empty()) {
+      continue;
+    }
+
+    redisContext* context = seed_;
+    const bool is_replica = bucket != buckets.size() - 1 && nodes_[bucket].is_replica;
+    if (bucket != buckets.size() - 1) {
+      common::Error err = GetNodeContext(bucket, &context);
+      if (err && is_replica) {
+        DropReplica(bucket);
+        failed_over.insert(failed_over.end(), indexes.begin(), indexes.end());
+        continue;
+      }
+      if (err) {
+        return err;
+      }
+    }
+
+    bool replica_failed = false;
+    for (size_t start = 0; start < indexes.size() && !replica_failed; start += window) {
+      const size_t stop = std::min(indexes.size(), start + window);
+      for (size_t i = start; i < stop; ++i) {
+        const commands_args_t& argv = cmds[indexes[i]];
+        argvc.resize(argv.size());
+        argvlen.resize(argv.size());
+        for (size_t j = 0; j < argv.size(); ++j) {
+          argvc[j] = argv[j].data();
+          argvlen[j] = argv[j].size();
+        }
+
+        if (redisAppendCommandArgv(context, argv.size(), argvc.data(), argvlen.data()) == REDIS_ERR) {
+          return PrintRedisContextError(context);
+        }
+      }
+
+      // always read the whole window, otherwise later replies get out of sync
+      common::Error first_err;
+      for (size_t i = start; i < stop; ++i) {
+        void* reply = nullptr;
+        if (redisGetReply(context, &reply) == REDIS_ERR) {
+          if (is_replica) {
+            // the rest of the bucket is read from the primary, replies already handled are not repeated
+            DropReplica(bucket);
+            failed_over.insert(failed_over.end(), indexes.begin() + i, indexes.end());
+            replica_failed = true;
+            break;
+          }
+
+          common::Error err = PrintRedisContextError(context);
+          if (context != seed_) {
+            RefreshAfterFailure();
+          }
+          return err;
+        }
+
+        redisReply* rreply = static_cast<redisReply*>(reply);
+        Redirect redirect;
+        if (ParseRedirect(rreply, &redirect)) {
+          redirected.push_back(indexes[i]);
+        } else if (!first_err) {
+          if (rreply->type == REDIS_REPLY_ERROR) {
+            first_err = common::make_error(std::string(rreply->str, rreply->len));
+          } else {
+            first_err = on_reply(indexes[i], rreply);
+          }
+        }
+        freeReplyObject(rreply);
+      }
+
+      if (first_err) {
+        return first_err;
+      }
+    }
+  }
+
+  // resend one by one, ExecCommand follows the redirect and refreshes the map,
+  // commands of a dropped replica go to their primary
+  const size_t redirected_count = redirected.size();
+  redirected.insert(redirected.end(), failed_over.begin(), failed_over.end());
+  for (size_t i = 0; i < redirected.size(); ++i) {
+    const size_t index = redirected[i];
+    const bool read_only = i < redirected_count && IsReadOnlyCommand(cmds[index]);
+    redisReply* reply = nullptr;
+    common::Error err = ExecCommandImpl(cmds[index], read_only, &reply);
+    if (err) {
+      return err;
+    }
+
+    err = on_reply(index, reply);
+    freeReplyObject(reply);
+    if (err) {
+      return err;
+    }
+  }
+
+  return common::Error();
+}
+
+common::Error ClusterRouter::ExecOnNodes(const std::vector<common::net::HostAndPort>& hosts,
+                                         const std::vector<commands_args_t>& cmds,
+                                         reply_callback_t on_reply) {
+  if (hosts.size() != cmds.size() || !on_reply) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  // every context is opened before the first append, so a failed connect leaves nothing pending anywhere
+  std::vector<size_t> nodes(hosts.size());
+  std::vector<redisContext*> contexts(hosts.size(), nullptr);
+  for (size_t i = 0; i < hosts.size(); ++i) {
+    nodes[i] = FindOrAddNode(hosts[i]);
+    common::Error err = GetNodeContext(nodes[i], &contexts[i]);
+    if (err) {
+      RefreshAfterFailure();
+      return err;
+    }
+  }
+
+  std::vector<const char*> argvc;
+  std::vector<size_t> argvlen;
+  for (size_t i = 0; i < contexts.size(); ++i) {
+    const commands_args_t& argv = cmds[i];
+    argvc.resize(argv.size());
+    argvlen.resize(argv.size());
+    for (size_t j = 0; j < argv.size(); ++j) {
+      argvc[j] = argv[j].data();
+      argvlen[j] = argv[j].size();
+    }
+
+    if (redisAppendCommandArgv(contexts[i], argv.size(), argvc.data(), argvlen.data()) == REDIS_ERR) {
+      common::Error err = PrintRedisContextError(contexts[i]);
+      DiscardPending(nodes, contexts, 0, i);
+      return err;
+    }
+  }
+
+  // redisGetReply flushes the output buffer of its context first
+  for (redisContext* context : contexts) {
+    int done = 0;
+    while (!done) {
+      if (redisBufferWrite(context, &done) == REDIS_ERR) {
+        common::Error err = PrintRedisContextError(context);
+        DiscardPending(nodes, contexts, 0, contexts.size());
+        RefreshAfterFailure();
+        return err;
+      }
+    }
+  }
+
+  common::Error first_err;
+  for (size_t i = 0; i < contexts.size(); ++i) {
+    void* reply = nullptr;
+    if (redisGetReply(contexts[i], &reply) == REDIS_ERR) {
+      common::Error err = PrintRedisContextError(contexts[i]);
+      DiscardPending(nodes, contexts, i, contexts.size());
+      RefreshAfterFailure();
+      return err;
+    }
+
+    redisReply* rreply = static_cast<redisReply*>(reply);
+    if (!first_err) {
+      if (rreply->type == REDIS_REPLY_ERROR) {
+        first_err = common::make_error(std::string(rreply->str, rreply->len));
+      } else {
+        first_err = on_reply(i, rreply);
+      }
+    }
+    freeReplyObject(rreply);
+  }
+
+  return first_err;
+}
+
+void ClusterRouter::DiscardPending(const std::vector<size_t>& nodes,
+                                   const std::vector<redisContext*>& contexts,
+                                   size_t from,
+                                   size_t to) {
+  for (size_t i = from; i < to; ++i) {
+    redisContext* context = contexts[i];
+    if (context == seed_) {  // shared with the connection, its replies are read and dropped
+      void* reply = nullptr;
+      if (!seed_->err && redisGetReply(seed_, &reply) == REDIS_OK) {
+        freeReplyObject(reply);
+      }
+      continue;
+    }
+
+    if (nodes_[nodes[i]].context == context) {  // a node listed twice is freed once
+      redisFree(context);
+      nodes_[nodes[i]].context = nullptr;
+    }
+  }
+}
+
+std::vector<common::net::HostAndPort> ClusterRouter::GetMasters() const {
+  std::vector<common::net::HostAndPort> masters;
+  std::vector<size_t> seen;
+  for (const SlotRange& range : ranges_) {
+    if (range.master == kNoNode || std::find(seen.begin(), seen.end(), range.master) != seen.end()) {
+      continue;
+    }
+    seen.push_back(range.master);
+    masters.push_back(nodes_[range.master].host);
+  }
+  return masters;
+}
+
+size_t ClusterRouter::GetMastersCount() const {
+  return GetMasters().size();
+}
+
+std::vector<common::net::HostAndPort> ClusterRouter::GetReadNodes() {
+  std::vector<common::net::HostAndPort> nodes;
+  std::vector<size_t> seen;
+  for (const SlotRange& range : ranges_) {
+    if (range.master == kNoNode || std::find(seen.begin(), seen.end(), range.master) != seen.end()) {
+      continue;
+    }
+    seen.push_back(range.master);
+    nodes.push_back(nodes_[PickReadNode(range.master)].host);
+  }
+  return nodes;
+}
+
+common::net::HostAndPort ClusterRouter::GetSlotMaster(uint16_t slot) const {
+  if (slot >= slots_.size() || slots_[slot] == kNoNode) {
+    return common::net::HostAndPort();
+  }
+  return nodes_[slots_[slot]].host;
+}
+
+size_t ClusterRouter::FindOrAddNode(const common::net::HostAndPort& host) {
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    if (IsSameHost(nodes_[i].host, host)) {
+      return i;
+    }
+  }
+
+  Node node;
+  node.host = host;
+  node.context = IsSameHost(host, config_.host) ? seed_ : nullptr;  // do not open the seed twice
+  node.is_replica = false;
+  node.latency_us = 0;
+  nodes_.push_back(node);
+  return nodes_.size() - 1;
+}
+
+common::Error ClusterRouter::GetNodeContext(size_t node, redisContext** context) {
+  if (node >= nodes_.size()) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  redisContext* cached = nodes_[node].context;
+  if (cached && cached->err && cached != seed_) {  // broken by an earlier i/o error, reconnect
+    redisFree(cached);
+    nodes_[node].context = nullptr;
+    cached = nullptr;
+  }
+
+  if (cached) {  // a broken seed belongs to the connection, its own failover logic reconnects it
+    *context = cached;
+    return common::Error();
+  }
+
+  Config node_config = config_;
+  node_config.host = nodes_[node].host;
+  node_config.hostsocket.clear();
+  redisContext* lcontext = nullptr;
+  common::Error err = CreateConnection(node_config, sinfo_, &lcontext);
+  if (err) {
+    return err;
+  }
+
+  err = AuthContext(lcontext, common::ConvertToCharBytes(config_.auth));
+  if (err) {
+    redisFree(lcontext);
+    return err;
+  }
+
+  if (nodes_[node].is_replica) {
+    // cluster replicas redirect reads to their master without READONLY,
+    // replicas of a plain master need the database we work with
+    commands_args_t setup_cmd = {GEN_CMD_STRING("READONLY")};
+    if (!is_cluster_) {
+      setup_cmd = {GEN_CMD_STRING("SELECT"), common::ConvertToCharBytes(config_.db_num)};
+    }
+
+    redisReply* reply = nullptr;
+    const auto start = std::chrono::steady_clock::now();
+    err = ExecRedisCommand(lcontext, setup_cmd, &reply);
+    if (err) {
+      redisFree(lcontext);
+      return err;
+    }
+    freeReplyObject(reply);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    UpdateLatency(node, std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+  }
+
+  nodes_[node].context = lcontext;
+  *context = lcontext;
+  return common::Error();
+}
+
+size_t ClusterRouter::GetNodeForArgs(const commands_args_t& argv, bool read_only) {
+  const size_t key_index = KeyArgIndex(argv);
+  if (key_index == 0 || key_index >= argv.size()) {
+    return kNoNode;
+  }
+
+  const command_buffer_t& key = argv[key_index];
+  const size_t master = slots_[KeyHashSlot(key.data(), key.size())];
+  if (!read_only || master == kNoNode) {
+    return master;
+  }
+  return PickReadNode(master);
+}
+
+size_t ClusterRouter::PickReadNode(size_t master) {
+  const std::vector<size_t>& replicas = nodes_[master].replicas;
+  if (config_.read_from == Config::READ_FROM_MASTER || replicas.empty()) {
+    return master;
+  }
+
+  if (config_.read_from == Config::READ_FROM_REPLICA_ROUND_ROBIN) {
+    return replicas[next_replica_++ % replicas.size()];
+  }
+
+  // not measured yet counts as fastest, so every replica gets tried once
+  size_t best = replicas[0];
+  for (size_t replica : replicas) {
+    if (nodes_[replica].latency_us < nodes_[best].latency_us) {
+      best = replica;
+    }
+  }
+  return best;
+}
+
+void ClusterRouter::UpdateLatency(size_t node, uint64_t latency_us) {
+  uint64_t& latency = nodes_[node].latency_us;
+  latency = latency == 0 ? std::max<uint64_t>(latency_us, 1) : (latency * 7 + latency_us) / 8;
+}
+
+void ClusterRouter::UpdateReplicas() {
+  for (Node& node : nodes_) {
+    node.is_replica = false;
+    node.replicas.clear();
+  }
+
+  for (const SlotRange& range : ranges_) {
+    if (range.master == kNoNode) {
+      continue;
+    }
+
+    std::vector<size_t>& replicas = nodes_[range.master].replicas;
+    for (size_t replica : range.replicas) {
+      nodes_[replica].is_replica = true;
+      if (std::find(replicas.begin(), replicas.end(), replica) == replicas.end()) {
+        replicas.push_back(replica);
+      }
+    }
+  }
+}
+
+void ClusterRouter::DropReplica(size_t node) {
+  for (Node& master : nodes_) {
+    master.replicas.erase(std::remove(master.replicas.begin(), master.replicas.end(), node), master.replicas.end());
+  }
+
+  if (nodes_[node].context && nodes_[node].context != seed_) {
+    redisFree(nodes_[node].context);
+    nodes_[node].context = nullptr;
+  }
+}
+
+common::Error ClusterRouter::RefreshSlots() {
+  if (!seed_ || seed_->err) {
+    return common::make_error("Seed node is not connected");
+  }
+
+  return is_cluster_ ? LoadSlots(seed_) : LoadReplicas(seed_);
+}
+
+bool ClusterRouter::RefreshAfterFailure() {
+  common::Error err = RefreshSlots();
+  return !err;
+}
+
+}  // namespace redis_compatible
+}  // namespace core
+}  // namespace fastonosql
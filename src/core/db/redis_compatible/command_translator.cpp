@@ -92,9 +92,52 @@
 
 #define REDIS_UNLINK_COMMAND "UNLINK"
 
+#define REDIS_LLEN "LLEN"
+#define REDIS_SCARD "SCARD"
+#define REDIS_HLEN "HLEN"
+#define REDIS_ZCARD "ZCARD"
+
+#define REDIS_SSCAN "SSCAN"
+#define REDIS_HSCAN "HSCAN"
+#define REDIS_ZSCAN "ZSCAN"
+
 namespace fastonosql {
 namespace core {
 namespace redis_compatible {
+namespace {
+
+void AppendValueArgs(common::Value* value, commands_args_t* argv) {
+  common::Value::Type type = value->GetType();
+  if (type == common::Value::TYPE_ARRAY) {
+    common::ArrayValue* array = static_cast<common::ArrayValue*>(value);
+    for (auto it = array->begin(); it != array->end(); ++it) {
+      argv->push_back(ConvertValue(*it, NValue::default_delimiter));
+    }
+  } else if (type == common::Value::TYPE_SET) {
+    common::SetValue* set = static_cast<common::SetValue*>(value);
+    for (auto it = set->begin(); it != set->end(); ++it) {
+      argv->push_back(ConvertValue(*it, NValue::default_delimiter));
+    }
+  } else if (type == common::Value::TYPE_ZSET) {
+    common::ZSetValue* zset = static_cast<common::ZSetValue*>(value);
+    for (auto it = zset->begin(); it != zset->end(); ++it) {
+      auto v = *it;
+      argv->push_back(ConvertValue(v.first, NValue::default_delimiter));
+      argv->push_back(ConvertValue(v.second, NValue::default_delimiter));
+    }
+  } else if (type == common::Value::TYPE_HASH) {
+    common::HashValue* hash = static_cast<common::HashValue*>(value);
+    for (auto it = hash->begin(); it != hash->end(); ++it) {
+      auto v = *it;
+      argv->push_back(v.first);
+      argv->push_back(ConvertValue(v.second, NValue::default_delimiter));
+    }
+  } else {
+    argv->push_back(ConvertValue(value, NValue::default_delimiter));
+  }
+}
+
+}  // namespace
 
 CommandTranslator::CommandTranslator(const std::vector<CommandHolder>& commands) : ICommandTranslator(commands) {}
 
@@ -203,6 +246,17 @@ common::Error CommandTranslator::Lrange(const NKey& key, int start, int stop, co
   return common::Error();
 }
 
+common::Error CommandTranslator::Lrange(const NKey& key, int start, int stop, commands_args_t* argv) {
+  if (!argv) {
+    return common::make_error_inval();
+  }
+
+  const auto key_str = key.GetKey();
+  *argv = {GEN_CMD_STRING(REDIS_LRANGE), key_str.GetData(), common::ConvertToBytes(start),
+           common::ConvertToBytes(stop)};
+  return common::Error();
+}
+
 common::Error CommandTranslator::Append(const NKey& key, const NValue& value, command_buffer_t* cmdstring) {
   if (!cmdstring || !value) {
     return common::make_error_inval();
@@ -394,6 +448,12 @@ common::Error CommandTranslator::Unlink(const NKey& key, command_buffer_t* cmdst
   return common::Error();
 }
 
+common::Error CommandTranslator::Unlink(const NKey& key, commands_args_t* argv) {
+  const auto key_str = key.GetKey();
+  *argv = {GEN_CMD_STRING(REDIS_UNLINK_COMMAND), key_str.GetData()};
+  return common::Error();
+}
+
 common::Error CommandTranslator::ZpopMax(const NKey& key, size_t count, command_buffer_t* cmdstring) {
   const auto key_str = key.GetKey();
   command_buffer_writer_t wr;
@@ -410,6 +470,60 @@ common::Error CommandTranslator::ZpopMin(const NKey& key, size_t count, command_
   return common::Error();
 }
 
+common::Error CommandTranslator::CollectionSize(const NKey& key, common::Value::Type type, commands_args_t* argv) {
+  if (!argv) {
+    return common::make_error_inval();
+  }
+
+  const auto key_str = key.GetKey();
+  if (type == common::Value::TYPE_ARRAY) {
+    *argv = {GEN_CMD_STRING(REDIS_LLEN), key_str.GetData()};
+  } else if (type == common::Value::TYPE_SET) {
+    *argv = {GEN_CMD_STRING(REDIS_SCARD), key_str.GetData()};
+  } else if (type == common::Value::TYPE_HASH) {
+    *argv = {GEN_CMD_STRING(REDIS_HLEN), key_str.GetData()};
+  } else if (type == common::Value::TYPE_ZSET) {
+    *argv = {GEN_CMD_STRING(REDIS_ZCARD), key_str.GetData()};
+  } else {
+    return common::make_error(common::MemSPrintf("Size of type: %s is not supported.", GetTypeName(type)));
+  }
+
+  return common::Error();
+}
+
+common::Error CommandTranslator::CollectionScan(const NKey& key,
+                                                common::Value::Type type,
+                                                cursor_t::position_t cursor,
+                                                keys_limit_t count,
+                                                commands_args_t* argv) {
+  if (!argv || count == 0) {
+    return common::make_error_inval();
+  }
+
+  const auto key_str = key.GetKey();
+  if (type == common::Value::TYPE_ARRAY) {  // lists have no cursor, the position is an index
+    const cursor_t::position_t stop = cursor + count - 1;
+    *argv = {GEN_CMD_STRING(REDIS_LRANGE), key_str.GetData(), common::ConvertToBytes(cursor),
+             common::ConvertToBytes(stop)};
+    return common::Error();
+  }
+
+  command_buffer_t scan_cmd;
+  if (type == common::Value::TYPE_SET) {
+    scan_cmd = GEN_CMD_STRING(REDIS_SSCAN);
+  } else if (type == common::Value::TYPE_HASH) {
+    scan_cmd = GEN_CMD_STRING(REDIS_HSCAN);
+  } else if (type == common::Value::TYPE_ZSET) {
+    scan_cmd = GEN_CMD_STRING(REDIS_ZSCAN);
+  } else {
+    return common::make_error(common::MemSPrintf("Scan of type: %s is not supported.", GetTypeName(type)));
+  }
+
+  *argv = {scan_cmd, key_str.GetData(), common::ConvertToBytes(cursor), GEN_CMD_STRING("COUNT"),
+           common::ConvertToBytes(count)};
+  return common::Error();
+}
+
 common::Error CommandTranslator::CreateKeyCommandImpl(const NDbKValue& key, command_buffer_t* cmdstring) const {
   const NKey cur = key.GetKey();
   const auto key_str = cur.GetKey();
@@ -536,6 +650,105 @@ common::Error CommandTranslator::LoadKeyTTLCommandImpl(const NKey& key, command_
   return common::Error();
 }
 
+common::Error CommandTranslator::CreateKeyCommandArgsImpl(const NDbKValue& key, commands_args_t* argv) const {
+  const NKey cur = key.GetKey();
+  const auto key_str = cur.GetKey();
+  const NValue value = key.GetValue();
+  common::Value::Type type = key.GetType();
+
+  commands_args_t result;
+  if (type == common::Value::TYPE_ARRAY) {
+    result = {GEN_CMD_STRING(REDIS_SET_KEY_ARRAY_COMMAND), key_str.GetData()};
+  } else if (type == common::Value::TYPE_SET) {
+    result = {GEN_CMD_STRING(REDIS_SET_KEY_SET_COMMAND), key_str.GetData()};
+  } else if (type == common::Value::TYPE_ZSET) {
+    result = {GEN_CMD_STRING(REDIS_SET_KEY_ZSET_COMMAND), key_str.GetData()};
+  } else if (type == common::Value::TYPE_HASH) {
+    result = {GEN_CMD_STRING(REDIS_SET_KEY_HASH_COMMAND), key_str.GetData()};
+  } else if (type == common::Value::TYPE_STRING) {
+    result = {GEN_CMD_STRING(REDIS_SET_KEY_COMMAND), key_str.GetData()};
+  } else {
+    // streams and modules keep the command line form
+    command_buffer_t cmdstring;
+    common::Error err = CreateKeyCommandImpl(key, &cmdstring);
+    if (err) {
+      return err;
+    }
+
+    if (!ParseCommandLine(cmdstring, argv)) {
+      return InvalidInputArguments(cmdstring);
+    }
+    return common::Error();
+  }
+
+  AppendValueArgs(value.get(), &result);
+  *argv = result;
+  return common::Error();
+}
+
+common::Error CommandTranslator::LoadKeyCommandArgsImpl(const NKey& key,
+                                                        common::Value::Type type,
+                                                        commands_args_t* argv) const {
+  const auto key_str = key.GetKey();
+  if (type == common::Value::TYPE_ARRAY) {
+    *argv = {GEN_CMD_STRING(REDIS_GET_KEY_ARRAY_COMMAND), key_str.GetData(), GEN_CMD_STRING("0"),
+             GEN_CMD_STRING("-1")};
+  } else if (type == common::Value::TYPE_SET) {
+    *argv = {GEN_CMD_STRING(REDIS_GET_KEY_SET_COMMAND), key_str.GetData()};
+  } else if (type == common::Value::TYPE_ZSET) {
+    *argv = {GEN_CMD_STRING(REDIS_GET_KEY_ZSET_COMMAND), key_str.GetData(), GEN_CMD_STRING("0"), GEN_CMD_STRING("-1"),
+             GEN_CMD_STRING("WITHSCORES")};
+  } else if (type == common::Value::TYPE_HASH) {
+    *argv = {GEN_CMD_STRING(REDIS_GET_KEY_HASH_COMMAND), key_str.GetData()};
+  } else if (type == common::Value::TYPE_STRING) {
+    *argv = {GEN_CMD_STRING(REDIS_GET_KEY_COMMAND), key_str.GetData()};
+  } else if (type == StreamValue::TYPE_STREAM) {
+    *argv = {GEN_CMD_STRING(REDIS_GET_KEY_STREAM_COMMAND), key_str.GetData(), GEN_CMD_STRING("-"),
+             GEN_CMD_STRING("+")};
+  } else if (type == JsonValue::TYPE_JSON) {
+    *argv = {GEN_CMD_STRING(REDIS_GET_KEY_JSON_COMMAND), key_str.GetData()};
+  } else {
+    // reuse the error reporting of the command line form
+    command_buffer_t cmdstring;
+    return LoadKeyCommandImpl(key, type, &cmdstring);
+  }
+
+  return common::Error();
+}
+
+common::Error CommandTranslator::DeleteKeyCommandArgsImpl(const NKey& key, commands_args_t* argv) const {
+  const auto key_str = key.GetKey();
+  *argv = {GEN_CMD_STRING(REDIS_DELETE_KEY_COMMAND), key_str.GetData()};
+  return common::Error();
+}
+
+common::Error CommandTranslator::RenameKeyCommandArgsImpl(const NKey& key,
+                                                          const trans_key_t& new_name,
+                                                          commands_args_t* argv) const {
+  const auto key_str = key.GetKey();
+  *argv = {GEN_CMD_STRING(REDIS_RENAME_KEY_COMMAND), key_str.GetData(), new_name.GetData()};
+  return common::Error();
+}
+
+common::Error CommandTranslator::ChangeKeyTTLCommandArgsImpl(const NKey& key,
+                                                             ttl_t ttl,
+                                                             commands_args_t* argv) const {
+  const auto key_str = key.GetKey();
+  if (ttl == NO_TTL) {
+    *argv = {GEN_CMD_STRING(REDIS_PERSIST_KEY_COMMAND), key_str.GetData()};
+  } else {
+    *argv = {GEN_CMD_STRING(REDIS_CHANGE_TTL_COMMAND), key_str.GetData(), common::ConvertToBytes(ttl)};
+  }
+
+  return common::Error();
+}
+
+common::Error CommandTranslator::LoadKeyTTLCommandArgsImpl(const NKey& key, commands_args_t* argv) const {
+  const auto key_str = key.GetKey();
+  *argv = {GEN_CMD_STRING(REDIS_GET_TTL_COMMAND), key_str.GetData()};
+  return common::Error();
+}
+
 bool CommandTranslator::IsLoadKeyCommandImpl(const CommandInfo& cmd) const {
   return cmd.IsEqualName(GEN_CMD_STRING(REDIS_GET_KEY_COMMAND)) ||
          cmd.IsEqualName(GEN_CMD_STRING(REDIS_GET_KEY_ARRAY_COMMAND)) ||
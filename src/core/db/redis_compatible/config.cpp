@@ -24,13 +24,23 @@
 #define REDIS_HOST_SOCKET_FIELD ARGS_FROM_FIELD("s")
 #define REDIS_AUTH_FIELD ARGS_FROM_FIELD("a")
 #define REDIS_SSL_FIELD ARGS_FROM_FIELD("ssl")
+#define REDIS_READ_FROM_FIELD ARGS_FROM_FIELD("rf")
+#define REDIS_SENTINEL_MASTER_FIELD ARGS_FROM_FIELD("sm")
+#define REDIS_NEAR_CACHE_SIZE_FIELD ARGS_FROM_FIELD("nc")
 
 namespace fastonosql {
 namespace core {
 namespace redis_compatible {
 
 Config::Config(const common::net::HostAndPort& host)
-    : RemoteConfig(host), hostsocket(), db_num(kDefaultDbNum), auth(), is_ssl(false) {}
+    : RemoteConfig(host),
+      hostsocket(),
+      db_num(kDefaultDbNum),
+      auth(),
+      is_ssl(false),
+      read_from(READ_FROM_MASTER),
+      sentinel_master(),
+      near_cache_size(0) {}
 
 Config::Config() : Config(common::net::HostAndPort()) {}
 
@@ -49,6 +59,19 @@ void Config::Init(const config_args_t& args) {
       auth = args[++i];
     } else if (args[i] == REDIS_SSL_FIELD) {
       is_ssl = true;
+    } else if (args[i] == REDIS_READ_FROM_FIELD && !lastarg) {
+      int lread_from;
+      if (common::ConvertFromString(args[++i], &lread_from) && lread_from >= READ_FROM_MASTER &&
+          lread_from <= READ_FROM_REPLICA_LEAST_LATENCY) {
+        read_from = static_cast<ReadFrom>(lread_from);
+      }
+    } else if (args[i] == REDIS_SENTINEL_MASTER_FIELD && !lastarg) {
+      sentinel_master = args[++i];
+    } else if (args[i] == REDIS_NEAR_CACHE_SIZE_FIELD && !lastarg) {
+      int lnear_cache_size;
+      if (common::ConvertFromString(args[++i], &lnear_cache_size) && lnear_cache_size >= 0) {
+        near_cache_size = lnear_cache_size;
+      }
     }
   }
 }
@@ -73,12 +96,28 @@ config_args_t Config::ToArgs() const {
     args.push_back(REDIS_SSL_FIELD);
   }
 
+  if (read_from != READ_FROM_MASTER) {
+    args.push_back(REDIS_READ_FROM_FIELD);
+    args.push_back(common::ConvertToString(static_cast<int>(read_from)));
+  }
+
+  if (!sentinel_master.empty()) {
+    args.push_back(REDIS_SENTINEL_MASTER_FIELD);
+    args.push_back(sentinel_master);
+  }
+
+  if (near_cache_size != 0) {
+    args.push_back(REDIS_NEAR_CACHE_SIZE_FIELD);
+    args.push_back(common::ConvertToString(near_cache_size));
+  }
+
   return args;
 }
 
 bool Config::Equals(const Config& other) const {
   return base_class::Equals(other) && hostsocket == other.hostsocket && db_num == other.db_num && auth == other.auth &&
-         is_ssl == other.is_ssl;
+         is_ssl == other.is_ssl && read_from == other.read_from &&
+         sentinel_master == other.sentinel_master && near_cache_size == other.near_cache_size;
 }
 
 }  // namespace redis_compatible
@@ -18,14 +18,30 @@
 
 #include <fastonosql/core/db/redis_compatible/db_connection.h>
 
+#if defined(_WIN32)
+#include <winsock2.h>
+#define poll WSAPoll
+#else
+#include <poll.h>
+#endif
+
+#include <string.h>
+
+#include <algorithm>
+
 extern "C" {
 #include <hiredis/hiredis.h>
 }
 
 #include <common/file_system/string_path_utils.h>
 
+#include <fastonosql/core/db/redis_compatible/cluster_router.h>
 #include <fastonosql/core/db/redis_compatible/command_translator.h>
 #include <fastonosql/core/db/redis_compatible/database_info.h>
+#include <fastonosql/core/db/redis_compatible/message_ring.h>
+#include <fastonosql/core/db/redis_compatible/near_cache.h>
+#include <fastonosql/core/db/redis_compatible/rdb_parser.h>
+#include <fastonosql/core/db/redis_compatible/sentinel_watcher.h>
 
 #include <fastonosql/core/value.h>
 
@@ -112,7 +128,7 @@ bool ConvertFromType(common::Value::Type type, readable_string_t* out) {
 }
 
 namespace {
-bool IsPipeLineCommand(const command_buffer_t& command) {
+bool IsPipeLineCommand(command_arg_view_t command) {
   if (command.empty()) {
     DNOTREACHED();
     return false;
@@ -132,12 +148,212 @@ bool IsPipeLineCommand(const command_buffer_t& command) {
 
   return !skip;
 }
+
+// TYPE plus the whole value for the core types, {type} for anything else
+// and for collections with more than ARGV[1] elements, those are read in pages
+const char kLoadTypedValueScript[] =
+    "local t = redis.call('TYPE', KEYS[1]).ok "
+    "local n = tonumber(ARGV[1]) "
+    "if t == 'string' then return {t, redis.call('GET', KEYS[1])} end "
+    "if t == 'list' then if redis.call('LLEN', KEYS[1]) > n then return {t} end "
+    "return {t, redis.call('LRANGE', KEYS[1], 0, -1)} end "
+    "if t == 'set' then if redis.call('SCARD', KEYS[1]) > n then return {t} end "
+    "return {t, redis.call('SMEMBERS', KEYS[1])} end "
+    "if t == 'hash' then if redis.call('HLEN', KEYS[1]) > n then return {t} end "
+    "return {t, redis.call('HGETALL', KEYS[1])} end "
+    "if t == 'zset' then if redis.call('ZCARD', KEYS[1]) > n then return {t} end "
+    "return {t, redis.call('ZRANGE', KEYS[1], 0, -1, 'WITHSCORES')} end "
+    "return {t}";
+
+void FillSetValue(common::SetValue* set, common::ArrayValue* arr) {
+  for (size_t i = 0; i < arr->GetSize(); ++i) {
+    common::Value* lval = nullptr;
+    if (arr->Get(i, &lval)) {
+      set->Insert(lval->DeepCopy());
+    }
+  }
+}
+
+void FillHashValue(common::HashValue* hash, common::ArrayValue* arr) {
+  for (size_t i = 0; i < arr->GetSize(); i += 2) {
+    common::Value* lkey = nullptr;
+    common::Value* lvalue = nullptr;
+    if (arr->Get(i, &lkey) && arr->Get(i + 1, &lvalue)) {
+      common::Value::string_t key;
+      if (lkey->GetAsString(&key)) {
+        hash->Insert(key, lvalue->DeepCopy());
+      }
+    }
+  }
+}
+
+void FillZSetValue(common::ZSetValue* zset, common::ArrayValue* arr) {
+  for (size_t i = 0; i < arr->GetSize(); i += 2) {
+    common::Value* lmember = nullptr;
+    common::Value* lscore = nullptr;
+    if (arr->Get(i, &lmember) && arr->Get(i + 1, &lscore)) {
+      zset->Insert(lscore->DeepCopy(), lmember->DeepCopy());
+    }
+  }
+}
+
+common::SetValue* MakeSetValue(common::ArrayValue* arr) {
+  common::SetValue* set = common::Value::CreateSetValue();
+  FillSetValue(set, arr);
+  return set;
+}
+
+common::HashValue* MakeHashValue(common::ArrayValue* arr) {
+  common::HashValue* hash = common::Value::CreateHashValue();
+  FillHashValue(hash, arr);
+  return hash;
+}
+
+common::ZSetValue* MakeZSetValue(common::ArrayValue* arr) {
+  common::ZSetValue* zset = common::Value::CreateZSetValue();
+  FillZSetValue(zset, arr);
+  return zset;
+}
+
+// takes ownership of the flat element list of a paged read, lists are returned as is
+common::Value* MakeCollectionValue(common::ArrayValue* elements, common::Value::Type type) {
+  if (type == common::Value::TYPE_ARRAY) {
+    return elements;
+  }
+
+  common::Value* typed = nullptr;
+  if (type == common::Value::TYPE_SET) {
+    typed = MakeSetValue(elements);
+  } else if (type == common::Value::TYPE_HASH) {
+    typed = MakeHashValue(elements);
+  } else if (type == common::Value::TYPE_ZSET) {
+    typed = MakeZSetValue(elements);
+  }
+  delete elements;
+  return typed;
+}
+
+// takes ownership of a decoded reply, string to string, array to list/set/hash/zset by type
+common::Error TypedValueFromValue(common::Value* val, common::Value::Type type, common::Value** out) {
+  if (type == common::Value::TYPE_STRING) {
+    if (val->GetType() != common::Value::TYPE_STRING) {
+      delete val;
+      return common::make_error("Conversion error string");
+    }
+    *out = val;
+    return common::Error();
+  }
+
+  common::ArrayValue* arr = nullptr;
+  if (!val->GetAsList(&arr)) {
+    delete val;
+    return common::make_error("Conversion error array");
+  }
+
+  common::Value* typed = MakeCollectionValue(arr, type);
+  if (!typed) {
+    return common::make_error("Conversion error array");
+  }
+  *out = typed;
+  return common::Error();
+}
+
+// stream feeds, reads happen in bursts and objects are built for at most one batch per burst,
+// so a feed faster than we can consume fills the ring and gets sampled instead of piling up
+const int kStreamPollTimeoutMsec = 100;
+const size_t kStreamReadsPerBatch = 16;
+const size_t kStreamBatchSize = 512;
+const size_t kStreamKeptBatches = 256;
+const size_t kStreamKeptMessages = 4096;
+
+const size_t kRdbEofMarkSize = 40;  // diskless SYNC payload delimiter
+
+common::Error ReadReplyError(NativeConnection* context) {
+  /* Filter cases where we should reconnect */
+  if (context->err == REDIS_ERR_IO && errno == ECONNRESET) {
+    return common::make_error("Needed reconnect.");
+  }
+  if (context->err == REDIS_ERR_EOF) {
+    return common::make_error("Needed reconnect.");
+  }
+
+  return PrintRedisContextError(context);
+}
+
+// waits for the socket at most timeout_msec, then moves every complete message into ring
+common::Error ReadStreamMessages(NativeConnection* context, int timeout_msec, MessageRing* ring) {
+  for (size_t i = 0; i < kStreamReadsPerBatch; ++i) {
+    while (true) {
+      void* reply = nullptr;
+      if (redisGetReplyFromReader(context, &reply) == REDIS_ERR) {
+        return ReadReplyError(context);
+      }
+
+      if (!reply) {
+        break;
+      }
+
+      common::Value* message = nullptr;
+      common::Error err = ValueFromReplay(static_cast<redisReply*>(reply), &message);
+      freeReplyObject(reply);
+      if (err) {
+        return err;
+      }
+      ring->Push(message);
+    }
+
+    struct pollfd fd;
+    fd.fd = context->fd;
+    fd.events = POLLIN;
+    fd.revents = 0;
+    if (poll(&fd, 1, i == 0 ? timeout_msec : 0) <= 0) {
+      return common::Error();
+    }
+
+    if (redisBufferRead(context) == REDIS_ERR) {
+      return ReadReplyError(context);
+    }
+  }
+
+  return common::Error();
+}
+
+// [cursor, [key...]]
+bool ParseScanReply(redisReply* reply, raw_keys_t* keys_out, cursor_t::position_t* cursor_out) {
+  if (reply->type != REDIS_REPLY_ARRAY || reply->elements != 2 || reply->element[0]->type != REDIS_REPLY_STRING ||
+      reply->element[1]->type != REDIS_REPLY_ARRAY) {
+    return false;
+  }
+
+  const command_buffer_t cursor_str = GEN_CMD_STRING_SIZE(reply->element[0]->str, reply->element[0]->len);
+  if (!common::ConvertFromBytes(cursor_str, cursor_out)) {
+    return false;
+  }
+
+  redisReply* keys = reply->element[1];
+  for (size_t i = 0; i < keys->elements; ++i) {
+    if (keys->element[i]->type == REDIS_REPLY_STRING) {
+      keys_out->push_back(GEN_CMD_STRING_SIZE(keys->element[i]->str, keys->element[i]->len));
+    }
+  }
+  return true;
+}
 }  // namespace
 
 const char* GetHiredisVersion() {
   return HIREDIS_VERSION;
 }
 
+bool IsScriptingUnavailableError(const std::string& description) {
+  static const char* const transient[] = {"BUSY", "LOADING", "OOM", "TRYAGAIN", "MASTERDOWN", "NOSCRIPT"};
+  for (const char* prefix : transient) {
+    if (strncasecmp(description.c_str(), prefix, strlen(prefix)) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 common::Error CreateConnection(const Config& config, const SSHInfo& sinfo, NativeConnection** context) {
   if (!context) {
     return common::make_error_inval();
@@ -294,6 +510,61 @@ common::Error ValueFromReplay(redisReply* reply, common::Value** out) {
   return common::Error();
 }
 
+common::Error TypedValueFromReplay(redisReply* reply, common::Value::Type type, common::Value** out) {
+  if (!out || !reply) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  if (type == common::Value::TYPE_STRING) {
+    if (reply->type != REDIS_REPLY_STRING) {
+      return common::make_error(common::MemSPrintf("Unexpected reply type: %d", reply->type));
+    }
+
+    *out = common::Value::CreateStringValue(GEN_CMD_STRING_SIZE(reply->str, reply->len));
+    return common::Error();
+  }
+
+  if (reply->type != REDIS_REPLY_ARRAY) {
+    return common::make_error(common::MemSPrintf("Unexpected reply type: %d", reply->type));
+  }
+
+  common::Value* val = nullptr;
+  common::Error err = ValueFromReplay(reply, &val);
+  if (err) {
+    delete val;
+    return err;
+  }
+
+  if (type == common::Value::TYPE_ARRAY) {
+    *out = val;
+    return common::Error();
+  }
+
+  common::ArrayValue* arr = nullptr;
+  if (!val->GetAsList(&arr)) {
+    delete val;
+    return common::make_error("Conversion error array");
+  }
+
+  common::Value* typed = nullptr;
+  if (type == common::Value::TYPE_SET) {
+    typed = MakeSetValue(arr);
+  } else if (type == common::Value::TYPE_HASH) {
+    typed = MakeHashValue(arr);
+  } else if (type == common::Value::TYPE_ZSET) {
+    typed = MakeZSetValue(arr);
+  }
+  delete val;
+
+  if (!typed) {
+    return common::make_error(common::MemSPrintf("Unsupported type: %s", GetTypeName(type)));
+  }
+
+  *out = typed;
+  return common::Error();
+}
+
 common::Error ExecRedisCommand(NativeConnection* context,
                                size_t argc,
                                const char** argv,
@@ -331,7 +602,7 @@ common::Error ExecRedisCommand(NativeConnection* context,
 
   redisReply* rreply = static_cast<redisReply*>(reply);
   if (rreply->type == REDIS_REPLY_ERROR) {
-    if (!strncmp(rreply->str, "MOVED", 5) || !strcmp(rreply->str, "ASK")) {
+    if (!strncmp(rreply->str, "MOVED", 5) || !strncmp(rreply->str, "ASK ", 4)) {
       char* p = rreply->str;
       char* s = strchr(p, ' '); /* MOVED[S]3999 127.0.0.1:6381 */
       p = strchr(s + 1, ' ');   /* MOVED[S]3999[P]127.0.0.1:6381 */
@@ -362,19 +633,15 @@ common::Error ExecRedisCommand(NativeConnection* context, const commands_args_t&
     return common::make_error_inval();
   }
 
-  const char** argvc = static_cast<const char**>(calloc(sizeof(const char*), argv.size()));
-  int argcc = 0;
-  size_t* argvlen = reinterpret_cast<size_t*>(malloc(argv.size() * sizeof(size_t)));
+  // hiredis copies the arguments into its output buffer, pass pointers into argv as is
+  std::vector<const char*> argvc(argv.size());
+  std::vector<size_t> argvlen(argv.size());
   for (size_t i = 0; i < argv.size(); ++i) {
-    argvc[i] = reinterpret_cast<const char*>(argv[i].data());  // safe
+    argvc[i] = argv[i].data();
     argvlen[i] = argv[i].size();
-    argcc++;
   }
 
-  common::Error err = ExecRedisCommand(context, argcc, argvc, argvlen, out_reply);
-  free(argvlen);
-  free(argvc);
-  return err;
+  return ExecRedisCommand(context, argv.size(), argvc.data(), argvlen.data(), out_reply);
 }
 
 common::Error ExecRedisCommand(NativeConnection* context, const command_buffer_t& command, redisReply** out_reply) {
@@ -383,26 +650,79 @@ common::Error ExecRedisCommand(NativeConnection* context, const command_buffer_t
     return common::make_error_inval();
   }
 
-  commands_args_t standart_argv;
-  if (!ParseCommandLine(command, &standart_argv)) {
+  command_args_views_t standart_argv;
+  commands_args_t unescaped;
+  if (!ParseCommandLine(command, &standart_argv, &unescaped)) {
     return common::make_error_inval();
   }
 
-  size_t argc = standart_argv.size();
-  void* raw_argvlen_ptr = malloc(argc * sizeof(size_t));
-  void* raw_argv_ptr = malloc(argc * sizeof(char*));
-
-  size_t* argvlen = reinterpret_cast<size_t*>(raw_argvlen_ptr);
-  const char** argv = reinterpret_cast<const char**>(raw_argv_ptr);
-  for (size_t i = 0; i < argc; ++i) {
-    argv[i] = standart_argv[i].data();  // safe
+  std::vector<const char*> argvc(standart_argv.size());
+  std::vector<size_t> argvlen(standart_argv.size());
+  for (size_t i = 0; i < standart_argv.size(); ++i) {
+    argvc[i] = standart_argv[i].data();
     argvlen[i] = standart_argv[i].size();
   }
 
-  common::Error err = ExecRedisCommand(context, argc, argv, argvlen, out_reply);
-  free(raw_argv_ptr);
-  free(raw_argvlen_ptr);
-  return err;
+  return ExecRedisCommand(context, standart_argv.size(), argvc.data(), argvlen.data(), out_reply);
+}
+
+common::Error ExecRedisPipeline(NativeConnection* context,
+                                const std::vector<commands_args_t>& cmds,
+                                size_t window,
+                                pipeline_reply_callback_t on_reply) {
+  if (!context) {
+    DNOTREACHED();
+    return common::make_error("Not connected");
+  }
+
+  if (window == 0 || !on_reply) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  std::vector<const char*> argvc;
+  std::vector<size_t> argvlen;
+  for (size_t start = 0; start < cmds.size(); start += window) {
+    const size_t stop = std::min(cmds.size(), start + window);
+    for (size_t i = start; i < stop; ++i) {
+      const commands_args_t& argv = cmds[i];
+      argvc.resize(argv.size());
+      argvlen.resize(argv.size());
+      for (size_t j = 0; j < argv.size(); ++j) {
+        argvc[j] = argv[j].data();
+        argvlen[j] = argv[j].size();
+      }
+
+      if (redisAppendCommandArgv(context, argv.size(), argvc.data(), argvlen.data()) == REDIS_ERR) {
+        return PrintRedisContextError(context);
+      }
+    }
+
+    // always read the whole window, otherwise later replies get out of sync
+    common::Error first_err;
+    for (size_t i = start; i < stop; ++i) {
+      void* reply = nullptr;
+      if (redisGetReply(context, &reply) == REDIS_ERR) {
+        return PrintRedisContextError(context);
+      }
+
+      redisReply* rreply = static_cast<redisReply*>(reply);
+      if (!first_err) {
+        if (rreply->type == REDIS_REPLY_ERROR) {
+          first_err = common::make_error(std::string(rreply->str, rreply->len));
+        } else {
+          first_err = on_reply(i, rreply);
+        }
+      }
+      freeReplyObject(rreply);
+    }
+
+    if (first_err) {
+      return first_err;
+    }
+  }
+
+  return common::Error();
 }
 
 common::Error AuthContext(NativeConnection* context, const command_buffer_t& password) {
@@ -422,85 +742,427 @@ common::Error AuthContext(NativeConnection* context, const command_buffer_t& pas
 
 template <typename Config, ConnectionType ContType>
 common::Error DBConnection<Config, ContType>::Connect(const config_t& config) {
+  if (config->sentinel_master.empty()) {
+    return ConnectToServer(config);
+  }
+
+  // host is a sentinel, work with the master it names
+  SentinelWatcher* sentinel = new SentinelWatcher(*config, config->ssh_info);
+  common::net::HostAndPort master;
+  common::Error err = sentinel->Start(&master);
+  if (err) {
+    delete sentinel;
+    return err;
+  }
+
+  sentinel_ = sentinel;
+  config_t master_config = config;
+  master_config->host = master;
+  master_config->hostsocket.clear();
+  master_config->sentinel_master.clear();  // the stored config describes the server we talk to
+  return ConnectToServer(master_config);
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::ConnectToServer(const config_t& config) {
   common::Error err = base_class::Connect(config);
   if (err) {
     return err;
   }
 
+  // the new server may support scripts even if the previous one did not
+  is_scripting_supported_ = true;
+
   /* Do AUTH and select the right DB. */
   err = Auth(common::ConvertToCharBytes(config->auth));  // convert from std::string to char bytes
   if (err) {
     return err;
   }
 
+  // cluster nodes answer CLUSTER SLOTS, everything else replies with an error and works as before,
+  // unless reads should go to the replicas of a plain master
+  ClusterRouter* router = new ClusterRouter(*config, config->ssh_info);
+  err = router->LoadSlots(base_class::connection_.handle_);
+  if (err && !base_class::connection_.handle_->err && config->read_from != Config::READ_FROM_MASTER) {
+    err = router->LoadReplicas(base_class::connection_.handle_);
+  }
+
+  if (err) {
+    delete router;
+    if (base_class::connection_.handle_->err) {
+      return err;
+    }
+  } else {
+    cluster_ = router;
+  }
+
+  // tracking follows a single server, cluster and replica routing are left uncached
+  if (config->near_cache_size <= 0 || cluster_) {
+    return common::Error();
+  }
+
+  NearCache* cache = new NearCache(*config, config->ssh_info, config->near_cache_size);
+  err = cache->Start(base_class::connection_.handle_);
+  if (err) {
+    delete cache;
+    if (base_class::connection_.handle_->err) {
+      return err;
+    }
+    return common::Error();
+  }
+
+  near_cache_ = cache;
   return common::Error();
 }
 
 template <typename Config, ConnectionType ContType>
 common::Error DBConnection<Config, ContType>::Disconnect() {
+  delete sentinel_;
+  sentinel_ = nullptr;
+  return DisconnectFromServer();
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::DisconnectFromServer() {
   cur_db_ = invalid_db_num;
   is_auth_ = false;
+  load_typed_value_sha_.clear();
+  delete cluster_;
+  cluster_ = nullptr;
+  delete near_cache_;
+  near_cache_ = nullptr;
   return base_class::Disconnect();
 }
 
 template <typename Config, ConnectionType ContType>
-db_name_t DBConnection<Config, ContType>::GetCurrentDBName() const {
-  if (IsAuthenticated()) {
-    auto config = base_class::GetConfig();
-    int db_num = config->db_num;
-    return cur_db_ != invalid_db_num ? common::ConvertToCharBytes(cur_db_)
-                                     : common::ConvertToCharBytes(db_num);  // convert from std::string to db_name_t
+DBConnection<Config, ContType>::~DBConnection() {
+  delete cluster_;
+  delete sentinel_;
+  delete near_cache_;
+}
+
+template <typename Config, ConnectionType ContType>
+NearCache* DBConnection<Config, ContType>::GetNearCache() {
+  if (!near_cache_) {
+    return nullptr;
+  }
+
+  common::Error err = near_cache_->Poll();
+  if (err) {  // invalidations are lost, stop caching
+    delete near_cache_;
+    near_cache_ = nullptr;
+
+    // the server would keep redirecting to the dead invalidation client id
+    NativeConnection* handle = base_class::connection_.handle_;
+    if (handle && !handle->err) {
+      redisReply* reply = nullptr;
+      const commands_args_t off_cmd = {GEN_CMD_STRING("CLIENT"), GEN_CMD_STRING("TRACKING"), GEN_CMD_STRING("OFF")};
+      common::Error off_err = ExecRedisCommand(handle, off_cmd, &reply);
+      if (!off_err) {
+        freeReplyObject(reply);
+      }
+    }
   }
+  return near_cache_;
+}
 
-  DNOTREACHED();
-  return base_class::GetCurrentDBName();
+template <typename Config, ConnectionType ContType>
+void DBConnection<Config, ContType>::InvalidateWrittenKey(const commands_args_t& argv) {
+  if (!near_cache_ || IsReadOnlyCommand(argv)) {
+    return;
+  }
+
+  // tracking reports our own writes too, but only after the reply
+  const size_t key_index = KeyArgIndex(argv);
+  if (key_index != 0 && key_index < argv.size()) {
+    near_cache_->Invalidate(argv[key_index]);
+  }
 }
 
 template <typename Config, ConnectionType ContType>
-bool DBConnection<Config, ContType>::IsAuthenticated() const {
-  if (!base_class::IsAuthenticated()) {
-    return false;
+void DBConnection<Config, ContType>::InvalidateWrittenKey(const command_args_views_t& argv) {
+  if (!near_cache_) {
+    return;
   }
 
-  return is_auth_;
+  commands_args_t owned;
+  for (const command_arg_view_t& arg : argv) {
+    owned.push_back(GEN_CMD_STRING_SIZE(arg.data(), arg.size()));
+  }
+  InvalidateWrittenKey(owned);
 }
 
 template <typename Config, ConnectionType ContType>
-common::Error DBConnection<Config, ContType>::CommonExec(const commands_args_t& argv, FastoObject* out) {
-  if (!out || argv.empty()) {
-    DNOTREACHED();
-    return common::make_error_inval();
+common::Error DBConnection<Config, ContType>::CheckFailover() {
+  if (!sentinel_ || !base_class::IsConnected()) {
+    return common::Error();
   }
 
-  common::Error err = base_class::TestIsAuthenticated();
-  if (err) {
-    return err;
+  // sentinel trouble must not break the data connection, the cached master stays in use
+  // and Poll keeps trying to subscribe again
+  bool switched = false;
+  common::Error err = sentinel_->Poll(&switched);
+  UNUSED(err);
+  common::net::HostAndPort master = sentinel_->GetMaster();
+  if (!switched && base_class::connection_.handle_->err) {  // previous command failed on i/o, ask again
+    err = sentinel_->Resolve(&master);
+    if (err) {
+      return common::Error();
+    }
   }
 
-  redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, argv, &reply);
+  config_t config = base_class::GetConfig();
+  if (config->host.GetHost() == master.GetHost() && config->host.GetPort() == master.GetPort()) {
+    return common::Error();
+  }
+
+  config->host = master;
+  err = DisconnectFromServer();
   if (err) {
     return err;
   }
 
-  err = CliFormatReplyRaw(out, reply);
-  freeReplyObject(reply);
-  return err;
+  return ConnectToServer(config);
 }
 
 template <typename Config, ConnectionType ContType>
-common::Error DBConnection<Config, ContType>::CliFormatReplyRaw(FastoObject* out, redisReply* r) {
-  if (!out || !r) {
-    DNOTREACHED();
-    return common::make_error_inval();
-  }
+bool DBConnection<Config, ContType>::IsClusterMode() const {
+  return cluster_ && cluster_->IsCluster();
+}
 
-  common::Value* out_val = nullptr;
-  common::Error err = ValueFromReplay(r, &out_val);
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::ExecCommand(const commands_args_t& argv, redisReply** out_reply) {
+  common::Error err = CheckFailover();
   if (err) {
-    if (err->GetDescription() == "NOAUTH") {  // "NOAUTH Authentication
-                                              // required."
-      is_auth_ = false;
+    return err;
+  }
+
+  InvalidateWrittenKey(argv);
+  if (cluster_) {
+    return cluster_->ExecCommand(argv, out_reply);
+  }
+
+  return ExecRedisCommand(base_class::connection_.handle_, argv, out_reply);
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::ExecReadCommand(const commands_args_t& argv, redisReply** out_reply) {
+  common::Error err = CheckFailover();
+  if (err) {
+    return err;
+  }
+
+  if (cluster_) {
+    return cluster_->ExecReadCommand(argv, out_reply);
+  }
+
+  return ExecRedisCommand(base_class::connection_.handle_, argv, out_reply);
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::ExecCommand(const command_buffer_t& command, redisReply** out_reply) {
+  common::Error err = CheckFailover();
+  if (err) {
+    return err;
+  }
+
+  if (!cluster_ && !near_cache_) {
+    return ExecRedisCommand(base_class::connection_.handle_, command, out_reply);
+  }
+
+  commands_args_t argv;
+  if (!ParseCommandLine(command, &argv)) {
+    return common::make_error_inval();
+  }
+
+  InvalidateWrittenKey(argv);
+  if (!cluster_) {
+    return ExecRedisCommand(base_class::connection_.handle_, argv, out_reply);
+  }
+
+  return cluster_->ExecCommand(argv, out_reply);
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::ExecPipeline(const std::vector<commands_args_t>& cmds,
+                                                           size_t window,
+                                                           pipeline_reply_callback_t on_reply) {
+  common::Error err = CheckFailover();
+  if (err) {
+    return err;
+  }
+
+  for (const commands_args_t& argv : cmds) {
+    InvalidateWrittenKey(argv);
+  }
+
+  if (cluster_) {
+    return cluster_->ExecPipeline(cmds, window, on_reply);
+  }
+
+  return ExecRedisPipeline(base_class::connection_.handle_, cmds, window, on_reply);
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::ExecCommandToValue(const commands_args_t& argv,
+                                                                 common::Value** out,
+                                                                 RespReader::element_callback_t on_element) {
+  return ExecCommandToValueImpl(argv, false, out, on_element);
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::ExecReadCommandToValue(const commands_args_t& argv,
+                                                                     common::Value** out,
+                                                                     RespReader::element_callback_t on_element) {
+  return ExecCommandToValueImpl(argv, true, out, on_element);
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::ExecCommandToValueImpl(const commands_args_t& argv,
+                                                                     bool read_only,
+                                                                     common::Value** out,
+                                                                     RespReader::element_callback_t on_element) {
+  if (!out) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  common::Error err = CheckFailover();
+  if (err) {
+    return err;
+  }
+
+  if (!read_only) {
+    InvalidateWrittenKey(argv);
+  }
+  if (!cluster_) {
+    return ExecRedisCommandToValue(base_class::connection_.handle_, argv, out, on_element);
+  }
+
+  // redirects are followed by the router on hiredis replies, convert them here
+  redisReply* reply = nullptr;
+  err = read_only ? cluster_->ExecReadCommand(argv, &reply) : cluster_->ExecCommand(argv, &reply);
+  if (err) {
+    return err;
+  }
+
+  if (!on_element || reply->type != REDIS_REPLY_ARRAY) {
+    err = ValueFromReplay(reply, out);
+    freeReplyObject(reply);
+    return err;
+  }
+
+  // each element is converted once and handed over, like the streamed path
+  for (size_t i = 0; i < reply->elements; ++i) {
+    common::Value* element = nullptr;
+    err = ValueFromReplay(reply->element[i], &element);
+    if (err) {
+      freeReplyObject(reply);
+      return err;
+    }
+    on_element(i, element);
+  }
+  freeReplyObject(reply);
+  *out = nullptr;
+  return common::Error();
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::ExecPipelineToValues(const std::vector<commands_args_t>& cmds,
+                                                                   size_t window,
+                                                                   pipeline_value_callback_t on_value) {
+  if (cluster_) {
+    return ExecPipeline(cmds, window, [&on_value](size_t index, redisReply* reply) -> common::Error {
+      common::Value* val = nullptr;
+      common::Error err = ValueFromReplay(reply, &val);
+      if (err) {
+        return err;
+      }
+      return on_value(index, val);
+    });
+  }
+
+  common::Error err = CheckFailover();
+  if (err) {
+    return err;
+  }
+
+  for (const commands_args_t& argv : cmds) {
+    InvalidateWrittenKey(argv);
+  }
+  return ExecRedisPipelineToValues(base_class::connection_.handle_, cmds, window, on_value);
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::ExecCommandToValue(const command_buffer_t& command,
+                                                                 common::Value** out,
+                                                                 RespReader::element_callback_t on_element) {
+  commands_args_t argv;
+  if (!ParseCommandLine(command, &argv)) {
+    return common::make_error_inval();
+  }
+
+  return ExecCommandToValue(argv, out, on_element);
+}
+
+template <typename Config, ConnectionType ContType>
+db_name_t DBConnection<Config, ContType>::GetCurrentDBName() const {
+  if (IsAuthenticated()) {
+    auto config = base_class::GetConfig();
+    int db_num = config->db_num;
+    return cur_db_ != invalid_db_num ? common::ConvertToCharBytes(cur_db_)
+                                     : common::ConvertToCharBytes(db_num);  // convert from std::string to db_name_t
+  }
+
+  DNOTREACHED();
+  return base_class::GetCurrentDBName();
+}
+
+template <typename Config, ConnectionType ContType>
+bool DBConnection<Config, ContType>::IsAuthenticated() const {
+  if (!base_class::IsAuthenticated()) {
+    return false;
+  }
+
+  return is_auth_;
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::CommonExec(const commands_args_t& argv, FastoObject* out) {
+  if (!out || argv.empty()) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  common::Error err = base_class::TestIsAuthenticated();
+  if (err) {
+    return err;
+  }
+
+  redisReply* reply = nullptr;
+  err = ExecCommand(argv, &reply);
+  if (err) {
+    return err;
+  }
+
+  err = CliFormatReplyRaw(out, reply);
+  freeReplyObject(reply);
+  return err;
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::CliFormatReplyRaw(FastoObject* out, redisReply* r) {
+  if (!out || !r) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  common::Value* out_val = nullptr;
+  common::Error err = ValueFromReplay(r, &out_val);
+  if (err) {
+    if (err->GetDescription() == "NOAUTH") {  // "NOAUTH Authentication
+                                              // required."
+      is_auth_ = false;
     }
     return err;
   }
@@ -524,15 +1186,7 @@ common::Error DBConnection<Config, ContType>::CliReadReply(FastoObject* out) {
 
   void* _reply = nullptr;
   if (redisGetReply(base_class::connection_.handle_, &_reply) != REDIS_OK) {
-    /* Filter cases where we should reconnect */
-    if (base_class::connection_.handle_->err == REDIS_ERR_IO && errno == ECONNRESET) {
-      return common::make_error("Needed reconnect.");
-    }
-    if (base_class::connection_.handle_->err == REDIS_ERR_EOF) {
-      return common::make_error("Needed reconnect.");
-    }
-
-    return PrintRedisContextError(base_class::connection_.handle_); /* avoid compiler warning */
+    return ReadReplyError(base_class::connection_.handle_);
   }
 
   redisReply* reply = static_cast<redisReply*>(_reply);
@@ -541,6 +1195,52 @@ common::Error DBConnection<Config, ContType>::CliReadReply(FastoObject* out) {
   return er;
 }
 
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::ListenStream(FastoObject* out) {
+  if (!out) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  MessageRing ring;
+  uint64_t reported_dropped = 0;
+  std::vector<common::Value*> batch;
+  while (!base_class::IsInterrupted()) {  // listen loop
+    common::Error err = ReadStreamMessages(base_class::connection_.handle_, kStreamPollTimeoutMsec, &ring);
+    if (err) {
+      if (err->GetDescription().compare(0, 6, "NOAUTH") == 0) {  // "NOAUTH Authentication required."
+        is_auth_ = false;
+      }
+      return err;
+    }
+
+    batch.clear();
+    if (ring.PopBatch(kStreamBatchSize, &batch) == 0) {
+      continue;
+    }
+
+    // one child per message ([message, channel, payload] for pub/sub) like a plain reply
+    for (common::Value* message : batch) {
+      FastoObject* child = new FastoObject(out, message, base_class::GetDelimiter());
+      out->AddChildren(child);
+    }
+
+    const uint64_t dropped = ring.GetDroppedCount();
+    if (dropped != reported_dropped) {
+      const std::string notice = common::MemSPrintf("Overloaded, dropped %llu of %llu messages",
+                                                    static_cast<unsigned long long>(dropped),
+                                                    static_cast<unsigned long long>(ring.GetReceivedCount()));
+      FastoObject* notice_child =
+          new FastoObject(out, common::Value::CreateStringValueFromBasicString(notice), base_class::GetDelimiter());
+      out->AddChildren(notice_child);
+      reported_dropped = dropped;
+    }
+    out->TrimChildrens(kStreamKeptMessages);
+  }
+
+  return common::make_error(common::COMMON_EINTR);
+}
+
 template <typename Config, ConnectionType ContType>
 common::Error DBConnection<Config, ContType>::Auth(const command_buffer_t& password) {
   common::Error err = base_class::TestIsConnected();
@@ -574,7 +1274,7 @@ common::Error DBConnection<Config, ContType>::SetClientName(const std::string& n
   wr << "CLIENT SETNAME " << name;
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, wr.str(), &reply);
+  err = ExecCommand(wr.str(), &reply);
   if (err) {
     return err;
   }
@@ -603,7 +1303,7 @@ common::Error DBConnection<Config, ContType>::Lpush(const NKey& key, NValue arr,
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, lpush_cmd, &reply);
+  err = ExecCommand(lpush_cmd, &reply);
   if (err) {
     return err;
   }
@@ -650,7 +1350,7 @@ common::Error DBConnection<Config, ContType>::Rpush(const NKey& key, NValue arr,
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, rpush_cmd, &reply);
+  err = ExecCommand(rpush_cmd, &reply);
   if (err) {
     return err;
   }
@@ -758,7 +1458,7 @@ common::Error DBConnection<Config, ContType>::Mget(const std::vector<NKey>& keys
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, mget_cmd, &reply);
+  err = ExecCommand(mget_cmd, &reply);
   if (err) {
     return err;
   }
@@ -805,7 +1505,7 @@ common::Error DBConnection<Config, ContType>::Mset(const std::vector<NDbKValue>&
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, mset_cmd, &reply);
+  err = ExecCommand(mset_cmd, &reply);
   if (err) {
     return err;
   }
@@ -835,7 +1535,7 @@ common::Error DBConnection<Config, ContType>::MsetNX(const std::vector<NDbKValue
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, msetnx_cmd, &reply);
+  err = ExecCommand(msetnx_cmd, &reply);
   if (err) {
     return err;
   }
@@ -877,7 +1577,7 @@ common::Error DBConnection<Config, ContType>::Append(const NKey& key, const NVal
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, append_cmd, &reply);
+  err = ExecCommand(append_cmd, &reply);
   if (err) {
     return err;
   }
@@ -916,7 +1616,7 @@ common::Error DBConnection<Config, ContType>::DBConnection::SetEx(const NDbKValu
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, setex_cmd, &reply);
+  err = ExecCommand(setex_cmd, &reply);
   if (err) {
     return err;
   }
@@ -947,7 +1647,7 @@ common::Error DBConnection<Config, ContType>::DBConnection::SetNX(const NDbKValu
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, setnx_cmd, &reply);
+  err = ExecCommand(setnx_cmd, &reply);
   if (err) {
     return err;
   }
@@ -987,7 +1687,7 @@ common::Error DBConnection<Config, ContType>::Decr(const NKey& key, redis_int_t*
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, decr_cmd, &reply);
+  err = ExecCommand(decr_cmd, &reply);
   if (err) {
     return err;
   }
@@ -1028,7 +1728,7 @@ common::Error DBConnection<Config, ContType>::DBConnection::DecrBy(const NKey& k
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, decrby_cmd, &reply);
+  err = ExecCommand(decrby_cmd, &reply);
   if (err) {
     return err;
   }
@@ -1069,7 +1769,7 @@ common::Error DBConnection<Config, ContType>::DBConnection::Incr(const NKey& key
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, incr_cmd, &reply);
+  err = ExecCommand(incr_cmd, &reply);
   if (err) {
     return err;
   }
@@ -1110,7 +1810,7 @@ common::Error DBConnection<Config, ContType>::DBConnection::IncrBy(const NKey& k
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, incrby_cmd, &reply);
+  err = ExecCommand(incrby_cmd, &reply);
   if (err) {
     return err;
   }
@@ -1151,7 +1851,7 @@ common::Error DBConnection<Config, ContType>::IncrByFloat(const NKey& key, doubl
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, incrfloat_cmd, &reply);
+  err = ExecCommand(incrfloat_cmd, &reply);
   if (err) {
     return err;
   }
@@ -1187,7 +1887,7 @@ common::Error DBConnection<Config, ContType>::PExpire(const NKey& key, ttl_t ttl
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, ttl_cmd, &reply);
+  err = ExecCommand(ttl_cmd, &reply);
   if (err) {
     return err;
   }
@@ -1223,7 +1923,7 @@ common::Error DBConnection<Config, ContType>::PTTL(const NKey& key, pttl_t* ttl)
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, pttl_cmd, &reply);
+  err = ExecCommand(pttl_cmd, &reply);
   if (err) {
     return err;
   }
@@ -1268,7 +1968,7 @@ common::Error DBConnection<Config, ContType>::Sadd(const NKey& key, NValue set,
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, sadd_cmd, &reply);
+  err = ExecCommand(sadd_cmd, &reply);
   if (err) {
     return err;
   }
@@ -1367,7 +2067,7 @@ common::Error DBConnection<Config, ContType>::ZpopMax(const NKey& key, size_t co
   }
 
   redisReply* reply = nullptr;
-  err = redis_compatible::ExecRedisCommand(base_class::connection_.handle_, zpopmax_cmd, &reply);
+  err = ExecCommand(zpopmax_cmd, &reply);
   if (err) {
     return err;
   }
@@ -1427,7 +2127,7 @@ common::Error DBConnection<Config, ContType>::ZpopMin(const NKey& key, size_t co
   }
 
   redisReply* reply = nullptr;
-  err = redis_compatible::ExecRedisCommand(base_class::connection_.handle_, zpopmin_cmd, &reply);
+  err = ExecCommand(zpopmin_cmd, &reply);
   if (err) {
     return err;
   }
@@ -1487,7 +2187,7 @@ common::Error DBConnection<Config, ContType>::Zadd(const NKey& key, NValue score
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, zadd_cmd, &reply);
+  err = ExecCommand(zadd_cmd, &reply);
   if (err) {
     return err;
   }
@@ -1590,7 +2290,7 @@ common::Error DBConnection<Config, ContType>::Hmset(const NKey& key, NValue hash
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, hmset_cmd, &reply);
+  err = ExecCommand(hmset_cmd, &reply);
   if (err) {
     return err;
   }
@@ -1680,7 +2380,7 @@ common::Error DBConnection<Config, ContType>::Monitor(const commands_args_t& arg
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, argv, &reply);
+  err = ExecCommand(argv, &reply);
   if (err) {
     return err;
   }
@@ -1692,14 +2392,7 @@ common::Error DBConnection<Config, ContType>::Monitor(const commands_args_t& arg
     return err;
   }
 
-  while (!base_class::IsInterrupted()) {  // listen loop
-    err = CliReadReply(out);
-    if (err) {
-      return err;
-    }
-  }
-
-  return common::make_error(common::COMMON_EINTR);
+  return ListenStream(out);
 }
 
 template <typename Config, ConnectionType ContType>
@@ -1715,7 +2408,7 @@ common::Error DBConnection<Config, ContType>::Subscribe(const commands_args_t& a
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, argv, &reply);
+  err = ExecCommand(argv, &reply);
   if (err) {
     return err;
   }
@@ -1727,14 +2420,7 @@ common::Error DBConnection<Config, ContType>::Subscribe(const commands_args_t& a
     return err;
   }
 
-  while (!base_class::IsInterrupted()) {  // listen loop
-    err = CliReadReply(out);
-    if (err) {
-      return err;
-    }
-  }
-
-  return common::make_error(common::COMMON_EINTR);
+  return ListenStream(out);
 }
 
 template <typename Config, ConnectionType ContType>
@@ -1750,41 +2436,146 @@ common::Error DBConnection<Config, ContType>::SlaveMode(FastoObject* out) {
   }
 
   unsigned long long payload = 0;
-  err = SendSync(&payload);
+  std::string eof_mark;
+  err = SendSync(&payload, &eof_mark);
   if (err) {
     return err;
   }
 
+  // parse the snapshot as it arrives, a diskless payload has no size and ends with the eof mark instead
+  NativeConnection* context = base_class::connection_.handle_;
+  const bool is_diskless = !eof_mark.empty();
+  auto read = [context, is_diskless, &payload](char* buf, size_t size, size_t* nread) -> common::Error {
+    if (!is_diskless) {
+      if (payload == 0) {
+        return common::make_error("Unexpected end of RDB payload");
+      }
+      size = std::min<unsigned long long>(size, payload);
+    }
+
+    ssize_t lnread = 0;
+    if (redisReadToBuffer(context, buf, size, &lnread) == REDIS_ERR) {
+      return common::make_error("Error reading RDB payload while SYNCing");
+    }
+    if (!is_diskless) {
+      payload -= lnread;
+    }
+    *nread = lnread;
+    return common::Error();
+  };
+
+  common::ArrayValue* batch = nullptr;
+  auto flush_batch = [this, out, &batch]() {
+    if (!batch) {
+      return;
+    }
+
+    FastoObject* child = new FastoObject(out, batch, base_class::GetDelimiter());
+    out->AddChildren(child);
+    out->TrimChildrens(kStreamKeptBatches);
+    batch = nullptr;
+  };
+  auto on_key = [&batch, &flush_batch](int db_num, const NKey& key, common::Value* value) {
+    common::ArrayValue* entry = common::Value::CreateArrayValue();  // [db, key, ttl, value]
+    entry->Append(common::Value::CreateInteger64Value(db_num));
+    entry->Append(common::Value::CreateStringValue(key.GetKey().GetData()));
+    entry->Append(common::Value::CreateInteger64Value(key.GetTTL()));
+    entry->Append(value);
+    if (!batch) {
+      batch = common::Value::CreateArrayValue();
+    }
+    batch->Append(entry);
+    if (batch->GetSize() >= kStreamBatchSize) {
+      flush_batch();
+    }
+  };
+
+  RdbParser parser(read, on_key);
+  err = parser.Parse();
+  flush_batch();
+  if (err && !parser.IsStoppedOnUnsupported()) {
+    return err;
+  }
+
+  std::vector<char> left = parser.GetUnconsumed();
+  common::Error parse_err = err;
+  if (parse_err && !is_diskless) {
+    left.clear();  // rest of the snapshot, the loop below discards what is still unread
+  } else if (parse_err) {
+    // the size is unknown, skip up to the eof mark
+    while (true) {
+      const auto found = std::search(left.begin(), left.end(), eof_mark.begin(), eof_mark.end());
+      if (found != left.end()) {
+        left.erase(left.begin(), found);
+        break;
+      }
+
+      if (left.size() >= eof_mark.size()) {
+        left.erase(left.begin(), left.end() - (eof_mark.size() - 1));
+      }
+      char buf[4096];
+      ssize_t nread = 0;
+      if (redisReadToBuffer(context, buf, sizeof(buf), &nread) == REDIS_ERR) {
+        return common::make_error("Error reading RDB payload while SYNCing");
+      }
+      left.insert(left.end(), buf, buf + nread);
+    }
+  }
+
+  if (is_diskless) {
+    while (left.size() < eof_mark.size()) {
+      char buf[64];
+      ssize_t nread = 0;
+      if (redisReadToBuffer(context, buf, eof_mark.size() - left.size(), &nread) == REDIS_ERR) {
+        return common::make_error("Error reading RDB payload while SYNCing");
+      }
+      left.insert(left.end(), buf, buf + nread);
+    }
+
+    if (memcmp(left.data(), eof_mark.data(), eof_mark.size()) != 0) {
+      return common::make_error("Bad RDB payload end mark");
+    }
+    left.erase(left.begin(), left.begin() + eof_mark.size());
+  }
+
   char buf[1024];
-  /* Discard the payload. */
+  /* Discard what the parser did not need. */
   while (payload) {
     ssize_t nread = 0;
     int size = (payload > sizeof(buf)) ? sizeof(buf) : payload;
-    int res = redisReadToBuffer(base_class::connection_.handle_, buf, size, &nread);
+    int res = redisReadToBuffer(context, buf, size, &nread);
     if (res == REDIS_ERR) {
       return common::make_error("Error reading RDB payload while SYNCing");
     }
     payload -= nread;
   }
 
-  /* Now we can use hiredis to read the incoming protocol.
-   */
-  while (!base_class::IsInterrupted()) {  // listen loop
-    err = CliReadReply(out);
-    if (err) {
-      return err;
-    }
+  std::string summary = common::MemSPrintf("Snapshot loaded: %llu keys, %llu skipped",
+                                           static_cast<unsigned long long>(parser.GetKeysCount()),
+                                           static_cast<unsigned long long>(parser.GetSkippedKeysCount()));
+  if (parse_err) {
+    summary += ", rest discarded: " + parse_err->GetDescription();
   }
+  FastoObject* summary_child =
+      new FastoObject(out, common::Value::CreateStringValueFromBasicString(summary), base_class::GetDelimiter());
+  out->AddChildren(summary_child);
 
-  return common::make_error(common::COMMON_EINTR);
+  // commands already read together with the end of the snapshot
+  if (!left.empty() && redisReaderFeed(context->reader, left.data(), left.size()) == REDIS_ERR) {
+    return PrintRedisContextError(context);
+  }
+
+  /* Now we can use hiredis to read the incoming protocol.
+   */
+  return ListenStream(out);
 }
 
 /* Sends SYNC and reads the number of bytes in the payload.
  * Used both by
  * slaveMode() and getRDB(). */
 template <typename Config, ConnectionType ContType>
-common::Error DBConnection<Config, ContType>::SendSync(unsigned long long* payload) {
-  if (!payload) {
+common::Error DBConnection<Config, ContType>::SendSync(unsigned long long* payload, std::string* eof_mark) {
+  if (!payload || !eof_mark) {
     DNOTREACHED();
     return common::make_error_inval();
   }
@@ -1824,12 +2615,26 @@ common::Error DBConnection<Config, ContType>::SendSync(unsigned long long* paylo
       p++;
     }
   }
+  if (p != buf && *(p - 1) == '\r') {
+    p--;
+  }
   *p = '\0';
   if (buf[0] == '-') {
     std::string buf2 = common::MemSPrintf("SYNC with master failed: %s", buf);
     return common::make_error(buf2);
   }
 
+  // diskless replication: $EOF:<40 bytes mark>, the payload size is unknown
+  if (strncmp(buf, "$EOF:", 5) == 0) {
+    const std::string mark = buf + 5;
+    if (mark.size() != kRdbEofMarkSize) {
+      return common::make_error("Bad EOF mark while SYNCing");
+    }
+    *payload = 0;
+    *eof_mark = mark;
+    return common::Error();
+  }
+
   *payload = strtoull(buf + 1, nullptr, 10);
   return common::Error();
 }
@@ -1837,34 +2642,25 @@ common::Error DBConnection<Config, ContType>::SendSync(unsigned long long* paylo
 template <typename Config, ConnectionType ContType>
 common::Error DBConnection<Config, ContType>::LrangeImpl(const NKey& key, int start, int stop, NDbKValue* loaded_key) {
   redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
-  command_buffer_t lrange_cmd;
+  commands_args_t lrange_cmd;
   common::Error err = tran->Lrange(key, start, stop, &lrange_cmd);
   if (err) {
     return err;
   }
 
-  redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, lrange_cmd, &reply);
+  common::Value* val = nullptr;
+  err = ExecCommandToValue(lrange_cmd, &val);
   if (err) {
     return err;
   }
 
-  if (reply->type != REDIS_REPLY_ARRAY) {
-    DNOTREACHED() << "Unexpected type: " << reply->type;
-    freeReplyObject(reply);
-    return common::make_error("I/O error");
-  }
-
-  common::Value* val = nullptr;
-  err = ValueFromReplay(reply, &val);
-  if (err) {
+  if (val->GetType() != common::Value::TYPE_ARRAY) {
+    DNOTREACHED() << "Unexpected type: " << val->GetType();
     delete val;
-    freeReplyObject(reply);
-    return err;
+    return common::make_error("I/O error");
   }
 
   *loaded_key = NDbKValue(key, NValue(val));
-  freeReplyObject(reply);
   return common::Error();
 }
 
@@ -1877,44 +2673,28 @@ common::Error DBConnection<Config, ContType>::SmembersImpl(const NKey& key, NDbK
     return err;
   }
 
-  redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, smembers_cmd, &reply);
+  // members go into the set as they are decoded, without an intermediate array
+  common::SetValue* set = common::Value::CreateSetValue();
+  auto on_member = [set](size_t index, common::Value* member) {
+    UNUSED(index);
+    set->Insert(member);
+  };
+
+  common::Value* val = nullptr;
+  err = ExecCommandToValue(smembers_cmd, &val, on_member);
   if (err) {
+    delete set;
     return err;
   }
 
-  if (reply->type != REDIS_REPLY_ARRAY) {
-    DNOTREACHED() << "Unexpected type: " << reply->type;
-    freeReplyObject(reply);
-    return common::make_error("I/O error");
-  }
-
-  common::Value* val = nullptr;
-  err = ValueFromReplay(reply, &val);
-  if (err) {
+  if (val) {
+    DNOTREACHED() << "Unexpected type: " << val->GetType();
     delete val;
-    freeReplyObject(reply);
-    return err;
-  }
-
-  common::ArrayValue* arr = nullptr;
-  if (!val->GetAsList(&arr)) {
-    delete val;
-    freeReplyObject(reply);
-    return common::make_error("Conversion error array to set");
-  }
-
-  common::SetValue* set = common::Value::CreateSetValue();
-  for (size_t i = 0; i < arr->GetSize(); ++i) {
-    common::Value* lval = nullptr;
-    if (arr->Get(i, &lval)) {
-      set->Insert(lval->DeepCopy());
-    }
+    delete set;
+    return common::make_error("I/O error");
   }
 
-  delete val;
   *loaded_key = NDbKValue(key, NValue(set));
-  freeReplyObject(reply);
   return common::Error();
 }
 
@@ -1927,48 +2707,39 @@ common::Error DBConnection<Config, ContType>::HgetallImpl(const NKey& key, NDbKV
     return err;
   }
 
-  redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, hgetall_cmd, &reply);
-  if (err) {
-    return err;
-  }
+  // [field, value, ...] pairs go into the hash as they are decoded
+  common::HashValue* hash = common::Value::CreateHashValue();
+  common::Value::string_t field;
+  bool is_valid_field = false;
+  auto on_element = [hash, &field, &is_valid_field](size_t index, common::Value* element) {
+    if (index % 2 == 0) {
+      is_valid_field = element->GetAsString(&field);
+      delete element;
+      return;
+    }
 
-  if (reply->type != REDIS_REPLY_ARRAY) {
-    DNOTREACHED() << "Unexpected type: " << reply->type;
-    freeReplyObject(reply);
-    return common::make_error("I/O error");
-  }
+    if (!is_valid_field) {
+      delete element;
+      return;
+    }
+    hash->Insert(field, element);
+  };
 
   common::Value* val = nullptr;
-  err = ValueFromReplay(reply, &val);
+  err = ExecCommandToValue(hgetall_cmd, &val, on_element);
   if (err) {
-    delete val;
-    freeReplyObject(reply);
+    delete hash;
     return err;
   }
 
-  common::ArrayValue* arr = nullptr;
-  if (!val->GetAsList(&arr)) {
+  if (val) {
+    DNOTREACHED() << "Unexpected type: " << val->GetType();
     delete val;
-    freeReplyObject(reply);
-    return common::make_error("Conversion error array to hash");
-  }
-
-  common::HashValue* hash = common::Value::CreateHashValue();
-  for (size_t i = 0; i < arr->GetSize(); i += 2) {
-    common::Value* lkey = nullptr;
-    common::Value* lvalue = nullptr;
-    if (arr->Get(i, &lkey) && arr->Get(i + 1, &lvalue)) {
-      common::Value::string_t key;
-      if (lkey->GetAsString(&key)) {
-        hash->Insert(key, lvalue->DeepCopy());
-      }
-    }
+    delete hash;
+    return common::make_error("I/O error");
   }
 
-  delete val;
   *loaded_key = NDbKValue(key, NValue(hash));
-  freeReplyObject(reply);
   return common::Error();
 }
 
@@ -1985,113 +2756,140 @@ common::Error DBConnection<Config, ContType>::ZrangeImpl(const NKey& key,
     return err;
   }
 
-  redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, zrange, &reply);
-  if (err) {
-    return err;
-  }
-
-  if (reply->type != REDIS_REPLY_ARRAY) {
-    DNOTREACHED() << "Unexpected type: " << reply->type;
-    freeReplyObject(reply);
-    return common::make_error("I/O error");
-  }
+  if (!withscores) {
+    common::Value* val = nullptr;
+    err = ExecCommandToValue(zrange, &val);
+    if (err) {
+      return err;
+    }
 
-  common::Value* val = nullptr;
-  err = ValueFromReplay(reply, &val);
-  if (err) {
-    delete val;
-    freeReplyObject(reply);
-    return err;
-  }
+    if (val->GetType() != common::Value::TYPE_ARRAY) {
+      DNOTREACHED() << "Unexpected type: " << val->GetType();
+      delete val;
+      return common::make_error("I/O error");
+    }
 
-  if (!withscores) {
     *loaded_key = NDbKValue(key, NValue(val));
     if (base_class::client_) {
       base_class::client_->OnLoadedKey(*loaded_key);
     }
-    freeReplyObject(reply);
     return common::Error();
   }
 
-  common::ArrayValue* arr = nullptr;
-  if (!val->GetAsList(&arr)) {
-    delete val;
-    freeReplyObject(reply);
-    return common::make_error("Conversion error array to zset");
-  }
-
+  // [member, score, ...] pairs go into the zset as they are decoded
   common::ZSetValue* zset = common::Value::CreateZSetValue();
-  for (size_t i = 0; i < arr->GetSize(); i += 2) {
-    common::Value* lmember = nullptr;
-    common::Value* lscore = nullptr;
-    if (arr->Get(i, &lmember) && arr->Get(i + 1, &lscore)) {
-      zset->Insert(lscore->DeepCopy(), lmember->DeepCopy());
+  common::Value* member = nullptr;
+  auto on_element = [zset, &member](size_t index, common::Value* element) {
+    if (index % 2 == 0) {
+      delete member;
+      member = element;
+      return;
     }
+
+    zset->Insert(element, member);
+    member = nullptr;
+  };
+
+  common::Value* val = nullptr;
+  err = ExecCommandToValue(zrange, &val, on_element);
+  delete member;
+  if (err) {
+    delete zset;
+    return err;
+  }
+
+  if (val) {
+    DNOTREACHED() << "Unexpected type: " << val->GetType();
+    delete val;
+    delete zset;
+    return common::make_error("I/O error");
   }
 
-  delete val;
   *loaded_key = NDbKValue(key, NValue(zset));
-  freeReplyObject(reply);
   return common::Error();
 }
 
 template <typename Config, ConnectionType ContType>
-common::Error DBConnection<Config, ContType>::ScanImpl(cursor_t cursor_in,
+common::Error DBConnection<Config, ContType>::ScanImpl(const cursor_t& cursor_in,
                                                        const pattern_t& pattern,
                                                        keys_limit_t count_keys,
                                                        raw_keys_t* keys_out,
                                                        cursor_t* cursor_out) {
+  if (cluster_) {
+    return ClusterScan(cursor_in, pattern, count_keys, keys_out, cursor_out);
+  }
+
   const command_buffer_t pattern_result = GetKeysPattern(cursor_in, pattern, count_keys);
   redisReply* reply = nullptr;
-  common::Error err = ExecRedisCommand(base_class::connection_.handle_, pattern_result, &reply);
+  common::Error err = ExecCommand(pattern_result, &reply);
   if (err) {
     return err;
   }
 
-  if (reply->type != REDIS_REPLY_ARRAY) {
+  cursor_t::position_t lcursor_out;
+  if (!ParseScanReply(reply, keys_out, &lcursor_out)) {
     DNOTREACHED() << "Unexpected type: " << reply->type;
     freeReplyObject(reply);
     return common::make_error("I/O error");
   }
 
-  common::Value* val = nullptr;
-  err = ValueFromReplay(reply, &val);
+  *cursor_out = cursor_t(lcursor_out);
   freeReplyObject(reply);
-  reply = nullptr;
-  if (err) {
-    delete val;
-    return err;
+  return common::Error();
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::ClusterScan(const cursor_t& cursor_in,
+                                                          const pattern_t& pattern,
+                                                          keys_limit_t count_keys,
+                                                          raw_keys_t* keys_out,
+                                                          cursor_t* cursor_out) {
+  node_cursors_t nodes;
+  if (cursor_in.IsFinished()) {  // start on every master, or one of its replicas
+    for (const auto& node : cluster_->GetReadNodes()) {
+      nodes.push_back(std::make_pair(node, 0));
+    }
+  } else if (!ParseClusterCursor(cursor_in, &nodes)) {
+    return common::make_error_inval();
   }
 
-  common::ArrayValue* arr = static_cast<common::ArrayValue*>(val);
-  CHECK_EQ(2, arr->GetSize());
-  command_buffer_t cursor_out_str;
-  if (!arr->GetString(0, &cursor_out_str)) {
-    delete val;
-    return common::make_error("I/O error");
+  if (nodes.empty()) {
+    *cursor_out = cursor_t();
+    return common::Error();
   }
 
-  common::ArrayValue* arr_keys = nullptr;
-  if (!arr->GetList(1, &arr_keys)) {
-    delete val;
-    return common::make_error("I/O error");
+  // split the page between the masters, COUNT is only a hint anyway
+  const keys_limit_t node_count = std::max<keys_limit_t>(1, (count_keys + nodes.size() - 1) / nodes.size());
+  std::vector<common::net::HostAndPort> hosts;
+  std::vector<commands_args_t> cmds;
+  for (const auto& node : nodes) {
+    hosts.push_back(node.first);
+    cmds.push_back({GEN_CMD_STRING(DB_SCAN_COMMAND), common::ConvertToCharBytes(node.second), GEN_CMD_STRING("MATCH"),
+                    common::ConvertToCharBytes(pattern), GEN_CMD_STRING("COUNT"),
+                    common::ConvertToCharBytes(node_count)});
   }
 
-  for (size_t i = 0; i < arr_keys->GetSize(); ++i) {
-    command_buffer_t key;
-    if (arr_keys->GetString(i, &key)) {
-      keys_out->push_back(key);
+  raw_keys_t lkeys;
+  node_cursors_t next_nodes;
+  auto on_reply = [&nodes, &lkeys, &next_nodes](size_t index, redisReply* reply) -> common::Error {
+    cursor_t::position_t position;
+    if (!ParseScanReply(reply, &lkeys, &position)) {
+      DNOTREACHED() << "Unexpected type: " << reply->type;
+      return common::make_error("I/O error");
     }
-  }
 
-  cursor_t lcursor_out;
-  if (!common::ConvertFromBytes(cursor_out_str, &lcursor_out)) {
-    return common::make_error_inval();
+    if (position != 0) {
+      next_nodes.push_back(std::make_pair(nodes[index].first, position));
+    }
+    return common::Error();
+  };
+  common::Error err = cluster_->ExecOnNodes(hosts, cmds, on_reply);
+  if (err) {
+    return err;
   }
 
-  *cursor_out = lcursor_out;
-  delete val;
+  keys_out->insert(keys_out->end(), lkeys.begin(), lkeys.end());
+  *cursor_out = MakeClusterCursor(next_nodes);
   return common::Error();
 }
 
@@ -2109,9 +2907,39 @@ common::Error DBConnection<Config, ContType>::KeysImpl(const raw_key_t& key_star
 
 template <typename Config, ConnectionType ContType>
 common::Error DBConnection<Config, ContType>::DBKeysCountImpl(keys_limit_t* size) {
+  common::Error err = CheckFailover();  // raw commands below skip ExecCommand
+  if (err) {
+    return err;
+  }
+
+  if (cluster_) {  // every master holds its own slots
+    const std::vector<common::net::HostAndPort> masters = cluster_->GetMasters();
+    const std::vector<commands_args_t> cmds(masters.size(), commands_args_t{GEN_CMD_STRING(DBSIZE)});
+    keys_limit_t lsize = 0;
+    auto on_reply = [&lsize](size_t index, redisReply* reply) -> common::Error {
+      UNUSED(index);
+      if (reply->type != REDIS_REPLY_INTEGER) {
+        return common::make_error("Couldn't determine " DB_DBKCOUNT_COMMAND "!");
+      }
+
+      lsize += static_cast<keys_limit_t>(reply->integer);
+      return common::Error();
+    };
+    err = cluster_->ExecOnNodes(masters, cmds, on_reply);
+    if (err) {
+      return err;
+    }
+
+    *size = lsize;
+    return common::Error();
+  }
+
   redisReply* reply = reinterpret_cast<redisReply*>(redisCommand(base_class::connection_.handle_, DBSIZE));
 
   if (!reply || reply->type != REDIS_REPLY_INTEGER) {
+    if (reply) {
+      freeReplyObject(reply);
+    }
     return common::make_error("Couldn't determine " DB_DBKCOUNT_COMMAND "!");
   }
 
@@ -2123,11 +2951,20 @@ common::Error DBConnection<Config, ContType>::DBKeysCountImpl(keys_limit_t* size
 
 template <typename Config, ConnectionType ContType>
 common::Error DBConnection<Config, ContType>::FlushDBImpl() {
+  common::Error err = CheckFailover();
+  if (err) {
+    return err;
+  }
+
   redisReply* reply = reinterpret_cast<redisReply*>(redisCommand(base_class::connection_.handle_, DB_FLUSHDB_COMMAND));
   if (!reply) {
     return PrintRedisContextError(base_class::connection_.handle_);
   }
 
+  if (near_cache_) {
+    near_cache_->Clear();
+  }
+
   freeReplyObject(reply);
   return common::Error();
 }
@@ -2147,13 +2984,19 @@ common::Error DBConnection<Config, ContType>::SelectImpl(const db_name_t& name,
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, select_cmd, &reply);
+  err = ExecCommand(select_cmd, &reply);
   if (err) {
     return err;
   }
 
   base_class::connection_.config_->db_num = num;
   cur_db_ = num;
+  if (cluster_) {
+    cluster_->SelectDB(num);
+  }
+  if (near_cache_) {  // same names, other keys
+    near_cache_->Clear();
+  }
   keys_limit_t sz = 0;
   err = base_class::DBKeysCount(&sz);
   DCHECK(!err);
@@ -2165,39 +3008,33 @@ common::Error DBConnection<Config, ContType>::SelectImpl(const db_name_t& name,
 
 template <typename Config, ConnectionType ContType>
 common::Error DBConnection<Config, ContType>::DeleteImpl(const NKeys& keys, NKeys* deleted_keys) {
+  // one DEL per key keeps the per key result, pipelining hides the round trips
+  redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
+  std::vector<commands_args_t> cmds(keys.size());
   for (size_t i = 0; i < keys.size(); ++i) {
-    NKey key = keys[i];
-    command_buffer_t del_cmd;
-    redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
-    common::Error err = tran->DeleteKeyCommand(key, &del_cmd);
+    common::Error err = tran->DeleteKeyCommand(keys[i], &cmds[i]);
     if (err) {
       return err;
     }
-
-    redisReply* reply = nullptr;
-    err = ExecRedisCommand(base_class::connection_.handle_, del_cmd, &reply);
-    if (err) {
-      return err;
-    }
-
-    if (reply->type != REDIS_REPLY_INTEGER) {
-      DNOTREACHED() << "Unexpected type: " << reply->type;
-      freeReplyObject(reply);
-      return common::make_error("I/O error");
-    }
-
-    if (reply->integer == 1) {
-      deleted_keys->push_back(key);
-    }
-    freeReplyObject(reply);
   }
 
-  return common::Error();
+  return ExecPipeline(cmds, pipeline_window,
+                      [&keys, deleted_keys](size_t index, redisReply* reply) -> common::Error {
+                        if (reply->type != REDIS_REPLY_INTEGER) {
+                          DNOTREACHED() << "Unexpected type: " << reply->type;
+                          return common::make_error("I/O error");
+                        }
+
+                        if (reply->integer == 1) {
+                          deleted_keys->push_back(keys[index]);
+                        }
+                        return common::Error();
+                      });
 }
 
 template <typename Config, ConnectionType ContType>
 common::Error DBConnection<Config, ContType>::SetImpl(const NDbKValue& key) {
-  command_buffer_t set_cmd;
+  commands_args_t set_cmd;
   redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
   common::Error err = tran->CreateKeyCommand(key, &set_cmd);
   if (err) {
@@ -2205,7 +3042,7 @@ common::Error DBConnection<Config, ContType>::SetImpl(const NDbKValue& key) {
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, set_cmd, &reply);
+  err = ExecCommand(set_cmd, &reply);
   if (err) {
     return err;
   }
@@ -2216,7 +3053,7 @@ common::Error DBConnection<Config, ContType>::SetImpl(const NDbKValue& key) {
 
 template <typename Config, ConnectionType ContType>
 common::Error DBConnection<Config, ContType>::GetImpl(const NKey& key, NDbKValue* loaded_key) {
-  command_buffer_t get_cmd;
+  commands_args_t get_cmd;
   redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
   common::Error err = tran->LoadKeyCommand(key, common::Value::TYPE_STRING, &get_cmd);
   if (err) {
@@ -2224,7 +3061,7 @@ common::Error DBConnection<Config, ContType>::GetImpl(const NKey& key, NDbKValue
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, get_cmd, &reply);
+  err = ExecCommand(get_cmd, &reply);
   if (err) {
     return err;
   }
@@ -2248,7 +3085,12 @@ common::Error DBConnection<Config, ContType>::GetImpl(const NKey& key, NDbKValue
 
 template <typename Config, ConnectionType ContType>
 common::Error DBConnection<Config, ContType>::GetTypeImpl(const NKey& key, readable_string_t* type) {
-  command_buffer_t get_type_cmd;
+  NearCache* cache = GetNearCache();
+  if (cache && cache->GetType(key, type)) {
+    return common::Error();
+  }
+
+  commands_args_t get_type_cmd;
   redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
   common::Error err = tran->GetTypeCommand(key, &get_type_cmd);
   if (err) {
@@ -2256,7 +3098,7 @@ common::Error DBConnection<Config, ContType>::GetTypeImpl(const NKey& key, reada
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, get_type_cmd, &reply);
+  err = ExecCommand(get_type_cmd, &reply);
   if (err) {
     return err;
   }
@@ -2274,96 +3116,504 @@ common::Error DBConnection<Config, ContType>::GetTypeImpl(const NKey& key, reada
   }
 
   *type = type_str;
+  if (cache) {
+    cache->SetType(key, type_str);
+  }
   freeReplyObject(reply);
   return common::Error();
 }
 
 template <typename Config, ConnectionType ContType>
-common::Error DBConnection<Config, ContType>::GetUniImpl(const NKey& key, NDbKValue* loaded_key) {
-  readable_string_t type_str;
-  common::Error err = base_class::GetType(key, &type_str);
+common::Error DBConnection<Config, ContType>::LoadTypedValueScript() {
+  redisReply* reply = nullptr;
+  const commands_args_t load_cmd = {GEN_CMD_STRING("SCRIPT"), GEN_CMD_STRING("LOAD"),
+                                    GEN_CMD_STRING(kLoadTypedValueScript)};
+  common::Error err = ExecCommand(load_cmd, &reply);
   if (err) {
-    return err;
+    if (base_class::connection_.handle_->err) {  // i/o problem, not a missing feature
+      return err;
+    }
+
+    if (IsScriptingUnavailableError(err->GetDescription())) {
+      is_scripting_supported_ = false;
+    }
+    return common::Error();
   }
 
-  if (type_str == GEN_CMD_STRING("string")) {
-    return GetImpl(key, loaded_key);
-  } else if (type_str == GEN_CMD_STRING("list")) {
-    return LrangeImpl(key, 0, -1, loaded_key);
-  } else if (type_str == GEN_CMD_STRING("set")) {
-    return SmembersImpl(key, loaded_key);
-  } else if (type_str == GEN_CMD_STRING("hash")) {
-    return HgetallImpl(key, loaded_key);
-  } else if (type_str == GEN_CMD_STRING("zset")) {
-    return ZrangeImpl(key, 0, -1, true, loaded_key);
+  if (reply->type != REDIS_REPLY_STRING) {
+    is_scripting_supported_ = false;
+    freeReplyObject(reply);
+    return common::Error();
   }
 
-  std::stringstream wr;
-  wr << "Unknown type: " << common::ConvertToString(type_str);
-  return common::make_error(wr.str());
+  load_typed_value_sha_ = GEN_CMD_STRING_SIZE(reply->str, reply->len);
+  freeReplyObject(reply);
+  return common::Error();
 }
 
 template <typename Config, ConnectionType ContType>
-common::Error DBConnection<Config, ContType>::RenameImpl(const NKey& key, const nkey_t& new_key) {
-  redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
-  command_buffer_t rename_cmd;
-  common::Error err = tran->RenameKeyCommand(key, new_key, &rename_cmd);
-  if (err) {
-    return err;
+common::Error DBConnection<Config, ContType>::LoadTypedValue(const NKey& key,
+                                                             readable_string_t* type,
+                                                             NDbKValue* loaded_key,
+                                                             bool* loaded) {
+  if (!type || !loaded_key || !loaded) {
+    DNOTREACHED();
+    return common::make_error_inval();
   }
 
-  redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, rename_cmd, &reply);
+  partial_loads_.erase(key.GetKey().GetData().as_string());  // a new load replaces the kept page state
+
+  NearCache* cache = GetNearCache();
+  if (cache && cache->GetValue(key, loaded_key) && cache->GetType(key, type)) {
+    *loaded = true;
+    return common::Error();
+  }
+
+  common::Error err = LoadTypedValueImpl(key, type, loaded_key, loaded);
   if (err) {
     return err;
   }
 
-  freeReplyObject(reply);
+  if (cache && *loaded) {
+    cache->SetValue(*loaded_key, *type);
+  }
   return common::Error();
 }
 
 template <typename Config, ConnectionType ContType>
-common::Error DBConnection<Config, ContType>::SetTTLImpl(const NKey& key, ttl_t ttl) {
-  redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
-  command_buffer_t ttl_cmd;
-  // PERSIST/EXPIRE
-  common::Error err = tran->ChangeKeyTTLCommand(key, ttl, &ttl_cmd);
-  if (err) {
-    return err;
+common::Error DBConnection<Config, ContType>::LoadTypedValueImpl(const NKey& key,
+                                                                 readable_string_t* type,
+                                                                 NDbKValue* loaded_key,
+                                                                 bool* loaded) {
+  *loaded = false;
+  if (!is_scripting_supported_) {
+    return common::Error();
   }
 
-  redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, ttl_cmd, &reply);
-  if (err) {
-    return err;
+  if (load_typed_value_sha_.empty()) {
+    common::Error err = LoadTypedValueScript();
+    if (err) {
+      return err;
+    }
+    if (!is_scripting_supported_) {
+      return common::Error();
+    }
   }
 
-  if (reply->type != REDIS_REPLY_INTEGER) {
-    DNOTREACHED() << "Unexpected type: " << reply->type;
-    freeReplyObject(reply);
-    return common::make_error("I/O error");
-  }
+  const auto key_str = key.GetKey();
+  commands_args_t evalsha_cmd = {GEN_CMD_STRING("EVALSHA"), load_typed_value_sha_, GEN_CMD_STRING("1"),
+                                 key_str.GetData(), common::ConvertToBytes(keys_limit_t(large_collection_size))};
+  // [type, value] is streamed, the value is kept as decoded
+  common::Value* type_val = nullptr;
+  common::Value* value_val = nullptr;
+  auto on_element = [&type_val, &value_val](size_t index, common::Value* element) {
+    if (index == 0 && !type_val) {
+      type_val = element;
+    } else if (index == 1 && !value_val) {
+      value_val = element;
+    } else {
+      delete element;
+    }
+  };
+  auto reset = [&type_val, &value_val]() {
+    delete type_val;
+    delete value_val;
+    type_val = nullptr;
+    value_val = nullptr;
+  };
 
-  if (reply->integer == 0) {  // key not exists
-    freeReplyObject(reply);
-    return base_class::GenerateError(DB_SET_TTL_COMMAND, "key does not exist or the timeout could not be set.");
+  common::Value* val = nullptr;
+  common::Error err = ExecReadCommandToValue(evalsha_cmd, &val, on_element);
+  if (err && !base_class::connection_.handle_->err && err->GetDescription().compare(0, 8, "NOSCRIPT") == 0) {
+    // script cache was flushed or the key lives on another cluster node,
+    // EVAL caches the script on that node under the same sha
+    reset();
+    evalsha_cmd[0] = GEN_CMD_STRING("EVAL");
+    evalsha_cmd[1] = GEN_CMD_STRING(kLoadTypedValueScript);
+    err = ExecReadCommandToValue(evalsha_cmd, &val, on_element);
   }
 
-  freeReplyObject(reply);
-  return common::Error();
-}
-
-template <typename Config, ConnectionType ContType>
-common::Error DBConnection<Config, ContType>::GetTTLImpl(const NKey& key, ttl_t* ttl) {
-  redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
-  command_buffer_t ttl_cmd;
-  common::Error err = tran->LoadKeyTTLCommand(key, &ttl_cmd);
+  if (err) {
+    reset();
+    if (base_class::connection_.handle_->err) {
+      return err;
+    }
+
+    if (IsScriptingUnavailableError(err->GetDescription())) {
+      is_scripting_supported_ = false;  // e.g. scripts are blocked by acl, use plain commands
+    }
+    return common::Error();
+  }
+
+  readable_string_t type_str;
+  if (val || !type_val || !type_val->GetAsString(&type_str)) {
+    DNOTREACHED() << "Unexpected script reply";
+    delete val;
+    reset();
+    return common::make_error("I/O error");
+  }
+
+  if (type_str == GEN_CMD_STRING("none")) {
+    reset();
+    return base_class::GenerateError(DB_KEY_TYPE_COMMAND, "key not found.");
+  }
+
+  *type = type_str;
+  if (!value_val) {
+    reset();
+    return common::Error();
+  }
+
+  common::Value::Type value_type = common::Value::TYPE_NULL;
+  if (type_str == GEN_CMD_STRING("string")) {
+    value_type = common::Value::TYPE_STRING;
+  } else if (type_str == GEN_CMD_STRING("list")) {
+    value_type = common::Value::TYPE_ARRAY;
+  } else if (type_str == GEN_CMD_STRING("set")) {
+    value_type = common::Value::TYPE_SET;
+  } else if (type_str == GEN_CMD_STRING("hash")) {
+    value_type = common::Value::TYPE_HASH;
+  } else if (type_str == GEN_CMD_STRING("zset")) {
+    value_type = common::Value::TYPE_ZSET;
+  }
+
+  if (value_type == common::Value::TYPE_NULL) {
+    reset();
+    return common::Error();
+  }
+
+  common::Value* typed = nullptr;
+  err = TypedValueFromValue(value_val, value_type, &typed);
+  value_val = nullptr;
+  reset();
+  if (err) {
+    DNOTREACHED() << "Unexpected script reply: " << err->GetDescription();
+    return common::make_error("I/O error");
+  }
+
+  *loaded_key = NDbKValue(key, NValue(typed));
+  *loaded = true;
+  return common::Error();
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::GetUniImpl(const NKey& key, NDbKValue* loaded_key) {
+  readable_string_t type_str;
+  bool loaded = false;
+  common::Error err = LoadTypedValue(key, &type_str, loaded_key, &loaded);
+  if (err) {
+    return err;
+  }
+
+  if (loaded) {
+    return common::Error();
+  }
+
+  if (type_str.empty()) {
+    err = base_class::GetType(key, &type_str);
+    if (err) {
+      return err;
+    }
+  }
+
+  if (type_str == GEN_CMD_STRING("string")) {
+    return GetImpl(key, loaded_key);
+  }
+
+  common::Value::Type type = common::Value::TYPE_NULL;
+  if (ConvertFromString(type_str, &type) &&
+      (type == common::Value::TYPE_ARRAY || type == common::Value::TYPE_SET || type == common::Value::TYPE_HASH ||
+       type == common::Value::TYPE_ZSET)) {
+    return GetCollectionImpl(key, type, loaded_key);
+  }
+
+  std::stringstream wr;
+  wr << "Unknown type: " << common::ConvertToString(type_str);
+  return common::make_error(wr.str());
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::GetCollectionImpl(const NKey& key,
+                                                                common::Value::Type type,
+                                                                NDbKValue* loaded_key) {
+  size_t size = 0;
+  common::Error err = GetCollectionSize(key, type, &size);
+  if (err) {
+    return err;
+  }
+
+  if (size > large_collection_size) {  // the rest is read on demand with GetCollectionPage
+    return LoadCollectionFirstPage(key, type, size, loaded_key);
+  }
+
+  if (type == common::Value::TYPE_ARRAY) {
+    return LrangeImpl(key, 0, -1, loaded_key);
+  } else if (type == common::Value::TYPE_SET) {
+    return SmembersImpl(key, loaded_key);
+  } else if (type == common::Value::TYPE_HASH) {
+    return HgetallImpl(key, loaded_key);
+  } else if (type == common::Value::TYPE_ZSET) {
+    return ZrangeImpl(key, 0, -1, true, loaded_key);
+  }
+
+  DNOTREACHED() << "Not a collection type: " << type;
+  return common::make_error_inval();
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::GetUniManyImpl(const NKeys& keys, std::vector<NDbKValue>* loaded_keys) {
+  redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
+  std::vector<commands_args_t> type_cmds(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    common::Error err = tran->GetTypeCommand(keys[i], &type_cmds[i]);
+    if (err) {
+      return err;
+    }
+  }
+
+  // first pass: types of the whole page
+  std::vector<common::Value::Type> types(keys.size(), common::Value::TYPE_NULL);
+  std::vector<bool> load_alone(keys.size(), false);  // modules types and large collections
+  common::Error err = ExecPipeline(
+      type_cmds, pipeline_window,
+      [this, &types, &load_alone](size_t index, redisReply* reply) -> common::Error {
+        if (reply->type != REDIS_REPLY_STATUS) {
+          DNOTREACHED() << "Unexpected type: " << reply->type;
+          return common::make_error("I/O error");
+        }
+
+        const auto type_str = GEN_CMD_STRING_SIZE(reply->str, reply->len);
+        if (type_str == GEN_CMD_STRING("none")) {  // removed after the scan, skipped
+          return common::Error();
+        }
+
+        if (type_str == GEN_CMD_STRING("string")) {
+          types[index] = common::Value::TYPE_STRING;
+        } else if (type_str == GEN_CMD_STRING("list")) {
+          types[index] = common::Value::TYPE_ARRAY;
+        } else if (type_str == GEN_CMD_STRING("set")) {
+          types[index] = common::Value::TYPE_SET;
+        } else if (type_str == GEN_CMD_STRING("hash")) {
+          types[index] = common::Value::TYPE_HASH;
+        } else if (type_str == GEN_CMD_STRING("zset")) {
+          types[index] = common::Value::TYPE_ZSET;
+        } else {
+          load_alone[index] = true;
+        }
+        return common::Error();
+      });
+  if (err) {
+    return err;
+  }
+
+  // sizes of the collections, large ones go through GetUniImpl and are read in pages
+  std::vector<commands_args_t> size_cmds;
+  std::vector<size_t> size_indexes;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (types[i] == common::Value::TYPE_NULL || types[i] == common::Value::TYPE_STRING) {
+      continue;
+    }
+
+    commands_args_t size_cmd;
+    err = tran->CollectionSize(keys[i], types[i], &size_cmd);
+    if (err) {
+      return err;
+    }
+    size_cmds.push_back(size_cmd);
+    size_indexes.push_back(i);
+  }
+
+  err = ExecPipeline(size_cmds, pipeline_window,
+                     [&types, &load_alone, &size_indexes](size_t index, redisReply* reply) -> common::Error {
+                       if (reply->type != REDIS_REPLY_INTEGER) {
+                         DNOTREACHED() << "Unexpected type: " << reply->type;
+                         return common::make_error("I/O error");
+                       }
+
+                       const size_t key_index = size_indexes[index];
+                       if (reply->integer > large_collection_size) {
+                         types[key_index] = common::Value::TYPE_NULL;
+                         load_alone[key_index] = true;
+                       }
+                       return common::Error();
+                     });
+  if (err) {
+    return err;
+  }
+
+  // second pass: values of the core types, others go through GetUniImpl one by one
+  std::vector<commands_args_t> load_cmds;
+  std::vector<size_t> load_indexes;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (types[i] == common::Value::TYPE_NULL) {
+      continue;
+    }
+
+    commands_args_t load_cmd;
+    err = tran->LoadKeyCommand(keys[i], types[i], &load_cmd);
+    if (err) {
+      return err;
+    }
+    load_cmds.push_back(load_cmd);
+    load_indexes.push_back(i);
+  }
+
+  std::vector<NDbKValue> lloaded_keys(keys.size());
+  std::vector<bool> present(keys.size(), false);
+  err = ExecPipelineToValues(
+      load_cmds, pipeline_window,
+      [&keys, &types, &load_indexes, &lloaded_keys, &present](size_t index, common::Value* val) -> common::Error {
+        const size_t key_index = load_indexes[index];
+        // removed between the passes, redis never keeps an empty collection
+        common::ArrayValue* arr = nullptr;
+        if (val->GetType() == common::Value::TYPE_NULL || (val->GetAsList(&arr) && arr->IsEmpty())) {
+          delete val;
+          return common::Error();
+        }
+
+        common::Value* typed = nullptr;
+        common::Error lerr = TypedValueFromValue(val, types[key_index], &typed);
+        if (lerr) {
+          return lerr;
+        }
+
+        lloaded_keys[key_index] = NDbKValue(keys[key_index], NValue(typed));
+        present[key_index] = true;
+        return common::Error();
+      });
+  if (err) {
+    return err;
+  }
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (!load_alone[i]) {
+      continue;
+    }
+
+    err = GetUniImpl(keys[i], &lloaded_keys[i]);
+    if (err) {
+      if (base_class::connection_.handle_->err) {
+        return err;
+      }
+
+      // the error may only mean the key is gone by now, ask again before failing the page
+      redisReply* reply = nullptr;
+      common::Error type_err = ExecCommand(type_cmds[i], &reply);
+      if (type_err) {
+        return err;
+      }
+
+      const bool removed = reply->type == REDIS_REPLY_STATUS &&
+                           GEN_CMD_STRING_SIZE(reply->str, reply->len) == GEN_CMD_STRING("none");
+      freeReplyObject(reply);
+      if (!removed) {
+        return err;
+      }
+      continue;
+    }
+    present[i] = true;
+  }
+
+  // ttls of the loaded keys in one more pipeline instead of a TTL per key
+  NKeys ttl_keys;
+  std::vector<size_t> ttl_indexes;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (present[i]) {
+      ttl_keys.push_back(keys[i]);
+      ttl_indexes.push_back(i);
+    }
+  }
+
+  std::vector<ttl_t> ttls;
+  err = LoadTTLMany(ttl_keys, &ttls);
+  if (err) {
+    return err;
+  }
+
+  std::vector<NDbKValue> result;
+  result.reserve(ttl_keys.size());
+  for (size_t i = 0; i < ttl_indexes.size(); ++i) {
+    if (ttls[i] == EXPIRED_TTL) {  // expired after it was loaded
+      continue;
+    }
+
+    NDbKValue& loaded = lloaded_keys[ttl_indexes[i]];
+    NKey key = loaded.GetKey();
+    key.SetTTL(ttls[i]);
+    loaded.SetKey(key);
+    result.push_back(loaded);
+  }
+
+  *loaded_keys = result;
+  return common::Error();
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::RenameImpl(const NKey& key, const nkey_t& new_key) {
+  redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
+  commands_args_t rename_cmd;
+  common::Error err = tran->RenameKeyCommand(key, new_key, &rename_cmd);
+  if (err) {
+    return err;
+  }
+
+  redisReply* reply = nullptr;
+  err = ExecCommand(rename_cmd, &reply);
+  if (err) {
+    return err;
+  }
+
+  freeReplyObject(reply);
+  return common::Error();
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::SetTTLImpl(const NKey& key, ttl_t ttl) {
+  redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
+  commands_args_t ttl_cmd;
+  // PERSIST/EXPIRE
+  common::Error err = tran->ChangeKeyTTLCommand(key, ttl, &ttl_cmd);
   if (err) {
     return err;
   }
 
   redisReply* reply = nullptr;
-  err = ExecRedisCommand(base_class::connection_.handle_, ttl_cmd, &reply);
+  err = ExecCommand(ttl_cmd, &reply);
+  if (err) {
+    return err;
+  }
+
+  if (reply->type != REDIS_REPLY_INTEGER) {
+    DNOTREACHED() << "Unexpected type: " << reply->type;
+    freeReplyObject(reply);
+    return common::make_error("I/O error");
+  }
+
+  if (reply->integer == 0) {  // key not exists
+    freeReplyObject(reply);
+    return base_class::GenerateError(DB_SET_TTL_COMMAND, "key does not exist or the timeout could not be set.");
+  }
+
+  freeReplyObject(reply);
+  return common::Error();
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::GetTTLImpl(const NKey& key, ttl_t* ttl) {
+  NearCache* cache = GetNearCache();
+  if (cache && cache->GetTTL(key, ttl)) {
+    return common::Error();
+  }
+
+  redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
+  commands_args_t ttl_cmd;
+  common::Error err = tran->LoadKeyTTLCommand(key, &ttl_cmd);
+  if (err) {
+    return err;
+  }
+
+  redisReply* reply = nullptr;
+  err = ExecCommand(ttl_cmd, &reply);
   if (err) {
     return err;
   }
@@ -2375,6 +3625,9 @@ common::Error DBConnection<Config, ContType>::GetTTLImpl(const NKey& key, ttl_t*
   }
 
   *ttl = reply->integer;
+  if (cache) {
+    cache->SetTTL(key, *ttl);
+  }
   freeReplyObject(reply);
   return common::Error();
 }
@@ -2437,64 +3690,116 @@ common::Error DBConnection<Config, ContType>::DBSize(keys_limit_t* size) {
 template <typename Config, ConnectionType ContType>
 common::Error DBConnection<Config, ContType>::ExecuteAsPipeline(
     const std::vector<FastoObjectCommandIPtr>& cmds,
-    void (*log_command_cb)(FastoObjectCommandIPtr command)) {
+    void (*log_command_cb)(FastoObjectCommandIPtr command),
+    size_t window) {
   if (cmds.empty()) {
     return common::make_error("Invalid input command");
   }
 
+  if (window == 0) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
   common::Error err = base_class::TestIsAuthenticated();
   if (err) {
     return err;
   }
 
-  // start piplene mode
-  std::vector<FastoObjectCommandIPtr> valid_cmds;
-  for (size_t i = 0; i < cmds.size(); ++i) {
-    FastoObjectCommandIPtr cmd = cmds[i];
-    command_buffer_t command = cmd->GetInputCommand();
-    if (command.empty()) {
-      continue;
-    }
+  err = CheckFailover();  // commands below go straight to the handle
+  if (err) {
+    return err;
+  }
 
-    if (log_command_cb) {
-      log_command_cb(cmd);
-    }
+  // one window is parsed, sent and read at a time, the containers are reused by every window
+  // so memory stays flat however long the batch is
+  const size_t slots = std::min(window, cmds.size());
+  std::vector<FastoObjectCommandIPtr> sent;
+  std::vector<command_buffer_t> lines(slots);  // the views point into these or into unescaped
+  std::vector<command_args_views_t> sent_argv(slots);
+  std::vector<commands_args_t> unescaped(slots);
+  std::vector<const char*> argv;
+  std::vector<size_t> argvlen;
+  sent.reserve(slots);
+
+  // the whole window is always read back like in ExecRedisPipeline, an error reply is attached to its own command
+  common::Error first_err;
+  auto read_replies = [this, &sent, &first_err](size_t count) -> common::Error {
+    for (size_t i = 0; i < count; ++i) {
+      common::Error err = CliReadReply(sent[i].get());
+      if (!err) {
+        continue;
+      }
 
-    commands_args_t standart_argv;
-    if (!ParseCommandLine(command, &standart_argv)) {
-      return common::make_error_inval();
+      if (!base_class::connection_.handle_ || base_class::connection_.handle_->err) {
+        // the stream is broken, nothing more can be read from it
+        return err;
+      }
+
+      common::Value* val = common::Value::CreateStringValueFromBasicString(err->GetDescription());
+      FastoObject* obj = new FastoObject(sent[i].get(), val, base_class::GetDelimiter());
+      sent[i]->AddChildren(obj);
+      if (!first_err) {
+        first_err = err;
+      }
     }
+    return common::Error();
+  };
 
-    if (IsPipeLineCommand(standart_argv[0])) {
-      valid_cmds.push_back(cmd);
+  // start piplene mode
+  size_t next = 0;
+  while (next < cmds.size()) {
+    // a bad line fails before anything of its window is appended
+    sent.clear();
+    size_t count = 0;
+    for (; next < cmds.size() && count < slots; ++next) {
+      lines[count] = cmds[next]->GetInputCommand();
+      if (lines[count].empty()) {
+        continue;
+      }
 
-      size_t argc = standart_argv.size();
-      void* raw_argvlen_ptr = malloc(argc * sizeof(size_t));
-      void* raw_argv_ptr = malloc(argc * sizeof(char*));
+      if (!ParseCommandLine(lines[count], &sent_argv[count], &unescaped[count])) {
+        return common::make_error_inval();
+      }
 
-      size_t* argvlen = reinterpret_cast<size_t*>(raw_argvlen_ptr);
-      const char** argv = reinterpret_cast<const char**>(raw_argv_ptr);
-      for (size_t i = 0; i < argc; ++i) {
-        argv[i] = standart_argv[i].data();  // safe
-        argvlen[i] = standart_argv[i].size();
+      if (!IsPipeLineCommand(sent_argv[count][0])) {
+        continue;
       }
 
-      redisAppendCommandArgv(base_class::connection_.handle_, argc, argv, argvlen);
-      free(raw_argv_ptr);
-      free(raw_argvlen_ptr);
+      sent.push_back(cmds[next]);
+      count++;
     }
-  }
 
-  for (size_t i = 0; i < valid_cmds.size(); ++i) {
-    FastoObjectCommandIPtr cmd = cmds[i];
-    common::Error err = CliReadReply(cmd.get());
+    for (size_t i = 0; i < count; ++i) {
+      if (log_command_cb) {
+        log_command_cb(sent[i]);
+      }
+
+      const command_args_views_t& standart_argv = sent_argv[i];
+      InvalidateWrittenKey(standart_argv);  // console writes bypass ExecCommand
+      const size_t argc = standart_argv.size();
+      argv.resize(argc);
+      argvlen.resize(argc);
+      for (size_t j = 0; j < argc; ++j) {
+        argv[j] = standart_argv[j].data();
+        argvlen[j] = standart_argv[j].size();
+      }
+
+      if (redisAppendCommandArgv(base_class::connection_.handle_, argc, argv.data(), argvlen.data()) == REDIS_ERR) {
+        // commands appended so far still have replies coming, read them so the context stays in sync
+        common::Error append_err = PrintRedisContextError(base_class::connection_.handle_);
+        err = read_replies(i);
+        return err ? err : append_err;
+      }
+    }
+
+    err = read_replies(count);
     if (err) {
       return err;
     }
   }
   // end piplene
-
-  return common::Error();
+  return first_err;
 }
 
 template <typename Config, ConnectionType ContType>
@@ -2509,42 +3814,290 @@ common::Error DBConnection<Config, ContType>::Unlink(const NKeys& keys, NKeys* d
     return err;
   }
 
-  NKeys ldeleted_keys;
+  redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
+  std::vector<commands_args_t> cmds(keys.size());
   for (size_t i = 0; i < keys.size(); ++i) {
-    NKey key = keys[i];
-    command_buffer_t unlink_cmd;
-    redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
-    common::Error err = tran->Unlink(key, &unlink_cmd);
+    err = tran->Unlink(keys[i], &cmds[i]);
     if (err) {
       return err;
     }
+  }
+
+  NKeys ldeleted_keys;
+  err = ExecPipeline(cmds, pipeline_window,
+                     [&keys, &ldeleted_keys](size_t index, redisReply* reply) -> common::Error {
+                       if (reply->type != REDIS_REPLY_INTEGER) {
+                         DNOTREACHED() << "Unexpected type: " << reply->type;
+                         return common::make_error("I/O error");
+                       }
+
+                       if (reply->integer == 1) {
+                         ldeleted_keys.push_back(keys[index]);
+                       }
+                       return common::Error();
+                          });
+  if (err) {
+    return err;
+  }
+
+  if (base_class::client_ && !ldeleted_keys.empty()) {
+    base_class::client_->OnRemovedKeys(ldeleted_keys);
+  }
+
+  *deleted_keys = ldeleted_keys;
+  return common::Error();
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::GetTTLMany(const NKeys& keys, std::vector<ttl_t>* ttls) {
+  if (!ttls) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  common::Error err = base_class::TestIsAuthenticated();
+  if (err) {
+    return err;
+  }
+
+  std::vector<ttl_t> lttls;
+  err = LoadTTLMany(keys, &lttls);
+  if (err) {
+    return err;
+  }
+
+  if (base_class::client_) {
+    for (size_t i = 0; i < keys.size(); ++i) {
+      base_class::client_->OnLoadedKeyTTL(keys[i], lttls[i]);
+    }
+  }
 
-    redisReply* reply = nullptr;
-    err = redis_compatible::ExecRedisCommand(base_class::connection_.handle_, unlink_cmd, &reply);
+  *ttls = lttls;
+  return common::Error();
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::LoadTTLMany(const NKeys& keys, std::vector<ttl_t>* ttls) {
+  redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
+  std::vector<commands_args_t> cmds(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    common::Error err = tran->LoadKeyTTLCommand(keys[i], &cmds[i]);
     if (err) {
       return err;
     }
+  }
 
+  std::vector<ttl_t> lttls(keys.size(), EXPIRED_TTL);
+  common::Error err = ExecPipeline(cmds, pipeline_window, [&lttls](size_t index, redisReply* reply) -> common::Error {
     if (reply->type != REDIS_REPLY_INTEGER) {
       DNOTREACHED() << "Unexpected type: " << reply->type;
-      freeReplyObject(reply);
       return common::make_error("I/O error");
     }
 
-    if (reply->integer == 1) {
-      ldeleted_keys.push_back(key);
-    }
+    lttls[index] = reply->integer;
+    return common::Error();
+  });
+  if (err) {
+    return err;
+  }
+
+  *ttls = lttls;
+  return common::Error();
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::GetCollectionSize(const NKey& key,
+                                                                common::Value::Type type,
+                                                                size_t* size) {
+  if (!size) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  common::Error err = base_class::TestIsAuthenticated();
+  if (err) {
+    return err;
+  }
+
+  redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
+  commands_args_t size_cmd;
+  err = tran->CollectionSize(key, type, &size_cmd);
+  if (err) {
+    return err;
+  }
+
+  redisReply* reply = nullptr;
+  err = ExecCommand(size_cmd, &reply);
+  if (err) {
+    return err;
+  }
+
+  if (reply->type != REDIS_REPLY_INTEGER) {
+    DNOTREACHED() << "Unexpected type: " << reply->type;
     freeReplyObject(reply);
+    return common::make_error("I/O error");
   }
 
-  if (base_class::client_ && !ldeleted_keys.empty()) {
-    base_class::client_->OnRemovedKeys(ldeleted_keys);
+  *size = reply->integer;
+  freeReplyObject(reply);
+  return common::Error();
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::GetCollectionPage(const NKey& key,
+                                                                common::Value::Type type,
+                                                                const cursor_t& cursor_in,
+                                                                keys_limit_t page_size,
+                                                                NValue* page,
+                                                                cursor_t* cursor_out) {
+  if (!page || !cursor_out || page_size == 0) {
+    DNOTREACHED();
+    return common::make_error_inval();
   }
 
-  *deleted_keys = ldeleted_keys;
+  common::Error err = base_class::TestIsAuthenticated();
+  if (err) {
+    return err;
+  }
+
+  common::ArrayValue* elements = nullptr;
+  err = ReadCollectionPage(key, type, cursor_in, page_size, &elements, cursor_out);
+  if (err) {
+    return err;
+  }
+
+  common::Value* typed = MakeCollectionValue(elements, type);
+  if (!typed) {
+    return common::make_error_inval();
+  }
+
+  *page = NValue(typed);
+  return common::Error();
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::ReadCollectionPage(const NKey& key,
+                                                                 common::Value::Type type,
+                                                                 const cursor_t& cursor_in,
+                                                                 keys_limit_t page_size,
+                                                                 common::ArrayValue** items,
+                                                                 cursor_t* cursor_out) {
+  redis_translator_t tran = base_class::template GetSpecificTranslator<CommandTranslator>();
+  commands_args_t page_cmd;
+  common::Error err = tran->CollectionScan(key, type, cursor_in.GetPosition(), page_size, &page_cmd);
+  if (err) {
+    return err;
+  }
+
+  if (type == common::Value::TYPE_ARRAY) {
+    common::Value* val = nullptr;
+    err = ExecReadCommandToValue(page_cmd, &val);
+    if (err) {
+      return err;
+    }
+
+    common::ArrayValue* page = nullptr;
+    if (!val->GetAsList(&page)) {
+      DNOTREACHED() << "Unexpected type: " << val->GetType();
+      delete val;
+      return common::make_error("I/O error");
+    }
+
+    // LRANGE window, a short page is the last one
+    const size_t page_len = page->GetSize();
+    *cursor_out = page_len < page_size ? cursor_t() : cursor_t(cursor_in.GetPosition() + page_len);
+    *items = page;
+    return common::Error();
+  }
+
+  // SSCAN/HSCAN/ZSCAN reply: [cursor, [elements]], streamed so the element list is taken as decoded
+  common::Value* cursor_val = nullptr;
+  common::Value* items_val = nullptr;
+  auto on_part = [&cursor_val, &items_val](size_t index, common::Value* part) {
+    if (index == 0 && !cursor_val) {
+      cursor_val = part;
+    } else if (index == 1 && !items_val) {
+      items_val = part;
+    } else {
+      delete part;
+    }
+  };
+
+  common::Value* val = nullptr;
+  err = ExecReadCommandToValue(page_cmd, &val, on_part);
+  if (err) {
+    delete cursor_val;
+    delete items_val;
+    return err;
+  }
+
+  readable_string_t cursor_str;
+  cursor_t::position_t position;
+  common::ArrayValue* page = nullptr;
+  const bool is_valid = !val && cursor_val && items_val && cursor_val->GetAsString(&cursor_str) &&
+                        common::ConvertFromBytes(cursor_str, &position) && items_val->GetAsList(&page);
+  delete val;
+  delete cursor_val;
+  if (!is_valid) {
+    DNOTREACHED() << "Unexpected scan reply";
+    delete items_val;
+    return common::make_error("I/O error");
+  }
+
+  *cursor_out = cursor_t(position);
+  *items = page;
+  return common::Error();
+}
+
+template <typename Config, ConnectionType ContType>
+common::Error DBConnection<Config, ContType>::LoadCollectionFirstPage(const NKey& key,
+                                                                      common::Value::Type type,
+                                                                      size_t total,
+                                                                      NDbKValue* loaded_key) {
+  common::ArrayValue* elements = nullptr;
+  cursor_t next;
+  common::Error err = ReadCollectionPage(key, type, cursor_t(), collection_page_size, &elements, &next);
+  if (err) {
+    return err;
+  }
+
+  common::Value* collection = MakeCollectionValue(elements, type);
+  if (!collection) {
+    return common::make_error_inval();
+  }
+
+  *loaded_key = NDbKValue(key, NValue(collection));
+  if (next.IsFinished()) {  // shrank since it was counted
+    return common::Error();
+  }
+
+  if (partial_loads_.size() >= max_partial_loads) {
+    partial_loads_.clear();
+  }
+  PartialLoad partial;
+  partial.cursor = next;
+  partial.total = total;
+  partial_loads_[key.GetKey().GetData().as_string()] = partial;
   return common::Error();
 }
 
+template <typename Config, ConnectionType ContType>
+bool DBConnection<Config, ContType>::GetPartialLoad(const NKey& key, cursor_t* cursor_out, size_t* total) const {
+  if (!cursor_out || !total) {
+    DNOTREACHED();
+    return false;
+  }
+
+  const auto it = partial_loads_.find(key.GetKey().GetData().as_string());
+  if (it == partial_loads_.end()) {
+    return false;
+  }
+
+  *cursor_out = it->second.cursor;
+  *total = it->second.total;
+  return true;
+}
+
 template <typename Config, ConnectionType ContType>
 IDataBaseInfo* DBConnection<Config, ContType>::MakeDatabaseInfo(const db_name_t& name,
                                                                 bool is_default,
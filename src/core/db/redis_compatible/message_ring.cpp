@@ -0,0 +1,95 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <fastonosql/core/db/redis_compatible/message_ring.h>
+
+namespace fastonosql {
+namespace core {
+namespace redis_compatible {
+
+MessageRing::MessageRing(size_t capacity)
+    : slots_(capacity ? capacity : 1, nullptr), head_(0), tail_(0), received_(0), dropped_(0) {}
+
+MessageRing::~MessageRing() {
+  std::vector<common::Value*> left;
+  PopBatch(slots_.size(), &left);
+  for (common::Value* message : left) {
+    delete message;
+  }
+}
+
+bool MessageRing::Push(common::Value* message) {
+  if (!message) {
+    DNOTREACHED();
+    return false;
+  }
+
+  const uint64_t received = received_++;
+  const size_t tail = tail_.load(std::memory_order_relaxed);
+  const size_t size = tail - head_.load(std::memory_order_acquire);
+  const bool is_full = size >= slots_.size();
+  const bool is_sampled = size >= slots_.size() / 2 && received % sample_rate != 0;
+  if (is_full || is_sampled) {
+    dropped_++;
+    delete message;
+    return false;
+  }
+
+  slots_[tail % slots_.size()] = message;
+  tail_.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+size_t MessageRing::PopBatch(size_t max_count, std::vector<common::Value*>* batch) {
+  if (!batch) {
+    DNOTREACHED();
+    return 0;
+  }
+
+  size_t head = head_.load(std::memory_order_relaxed);
+  const size_t tail = tail_.load(std::memory_order_acquire);
+  size_t count = 0;
+  for (; head != tail && count < max_count; ++head, ++count) {
+    common::Value** slot = &slots_[head % slots_.size()];
+    batch->push_back(*slot);
+    *slot = nullptr;
+  }
+
+  head_.store(head, std::memory_order_release);
+  return count;
+}
+
+size_t MessageRing::GetSize() const {
+  return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+}
+
+size_t MessageRing::GetCapacity() const {
+  return slots_.size();
+}
+
+uint64_t MessageRing::GetReceivedCount() const {
+  return received_;
+}
+
+uint64_t MessageRing::GetDroppedCount() const {
+  return dropped_;
+}
+
+}  // namespace redis_compatible
+}  // namespace core
+}  // namespace fastonosql
@@ -0,0 +1,276 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <fastonosql/core/db/redis_compatible/near_cache.h>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#define poll WSAPoll
+#else
+#include <poll.h>
+#endif
+
+extern "C" {
+#include <hiredis/hiredis.h>
+}
+
+#include <common/convert2string.h>
+
+#include <fastonosql/core/db/redis_compatible/db_connection.h>
+
+namespace fastonosql {
+namespace core {
+namespace redis_compatible {
+
+namespace {
+const char kInvalidateChannel[] = "__redis__:invalidate";
+
+std::string MakeCacheKey(const NKey& key) {
+  const readable_string_t data = key.GetKey().GetData();
+  return std::string(data.begin(), data.end());
+}
+}  // namespace
+
+NearCache::Entry::Entry() : key(), type(), has_value(false), value(), has_ttl(false), ttl(NO_TTL), ttl_loaded() {}
+
+NearCache::NearCache(const Config& config, const SSHInfo& sinfo, size_t max_keys)
+    : config_(config), sinfo_(sinfo), max_keys_(max_keys), invalidations_(nullptr), entries_(), index_() {}
+
+NearCache::~NearCache() {
+  Stop();
+}
+
+common::Error NearCache::Start(redisContext* data) {
+  if (!data || max_keys_ == 0) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  Stop();
+  common::Error err = CreateConnection(config_, sinfo_, &invalidations_);
+  if (err) {
+    return err;
+  }
+
+  err = AuthContext(invalidations_, common::ConvertToCharBytes(config_.auth));
+  if (err) {
+    Stop();
+    return err;
+  }
+
+  redisReply* reply = nullptr;
+  err = ExecRedisCommand(invalidations_, commands_args_t{GEN_CMD_STRING("CLIENT"), GEN_CMD_STRING("ID")}, &reply);
+  if (err) {
+    Stop();
+    return err;
+  }
+
+  if (reply->type != REDIS_REPLY_INTEGER) {
+    freeReplyObject(reply);
+    Stop();
+    return common::make_error("CLIENT ID is not supported");
+  }
+
+  const long long client_id = reply->integer;
+  freeReplyObject(reply);
+  const commands_args_t subscribe_cmd = {GEN_CMD_STRING("SUBSCRIBE"), GEN_CMD_STRING(kInvalidateChannel)};
+  err = ExecRedisCommand(invalidations_, subscribe_cmd, &reply);
+  if (err) {
+    Stop();
+    return err;
+  }
+  freeReplyObject(reply);
+
+  // servers before 6.0 reply with an error here
+  const commands_args_t tracking_cmd = {GEN_CMD_STRING("CLIENT"), GEN_CMD_STRING("TRACKING"), GEN_CMD_STRING("ON"),
+                                        GEN_CMD_STRING("REDIRECT"), common::ConvertToCharBytes(client_id)};
+  err = ExecRedisCommand(data, tracking_cmd, &reply);
+  if (err) {
+    Stop();
+    return err;
+  }
+
+  freeReplyObject(reply);
+  return common::Error();
+}
+
+common::Error NearCache::Poll() {
+  if (!invalidations_) {
+    return common::make_error("Near cache is not started");
+  }
+
+  while (true) {
+    void* reply = nullptr;
+    if (redisGetReplyFromReader(invalidations_, &reply) == REDIS_ERR) {
+      break;
+    }
+
+    if (reply) {
+      // ["message", channel, [key...]], nil instead of keys after FLUSHALL or a lost tracking table
+      redisReply* rreply = static_cast<redisReply*>(reply);
+      if (rreply->type == REDIS_REPLY_ARRAY && rreply->elements == 3) {
+        redisReply* keys = rreply->element[2];
+        if (keys->type == REDIS_REPLY_ARRAY) {
+          for (size_t i = 0; i < keys->elements; ++i) {
+            Invalidate(GEN_CMD_STRING_SIZE(keys->element[i]->str, keys->element[i]->len));
+          }
+        } else {
+          Clear();
+        }
+      }
+      freeReplyObject(rreply);
+      continue;
+    }
+
+    // nothing parsed yet, read only what already arrived
+    struct pollfd fd;
+    fd.fd = invalidations_->fd;
+    fd.events = POLLIN;
+    fd.revents = 0;
+    if (poll(&fd, 1, 0) <= 0) {
+      return common::Error();
+    }
+
+    if (redisBufferRead(invalidations_) == REDIS_ERR) {
+      break;
+    }
+  }
+
+  // without invalidations nothing cached can be trusted
+  common::Error err = PrintRedisContextError(invalidations_);
+  Clear();
+  Stop();
+  return err;
+}
+
+bool NearCache::GetValue(const NKey& key, NDbKValue* value) {
+  Entry* entry = Find(key);
+  if (!entry || !entry->has_value) {
+    return false;
+  }
+
+  *value = entry->value;
+  return true;
+}
+
+bool NearCache::GetType(const NKey& key, readable_string_t* type) {
+  Entry* entry = Find(key);
+  if (!entry || entry->type.empty()) {
+    return false;
+  }
+
+  *type = entry->type;
+  return true;
+}
+
+bool NearCache::GetTTL(const NKey& key, ttl_t* ttl) {
+  Entry* entry = Find(key);
+  if (!entry || !entry->has_ttl) {
+    return false;
+  }
+
+  if (entry->ttl < 0) {  // NO_TTL, EXPIRED_TTL do not change by themselves
+    *ttl = entry->ttl;
+    return true;
+  }
+
+  const auto elapsed = std::chrono::steady_clock::now() - entry->ttl_loaded;
+  const ttl_t left = entry->ttl - std::chrono::duration_cast<std::chrono::seconds>(elapsed).count();
+  if (left <= 0) {  // about to expire, let the server answer
+    return false;
+  }
+
+  *ttl = left;
+  return true;
+}
+
+void NearCache::SetValue(const NDbKValue& value, const readable_string_t& type) {
+  Entry* entry = FindOrAdd(value.GetKey());
+  entry->value = value;
+  entry->has_value = true;
+  entry->type = type;
+}
+
+void NearCache::SetType(const NKey& key, const readable_string_t& type) {
+  FindOrAdd(key)->type = type;
+}
+
+void NearCache::SetTTL(const NKey& key, ttl_t ttl) {
+  Entry* entry = FindOrAdd(key);
+  entry->ttl = ttl;
+  entry->has_ttl = true;
+  entry->ttl_loaded = std::chrono::steady_clock::now();
+}
+
+void NearCache::Invalidate(const command_buffer_t& key) {
+  const auto it = index_.find(std::string(key.begin(), key.end()));
+  if (it == index_.end()) {
+    return;
+  }
+
+  entries_.erase(it->second);
+  index_.erase(it);
+}
+
+void NearCache::Clear() {
+  entries_.clear();
+  index_.clear();
+}
+
+size_t NearCache::GetSize() const {
+  return entries_.size();
+}
+
+NearCache::Entry* NearCache::Find(const NKey& key) {
+  const auto it = index_.find(MakeCacheKey(key));
+  if (it == index_.end()) {
+    return nullptr;
+  }
+
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return &entries_.front();
+}
+
+NearCache::Entry* NearCache::FindOrAdd(const NKey& key) {
+  Entry* entry = Find(key);
+  if (entry) {
+    return entry;
+  }
+
+  if (entries_.size() >= max_keys_) {  // evict the least recently used
+    index_.erase(entries_.back().key);
+    entries_.pop_back();
+  }
+
+  Entry lentry;
+  lentry.key = MakeCacheKey(key);
+  entries_.push_front(lentry);
+  index_[lentry.key] = entries_.begin();
+  return &entries_.front();
+}
+
+void NearCache::Stop() {
+  if (invalidations_) {
+    redisFree(invalidations_);
+    invalidations_ = nullptr;
+  }
+}
+
+}  // namespace redis_compatible
+}  // namespace core
+}  // namespace fastonosql
@@ -0,0 +1,1105 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <fastonosql/core/db/redis_compatible/rdb_parser.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+#include <common/convert2string.h>
+#include <common/sprintf.h>
+
+namespace fastonosql {
+namespace core {
+namespace redis_compatible {
+
+namespace {
+
+typedef common::Value::string_t string_t;
+typedef std::vector<string_t> entries_t;
+
+enum RdbType : uint8_t {
+  RDB_TYPE_STRING = 0,
+  RDB_TYPE_LIST = 1,
+  RDB_TYPE_SET = 2,
+  RDB_TYPE_ZSET = 3,
+  RDB_TYPE_HASH = 4,
+  RDB_TYPE_ZSET_2 = 5,
+  RDB_TYPE_MODULE = 6,
+  RDB_TYPE_MODULE_2 = 7,
+  RDB_TYPE_HASH_ZIPMAP = 9,
+  RDB_TYPE_LIST_ZIPLIST = 10,
+  RDB_TYPE_SET_INTSET = 11,
+  RDB_TYPE_ZSET_ZIPLIST = 12,
+  RDB_TYPE_HASH_ZIPLIST = 13,
+  RDB_TYPE_LIST_QUICKLIST = 14,
+  RDB_TYPE_STREAM_LISTPACKS = 15,
+  RDB_TYPE_HASH_LISTPACK = 16,
+  RDB_TYPE_ZSET_LISTPACK = 17,
+  RDB_TYPE_LIST_QUICKLIST_2 = 18,
+  RDB_TYPE_STREAM_LISTPACKS_2 = 19,
+  RDB_TYPE_SET_LISTPACK = 20,
+  RDB_TYPE_STREAM_LISTPACKS_3 = 21,
+  RDB_TYPE_HASH_METADATA_PRE_GA = 22,  // hashes with field expiry (7.4)
+  RDB_TYPE_HASH_LISTPACK_EX_PRE_GA = 23,
+  RDB_TYPE_HASH_METADATA = 24,
+  RDB_TYPE_HASH_LISTPACK_EX = 25
+};
+
+enum RdbOpcode : uint8_t {
+  RDB_OPCODE_SLOT_INFO = 244,
+  RDB_OPCODE_FUNCTION2 = 245,
+  RDB_OPCODE_FUNCTION_PRE_GA = 246,
+  RDB_OPCODE_MODULE_AUX = 247,
+  RDB_OPCODE_IDLE = 248,
+  RDB_OPCODE_FREQ = 249,
+  RDB_OPCODE_AUX = 250,
+  RDB_OPCODE_RESIZEDB = 251,
+  RDB_OPCODE_EXPIRETIME_MS = 252,
+  RDB_OPCODE_EXPIRETIME = 253,
+  RDB_OPCODE_SELECTDB = 254,
+  RDB_OPCODE_EOF = 255
+};
+
+enum RdbModuleOpcode : uint8_t {
+  RDB_MODULE_OPCODE_EOF = 0,
+  RDB_MODULE_OPCODE_SINT = 1,
+  RDB_MODULE_OPCODE_UINT = 2,
+  RDB_MODULE_OPCODE_FLOAT = 3,
+  RDB_MODULE_OPCODE_DOUBLE = 4,
+  RDB_MODULE_OPCODE_STRING = 5
+};
+
+enum RdbEncoding : uint8_t { RDB_ENC_INT8 = 0, RDB_ENC_INT16 = 1, RDB_ENC_INT32 = 2, RDB_ENC_LZF = 3 };
+
+enum QuicklistContainer : uint8_t { QUICKLIST_NODE_CONTAINER_PLAIN = 1, QUICKLIST_NODE_CONTAINER_PACKED = 2 };
+
+const int kMinRdbVersion = 1;
+const int kMaxRdbVersion = 12;
+
+common::Error MakeFormatError(const char* what) {
+  return common::make_error(common::MemSPrintf("Bad RDB format: %s", what));
+}
+
+uint64_t LoadLittleEndian(const uint8_t* data, size_t size) {
+  uint64_t result = 0;
+  for (size_t i = 0; i < size; ++i) {
+    result |= static_cast<uint64_t>(data[i]) << (8 * i);
+  }
+  return result;
+}
+
+uint64_t LoadBigEndian(const uint8_t* data, size_t size) {
+  uint64_t result = 0;
+  for (size_t i = 0; i < size; ++i) {
+    result = (result << 8) | data[i];
+  }
+  return result;
+}
+
+int64_t SignExtend(uint64_t value, size_t bits) {
+  const uint64_t sign = static_cast<uint64_t>(1) << (bits - 1);
+  if (bits < 64 && (value & sign)) {
+    return static_cast<int64_t>(value | ~((sign << 1) - 1));
+  }
+  return static_cast<int64_t>(value);
+}
+
+string_t IntegerToString(int64_t value) {
+  return common::ConvertToCharBytes(value);
+}
+
+bool LzfDecompress(const uint8_t* in, size_t in_len, uint8_t* out, size_t out_len) {
+  const uint8_t* ip = in;
+  const uint8_t* const in_end = in + in_len;
+  uint8_t* op = out;
+  uint8_t* const out_end = out + out_len;
+  while (ip < in_end) {
+    size_t ctrl = *ip++;
+    if (ctrl < (1 << 5)) {  // literal run
+      ctrl++;
+      if (op + ctrl > out_end || ip + ctrl > in_end) {
+        return false;
+      }
+      memcpy(op, ip, ctrl);
+      op += ctrl;
+      ip += ctrl;
+      continue;
+    }
+
+    // back reference
+    size_t len = ctrl >> 5;
+    if (ip >= in_end) {
+      return false;
+    }
+    if (len == 7) {
+      len += *ip++;
+      if (ip >= in_end) {
+        return false;
+      }
+    }
+    const size_t offset = ((ctrl & 0x1f) << 8) + *ip++ + 1;
+    len += 2;
+    if (offset > static_cast<size_t>(op - out) || op + len > out_end) {
+      return false;
+    }
+    const uint8_t* ref = op - offset;
+    for (size_t i = 0; i < len; ++i) {  // regions may overlap
+      *op++ = *ref++;
+    }
+  }
+  return op == out_end;
+}
+
+// [zlbytes:4][zltail:4][zllen:2] entries 0xFF
+bool DecodeZiplist(const string_t& blob, entries_t* entries) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(blob.data());
+  const uint8_t* const end = p + blob.size();
+  if (blob.size() < 11) {
+    return false;
+  }
+
+  p += 10;
+  while (p < end && *p != 0xFF) {
+    p += *p < 254 ? 1 : 5;  // prevlen
+    if (p >= end) {
+      return false;
+    }
+
+    const uint8_t enc = *p++;
+    size_t str_len = 0;
+    size_t int_size = 0;
+    bool is_int = false;
+    int64_t integer = 0;
+    switch (enc >> 6) {
+      case 0:
+        str_len = enc & 0x3F;
+        break;
+      case 1:
+        if (p + 1 > end) {
+          return false;
+        }
+        str_len = ((enc & 0x3F) << 8) | *p++;
+        break;
+      case 2:
+        if (p + 4 > end) {
+          return false;
+        }
+        str_len = LoadBigEndian(p, 4);
+        p += 4;
+        break;
+      default:
+        is_int = true;
+        if (enc == 0xC0) {
+          int_size = 2;
+        } else if (enc == 0xD0) {
+          int_size = 4;
+        } else if (enc == 0xE0) {
+          int_size = 8;
+        } else if (enc == 0xF0) {
+          int_size = 3;
+        } else if (enc == 0xFE) {
+          int_size = 1;
+        } else if (enc >= 0xF1 && enc <= 0xFD) {
+          integer = (enc & 0x0F) - 1;
+        } else {
+          return false;
+        }
+        break;
+    }
+
+    if (is_int) {
+      if (p + int_size > end) {
+        return false;
+      }
+      if (int_size) {
+        integer = SignExtend(LoadLittleEndian(p, int_size), int_size * 8);
+        p += int_size;
+      }
+      entries->push_back(IntegerToString(integer));
+      continue;
+    }
+
+    if (p + str_len > end) {
+      return false;
+    }
+    entries->push_back(GEN_CMD_STRING_SIZE(reinterpret_cast<const char*>(p), str_len));
+    p += str_len;
+  }
+  return p < end;
+}
+
+// [total:4][count:2] entries 0xFF, each entry is followed by its reversed length
+bool DecodeListpack(const string_t& blob, entries_t* entries) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(blob.data());
+  const uint8_t* const end = p + blob.size();
+  if (blob.size() < 7) {
+    return false;
+  }
+
+  p += 6;
+  while (p < end && *p != 0xFF) {
+    const uint8_t* const entry = p;
+    const uint8_t enc = *p++;
+    size_t str_len = 0;
+    size_t int_size = 0;
+    bool is_int = true;
+    int64_t integer = 0;
+    if ((enc & 0x80) == 0) {  // 7 bit uint
+      integer = enc & 0x7F;
+    } else if ((enc & 0xC0) == 0x80) {  // 6 bit str len
+      is_int = false;
+      str_len = enc & 0x3F;
+    } else if ((enc & 0xE0) == 0xC0) {  // 13 bit int
+      if (p + 1 > end) {
+        return false;
+      }
+      integer = SignExtend(((enc & 0x1F) << 8) | *p++, 13);
+    } else if ((enc & 0xF0) == 0xE0) {  // 12 bit str len
+      if (p + 1 > end) {
+        return false;
+      }
+      is_int = false;
+      str_len = ((enc & 0x0F) << 8) | *p++;
+    } else if (enc == 0xF0) {  // 32 bit str len
+      if (p + 4 > end) {
+        return false;
+      }
+      is_int = false;
+      str_len = LoadLittleEndian(p, 4);
+      p += 4;
+    } else if (enc == 0xF1) {
+      int_size = 2;
+    } else if (enc == 0xF2) {
+      int_size = 3;
+    } else if (enc == 0xF3) {
+      int_size = 4;
+    } else if (enc == 0xF4) {
+      int_size = 8;
+    } else {
+      return false;
+    }
+
+    if (is_int) {
+      if (p + int_size > end) {
+        return false;
+      }
+      if (int_size) {
+        integer = SignExtend(LoadLittleEndian(p, int_size), int_size * 8);
+        p += int_size;
+      }
+      entries->push_back(IntegerToString(integer));
+    } else {
+      if (p + str_len > end) {
+        return false;
+      }
+      entries->push_back(GEN_CMD_STRING_SIZE(reinterpret_cast<const char*>(p), str_len));
+      p += str_len;
+    }
+
+    // same thresholds as lpEncodeBacklen, only the first one is inclusive
+    const size_t entry_len = p - entry;
+    if (entry_len <= 127) {
+      p += 1;
+    } else if (entry_len < 16383) {
+      p += 2;
+    } else if (entry_len < 2097151) {
+      p += 3;
+    } else if (entry_len < 268435455) {
+      p += 4;
+    } else {
+      p += 5;
+    }
+  }
+  return p < end;
+}
+
+// [encoding:4][length:4] sorted integers of encoding bytes each
+bool DecodeIntset(const string_t& blob, entries_t* entries) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(blob.data());
+  if (blob.size() < 8) {
+    return false;
+  }
+
+  const size_t int_size = LoadLittleEndian(p, 4);
+  const size_t count = LoadLittleEndian(p + 4, 4);
+  if ((int_size != 2 && int_size != 4 && int_size != 8) || blob.size() < 8 + int_size * count) {
+    return false;
+  }
+
+  p += 8;
+  for (size_t i = 0; i < count; ++i, p += int_size) {
+    entries->push_back(IntegerToString(SignExtend(LoadLittleEndian(p, int_size), int_size * 8)));
+  }
+  return true;
+}
+
+// [zmlen:1] (len key len free value padding)* 0xFF
+bool DecodeZipmap(const string_t& blob, entries_t* entries) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(blob.data());
+  const uint8_t* const end = p + blob.size();
+  if (blob.empty()) {
+    return false;
+  }
+
+  p++;
+  while (p < end && *p != 0xFF) {
+    for (int i = 0; i < 2; ++i) {  // key, value
+      if (p >= end) {
+        return false;
+      }
+      size_t len = *p++;
+      if (len == 254) {
+        if (p + 4 > end) {
+          return false;
+        }
+        len = LoadLittleEndian(p, 4);
+        p += 4;
+      } else if (len == 255) {
+        return false;
+      }
+
+      size_t free_len = 0;
+      if (i == 1) {
+        if (p >= end) {
+          return false;
+        }
+        free_len = *p++;
+      }
+
+      if (p + len + free_len > end) {
+        return false;
+      }
+      entries->push_back(GEN_CMD_STRING_SIZE(reinterpret_cast<const char*>(p), len));
+      p += len + free_len;
+    }
+  }
+  return p < end;
+}
+
+common::ArrayValue* MakeList(const entries_t& entries) {
+  common::ArrayValue* list = common::Value::CreateArrayValue();
+  for (const string_t& entry : entries) {
+    list->Append(common::Value::CreateStringValue(entry));
+  }
+  return list;
+}
+
+common::SetValue* MakeSet(const entries_t& entries) {
+  common::SetValue* set = common::Value::CreateSetValue();
+  for (const string_t& entry : entries) {
+    set->Insert(common::Value::CreateStringValue(entry));
+  }
+  return set;
+}
+
+// [field, value, ...]
+common::HashValue* MakeHash(const entries_t& entries) {
+  common::HashValue* hash = common::Value::CreateHashValue();
+  for (size_t i = 0; i + 1 < entries.size(); i += 2) {
+    hash->Insert(entries[i], common::Value::CreateStringValue(entries[i + 1]));
+  }
+  return hash;
+}
+
+// [member, score, ...]
+common::ZSetValue* MakeZSet(const entries_t& entries) {
+  common::ZSetValue* zset = common::Value::CreateZSetValue();
+  for (size_t i = 0; i + 1 < entries.size(); i += 2) {
+    zset->Insert(common::Value::CreateStringValue(entries[i + 1]), common::Value::CreateStringValue(entries[i]));
+  }
+  return zset;
+}
+
+int64_t GetCurrentMsec() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+RdbParser::RdbParser(read_callback_t reader, key_callback_t on_key)
+    : reader_(reader),
+      on_key_(on_key),
+      buf_(buffer_size),
+      pos_(0),
+      end_(0),
+      version_(0),
+      keys_count_(0),
+      skipped_keys_count_(0),
+      is_unsupported_(false) {}
+
+common::Error RdbParser::Parse() {
+  char magic[9];
+  common::Error err = Read(magic, sizeof(magic));
+  if (err) {
+    return err;
+  }
+
+  if (memcmp(magic, "REDIS", 5) != 0) {
+    return MakeFormatError("wrong signature");
+  }
+
+  const std::string version(magic + 5, 4);
+  version_ = atoi(version.c_str());
+  if (version_ < kMinRdbVersion || version_ > kMaxRdbVersion) {
+    return common::make_error(common::MemSPrintf("Unsupported RDB version: %d", version_));
+  }
+
+  int db_num = 0;
+  int64_t expire_msec = -1;
+  while (true) {
+    uint8_t type = 0;
+    err = ReadByte(&type);
+    if (err) {
+      return err;
+    }
+
+    uint64_t len = 0;
+    switch (type) {
+      case RDB_OPCODE_EOF: {
+        if (version_ >= 5) {  // crc64 of the payload, not verified
+          char checksum[8];
+          return Read(checksum, sizeof(checksum));
+        }
+        return common::Error();
+      }
+      case RDB_OPCODE_SELECTDB: {
+        err = ReadLength(&len);
+        if (err) {
+          return err;
+        }
+        db_num = static_cast<int>(len);
+        continue;
+      }
+      case RDB_OPCODE_EXPIRETIME_MS:
+      case RDB_OPCODE_EXPIRETIME: {
+        const size_t size = type == RDB_OPCODE_EXPIRETIME_MS ? 8 : 4;
+        uint8_t data[8];
+        err = Read(data, size);
+        if (err) {
+          return err;
+        }
+        expire_msec = LoadLittleEndian(data, size);
+        if (type == RDB_OPCODE_EXPIRETIME) {
+          expire_msec *= 1000;
+        }
+        continue;
+      }
+      case RDB_OPCODE_RESIZEDB:
+      case RDB_OPCODE_SLOT_INFO: {
+        const int count = type == RDB_OPCODE_RESIZEDB ? 2 : 3;
+        for (int i = 0; i < count && !err; ++i) {
+          err = ReadLength(&len);
+        }
+        if (err) {
+          return err;
+        }
+        continue;
+      }
+      case RDB_OPCODE_AUX: {
+        string_t aux;
+        err = ReadString(&aux);
+        if (!err) {
+          err = ReadString(&aux);
+        }
+        if (err) {
+          return err;
+        }
+        continue;
+      }
+      case RDB_OPCODE_FUNCTION2: {
+        string_t code;
+        err = ReadString(&code);
+        if (err) {
+          return err;
+        }
+        continue;
+      }
+      case RDB_OPCODE_IDLE: {
+        err = ReadLength(&len);
+        if (err) {
+          return err;
+        }
+        continue;
+      }
+      case RDB_OPCODE_FREQ: {
+        uint8_t freq = 0;
+        err = ReadByte(&freq);
+        if (err) {
+          return err;
+        }
+        continue;
+      }
+      case RDB_OPCODE_MODULE_AUX: {
+        err = ReadLength(&len);  // module id
+        if (!err) {
+          err = SkipModuleValue();
+        }
+        if (err) {
+          return err;
+        }
+        continue;
+      }
+      case RDB_OPCODE_FUNCTION_PRE_GA:
+        is_unsupported_ = true;
+        return common::make_error("Unsupported RDB opcode: pre GA functions");
+      default:
+        break;
+    }
+
+    // type, key, value
+    string_t key;
+    err = ReadString(&key);
+    if (err) {
+      return err;
+    }
+
+    common::Value* value = nullptr;
+    err = ReadValue(type, &value);
+    if (err) {
+      return err;
+    }
+
+    ttl_t ttl = NO_TTL;
+    if (expire_msec != -1) {
+      const int64_t left_msec = expire_msec - GetCurrentMsec();
+      ttl = left_msec > 0 ? (left_msec + 999) / 1000 : EXPIRED_TTL;
+      expire_msec = -1;
+    }
+
+    if (!value || ttl == EXPIRED_TTL) {
+      delete value;
+      skipped_keys_count_++;
+      continue;
+    }
+
+    keys_count_++;
+    on_key_(db_num, NKey(nkey_t(key), ttl), value);
+  }
+}
+
+std::vector<char> RdbParser::GetUnconsumed() const {
+  return std::vector<char>(buf_.begin() + pos_, buf_.begin() + end_);
+}
+
+int RdbParser::GetVersion() const {
+  return version_;
+}
+
+uint64_t RdbParser::GetKeysCount() const {
+  return keys_count_;
+}
+
+uint64_t RdbParser::GetSkippedKeysCount() const {
+  return skipped_keys_count_;
+}
+
+bool RdbParser::IsStoppedOnUnsupported() const {
+  return is_unsupported_;
+}
+
+common::Error RdbParser::Read(void* out, size_t size) {
+  char* dest = static_cast<char*>(out);
+  while (size) {
+    if (pos_ == end_) {
+      size_t nread = 0;
+      common::Error err = reader_(buf_.data(), buf_.size(), &nread);
+      if (err) {
+        return err;
+      }
+      pos_ = 0;
+      end_ = nread;
+      continue;
+    }
+
+    const size_t chunk = std::min(size, end_ - pos_);
+    memcpy(dest, buf_.data() + pos_, chunk);
+    pos_ += chunk;
+    dest += chunk;
+    size -= chunk;
+  }
+  return common::Error();
+}
+
+common::Error RdbParser::ReadByte(uint8_t* out) {
+  return Read(out, 1);
+}
+
+common::Error RdbParser::ReadLength(uint64_t* len, bool* is_encoded) {
+  uint8_t first = 0;
+  common::Error err = ReadByte(&first);
+  if (err) {
+    return err;
+  }
+
+  if (is_encoded) {
+    *is_encoded = false;
+  }
+
+  uint8_t data[8];
+  switch (first >> 6) {
+    case 0:
+      *len = first & 0x3F;
+      return common::Error();
+    case 1:
+      err = ReadByte(data);
+      if (err) {
+        return err;
+      }
+      *len = ((first & 0x3F) << 8) | data[0];
+      return common::Error();
+    case 2: {
+      const size_t size = first == 0x80 ? 4 : first == 0x81 ? 8 : 0;
+      if (!size) {
+        return MakeFormatError("unknown length encoding");
+      }
+      err = Read(data, size);
+      if (err) {
+        return err;
+      }
+      *len = LoadBigEndian(data, size);
+      return common::Error();
+    }
+    default:
+      if (!is_encoded) {
+        return MakeFormatError("unexpected encoded length");
+      }
+      *is_encoded = true;
+      *len = first & 0x3F;
+      return common::Error();
+  }
+}
+
+common::Error RdbParser::ReadString(string_t* out) {
+  uint64_t len = 0;
+  bool is_encoded = false;
+  common::Error err = ReadLength(&len, &is_encoded);
+  if (err) {
+    return err;
+  }
+
+  if (!is_encoded) {
+    out->resize(len);
+    return Read(out->data(), len);
+  }
+
+  if (len == RDB_ENC_LZF) {
+    uint64_t compressed_len = 0;
+    uint64_t raw_len = 0;
+    err = ReadLength(&compressed_len);
+    if (!err) {
+      err = ReadLength(&raw_len);
+    }
+    if (err) {
+      return err;
+    }
+
+    std::vector<uint8_t> compressed(compressed_len);
+    err = Read(compressed.data(), compressed.size());
+    if (err) {
+      return err;
+    }
+
+    out->resize(raw_len);
+    if (!LzfDecompress(compressed.data(), compressed.size(), reinterpret_cast<uint8_t*>(out->data()), raw_len)) {
+      return MakeFormatError("corrupted LZF string");
+    }
+    return common::Error();
+  }
+
+  if (len > RDB_ENC_INT32) {
+    return MakeFormatError("unknown string encoding");
+  }
+
+  const size_t size = static_cast<size_t>(1) << len;  // 1, 2, 4 bytes
+  uint8_t data[4];
+  err = Read(data, size);
+  if (err) {
+    return err;
+  }
+  *out = IntegerToString(SignExtend(LoadLittleEndian(data, size), size * 8));
+  return common::Error();
+}
+
+common::Error RdbParser::ReadScore(bool is_binary, string_t* out) {
+  if (is_binary) {
+    uint8_t data[8];
+    common::Error err = Read(data, sizeof(data));
+    if (err) {
+      return err;
+    }
+    const uint64_t bits = LoadLittleEndian(data, sizeof(data));
+    double score = 0;
+    memcpy(&score, &bits, sizeof(score));
+    *out = common::ConvertToCharBytes(common::MemSPrintf("%.17g", score));
+    return common::Error();
+  }
+
+  uint8_t len = 0;
+  common::Error err = ReadByte(&len);
+  if (err) {
+    return err;
+  }
+
+  if (len == 253) {
+    *out = GEN_CMD_STRING("nan");
+  } else if (len == 254) {
+    *out = GEN_CMD_STRING("inf");
+  } else if (len == 255) {
+    *out = GEN_CMD_STRING("-inf");
+  } else {
+    out->resize(len);
+    return Read(out->data(), len);
+  }
+  return common::Error();
+}
+
+common::Error RdbParser::ReadValue(uint8_t type, common::Value** out) {
+  entries_t entries;
+  uint64_t count = 0;
+  common::Error err;
+  switch (type) {
+    case RDB_TYPE_STRING: {
+      string_t str;
+      err = ReadString(&str);
+      if (err) {
+        return err;
+      }
+      *out = common::Value::CreateStringValue(str);
+      return common::Error();
+    }
+    case RDB_TYPE_LIST:
+    case RDB_TYPE_SET:
+    case RDB_TYPE_HASH:
+    case RDB_TYPE_ZSET:
+    case RDB_TYPE_ZSET_2: {
+      err = ReadLength(&count);
+      if (err) {
+        return err;
+      }
+
+      const bool is_pairs = type != RDB_TYPE_LIST && type != RDB_TYPE_SET;
+      for (uint64_t i = 0; i < count; ++i) {
+        string_t first;
+        err = ReadString(&first);
+        if (err) {
+          return err;
+        }
+        entries.push_back(first);
+        if (!is_pairs) {
+          continue;
+        }
+
+        string_t second;
+        err = type == RDB_TYPE_HASH ? ReadString(&second) : ReadScore(type == RDB_TYPE_ZSET_2, &second);
+        if (err) {
+          return err;
+        }
+        entries.push_back(second);
+      }
+      break;
+    }
+    case RDB_TYPE_LIST_QUICKLIST:
+    case RDB_TYPE_LIST_QUICKLIST_2: {
+      err = ReadLength(&count);
+      if (err) {
+        return err;
+      }
+
+      for (uint64_t i = 0; i < count; ++i) {
+        uint64_t container = QUICKLIST_NODE_CONTAINER_PACKED;
+        if (type == RDB_TYPE_LIST_QUICKLIST_2) {
+          err = ReadLength(&container);
+          if (err) {
+            return err;
+          }
+        }
+
+        string_t node;
+        err = ReadString(&node);
+        if (err) {
+          return err;
+        }
+
+        if (container == QUICKLIST_NODE_CONTAINER_PLAIN) {
+          entries.push_back(node);
+          continue;
+        }
+
+        const bool is_valid =
+            type == RDB_TYPE_LIST_QUICKLIST ? DecodeZiplist(node, &entries) : DecodeListpack(node, &entries);
+        if (!is_valid) {
+          return MakeFormatError("corrupted quicklist node");
+        }
+      }
+      break;
+    }
+    case RDB_TYPE_HASH_ZIPMAP:
+    case RDB_TYPE_LIST_ZIPLIST:
+    case RDB_TYPE_SET_INTSET:
+    case RDB_TYPE_ZSET_ZIPLIST:
+    case RDB_TYPE_HASH_ZIPLIST:
+    case RDB_TYPE_HASH_LISTPACK:
+    case RDB_TYPE_ZSET_LISTPACK:
+    case RDB_TYPE_SET_LISTPACK: {
+      string_t blob;
+      err = ReadString(&blob);
+      if (err) {
+        return err;
+      }
+
+      bool is_valid = false;
+      if (type == RDB_TYPE_HASH_ZIPMAP) {
+        is_valid = DecodeZipmap(blob, &entries);
+      } else if (type == RDB_TYPE_SET_INTSET) {
+        is_valid = DecodeIntset(blob, &entries);
+      } else if (type == RDB_TYPE_HASH_LISTPACK || type == RDB_TYPE_ZSET_LISTPACK || type == RDB_TYPE_SET_LISTPACK) {
+        is_valid = DecodeListpack(blob, &entries);
+      } else {
+        is_valid = DecodeZiplist(blob, &entries);
+      }
+      if (!is_valid) {
+        return MakeFormatError("corrupted compact encoding");
+      }
+      break;
+    }
+    case RDB_TYPE_MODULE_2: {
+      err = ReadLength(&count);  // module id
+      if (!err) {
+        err = SkipModuleValue();
+      }
+      if (err) {
+        return err;
+      }
+      *out = nullptr;  // opaque, skipped
+      return common::Error();
+    }
+    case RDB_TYPE_STREAM_LISTPACKS:
+    case RDB_TYPE_STREAM_LISTPACKS_2:
+    case RDB_TYPE_STREAM_LISTPACKS_3: {
+      err = SkipStreamValue(type);
+      if (err) {
+        return err;
+      }
+      *out = nullptr;  // skipped
+      return common::Error();
+    }
+    case RDB_TYPE_HASH_METADATA_PRE_GA:
+    case RDB_TYPE_HASH_LISTPACK_EX_PRE_GA:
+    case RDB_TYPE_HASH_METADATA:
+    case RDB_TYPE_HASH_LISTPACK_EX: {
+      err = SkipHashWithFieldsTTL(type);
+      if (err) {
+        return err;
+      }
+      *out = nullptr;  // skipped
+      return common::Error();
+    }
+    case RDB_TYPE_MODULE:
+      is_unsupported_ = true;
+      return common::make_error("Unsupported RDB value: module values without opcodes");
+    default:
+      is_unsupported_ = true;
+      return common::make_error(common::MemSPrintf("Unknown RDB value type: %d", static_cast<int>(type)));
+  }
+
+  switch (type) {
+    case RDB_TYPE_LIST:
+    case RDB_TYPE_LIST_ZIPLIST:
+    case RDB_TYPE_LIST_QUICKLIST:
+    case RDB_TYPE_LIST_QUICKLIST_2:
+      *out = MakeList(entries);
+      break;
+    case RDB_TYPE_SET:
+    case RDB_TYPE_SET_INTSET:
+    case RDB_TYPE_SET_LISTPACK:
+      *out = MakeSet(entries);
+      break;
+    case RDB_TYPE_HASH:
+    case RDB_TYPE_HASH_ZIPMAP:
+    case RDB_TYPE_HASH_ZIPLIST:
+    case RDB_TYPE_HASH_LISTPACK:
+      *out = MakeHash(entries);
+      break;
+    default:
+      *out = MakeZSet(entries);
+      break;
+  }
+  return common::Error();
+}
+
+common::Error RdbParser::SkipLengths(size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    uint64_t len = 0;
+    common::Error err = ReadLength(&len);
+    if (err) {
+      return err;
+    }
+  }
+  return common::Error();
+}
+
+// listpacks with their master ids, then the consumer groups with their pending entries
+common::Error RdbParser::SkipStreamValue(uint8_t type) {
+  uint64_t count = 0;
+  common::Error err = ReadLength(&count);
+  if (err) {
+    return err;
+  }
+
+  string_t str;
+  for (uint64_t i = 0; i < count; ++i) {
+    err = ReadString(&str);  // master id
+    if (!err) {
+      err = ReadString(&str);  // listpack
+    }
+    if (err) {
+      return err;
+    }
+  }
+
+  // length, last id, and since v2 first id, max deleted id and entries added
+  err = SkipLengths(type == RDB_TYPE_STREAM_LISTPACKS ? 3 : 8);
+  if (err) {
+    return err;
+  }
+
+  uint64_t groups = 0;
+  err = ReadLength(&groups);
+  if (err) {
+    return err;
+  }
+
+  uint8_t data[16];
+  for (uint64_t i = 0; i < groups; ++i) {
+    err = ReadString(&str);  // name
+    if (!err) {
+      err = SkipLengths(type == RDB_TYPE_STREAM_LISTPACKS ? 2 : 3);  // last id, since v2 entries read
+    }
+    uint64_t pending = 0;
+    if (!err) {
+      err = ReadLength(&pending);
+    }
+    for (uint64_t j = 0; j < pending && !err; ++j) {
+      err = Read(data, 16 + 8);  // raw id, delivery time
+      if (!err) {
+        err = SkipLengths(1);  // delivery count
+      }
+    }
+    if (err) {
+      return err;
+    }
+
+    uint64_t consumers = 0;
+    err = ReadLength(&consumers);
+    for (uint64_t j = 0; j < consumers && !err; ++j) {
+      err = ReadString(&str);  // name
+      if (!err) {
+        err = Read(data, type == RDB_TYPE_STREAM_LISTPACKS_3 ? 16 : 8);  // seen time, since v3 active time
+      }
+      if (!err) {
+        err = ReadLength(&pending);
+      }
+      for (uint64_t k = 0; k < pending && !err; ++k) {
+        err = Read(data, 16);  // raw id
+      }
+    }
+    if (err) {
+      return err;
+    }
+  }
+  return common::Error();
+}
+
+// field expiry is not kept by our hash values, such keys are skipped
+common::Error RdbParser::SkipHashWithFieldsTTL(uint8_t type) {
+  uint8_t min_expire[8];
+  common::Error err;
+  if (type == RDB_TYPE_HASH_METADATA || type == RDB_TYPE_HASH_LISTPACK_EX) {
+    err = Read(min_expire, sizeof(min_expire));
+    if (err) {
+      return err;
+    }
+  }
+
+  string_t str;
+  if (type == RDB_TYPE_HASH_LISTPACK_EX || type == RDB_TYPE_HASH_LISTPACK_EX_PRE_GA) {
+    return ReadString(&str);
+  }
+
+  uint64_t count = 0;
+  err = ReadLength(&count);
+  for (uint64_t i = 0; i < count && !err; ++i) {
+    err = SkipLengths(1);  // ttl
+    if (!err) {
+      err = ReadString(&str);  // field
+    }
+    if (!err) {
+      err = ReadString(&str);  // value
+    }
+  }
+  return err;
+}
+
+// module serialized values are typed, so they can be skipped without the module
+common::Error RdbParser::SkipModuleValue() {
+  while (true) {
+    uint64_t opcode = 0;
+    common::Error err = ReadLength(&opcode);
+    if (err) {
+      return err;
+    }
+
+    uint64_t len = 0;
+    string_t str;
+    uint8_t data[8];
+    switch (opcode) {
+      case RDB_MODULE_OPCODE_EOF:
+        return common::Error();
+      case RDB_MODULE_OPCODE_SINT:
+      case RDB_MODULE_OPCODE_UINT:
+        err = ReadLength(&len);
+        break;
+      case RDB_MODULE_OPCODE_FLOAT:
+        err = Read(data, 4);
+        break;
+      case RDB_MODULE_OPCODE_DOUBLE:
+        err = Read(data, 8);
+        break;
+      case RDB_MODULE_OPCODE_STRING:
+        err = ReadString(&str);
+        break;
+      default:
+        return MakeFormatError("unknown module opcode");
+    }
+
+    if (err) {
+      return err;
+    }
+  }
+}
+
+}  // namespace redis_compatible
+}  // namespace core
+}  // namespace fastonosql
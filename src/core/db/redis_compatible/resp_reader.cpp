@@ -0,0 +1,427 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <fastonosql/core/db/redis_compatible/resp_reader.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+extern "C" {
+#include <hiredis/hiredis.h>
+}
+
+#include <fastonosql/core/db/redis_compatible/db_connection.h>
+
+namespace fastonosql {
+namespace core {
+namespace redis_compatible {
+
+namespace {
+bool ParseInteger(const char* str, size_t len, int64_t* out) {
+  if (len == 0 || len > 20) {
+    return false;
+  }
+
+  const std::string number(str, len);
+  char* end = nullptr;
+  const long long value = strtoll(number.c_str(), &end, 10);
+  if (end != number.c_str() + number.size()) {
+    return false;
+  }
+
+  *out = value;
+  return true;
+}
+}  // namespace
+
+RespReader::RespReader(element_callback_t on_element)
+    : on_element_(on_element), buf_(), pos_(0), stack_(), reply_err_() {}
+
+RespReader::~RespReader() {
+  Reset();
+}
+
+void RespReader::Feed(const char* buf, size_t len) {
+  if (pos_ != 0 && pos_ * 2 >= buf_.size()) {  // drop what is parsed before it dominates the buffer
+    buf_.erase(buf_.begin(), buf_.begin() + pos_);
+    pos_ = 0;
+  }
+  buf_.insert(buf_.end(), buf, buf + len);
+}
+
+common::Error RespReader::GetReply(common::Value** out, bool* complete) {
+  if (!out || !complete) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  *complete = false;
+  while (true) {
+    common::Value* value = nullptr;
+    common::Error err;
+    const ParseResult result = ParseOne(&value, &err);
+    if (err) {
+      Reset();
+      return err;
+    }
+
+    if (result == PARSE_MORE) {
+      return common::Error();
+    }
+
+    if (result == PARSE_AGGREGATE) {
+      continue;
+    }
+
+    if (Emit(value, out)) {
+      *complete = true;
+      if (reply_err_) {
+        err = reply_err_;
+        reply_err_ = common::Error();
+        delete *out;
+        *out = nullptr;
+        return err;
+      }
+      return common::Error();
+    }
+  }
+}
+
+RespReader::ParseResult RespReader::ParseOne(common::Value** value, common::Error* err) {
+  size_t line_end = 0;
+  if (pos_ >= buf_.size() || !FindLine(pos_ + 1, &line_end)) {
+    return PARSE_MORE;
+  }
+
+  const char type = buf_[pos_];
+  const char* line = buf_.data() + pos_ + 1;
+  const size_t line_len = line_end - pos_ - 1;
+  const size_t next = line_end + 2;
+  switch (type) {
+    case '+':
+    case '(': {  // status, big number
+      *value = common::Value::CreateStringValue(GEN_CMD_STRING_SIZE(line, line_len));
+      pos_ = next;
+      return PARSE_VALUE;
+    }
+    case '-': {
+      if (!reply_err_) {
+        reply_err_ = common::make_error(std::string(line, line_len));
+      }
+      *value = common::Value::CreateNullValue();
+      pos_ = next;
+      return PARSE_VALUE;
+    }
+    case ':': {
+      int64_t integer;
+      if (!ParseInteger(line, line_len, &integer)) {
+        *err = common::make_error("Protocol error, bad integer");
+        return PARSE_MORE;
+      }
+      *value = common::Value::CreateInteger64Value(integer);
+      pos_ = next;
+      return PARSE_VALUE;
+    }
+    case '_': {
+      *value = common::Value::CreateNullValue();
+      pos_ = next;
+      return PARSE_VALUE;
+    }
+    case '#': {
+      *value = common::Value::CreateBooleanValue(line_len == 1 && line[0] == 't');
+      pos_ = next;
+      return PARSE_VALUE;
+    }
+    case ',': {
+      const std::string number(line, line_len);
+      *value = common::Value::CreateDoubleValue(strtod(number.c_str(), nullptr));
+      pos_ = next;
+      return PARSE_VALUE;
+    }
+    case '$':
+    case '=':
+    case '!': {  // bulk string, verbatim string, bulk error
+      int64_t len;
+      if (!ParseInteger(line, line_len, &len) || len < -1) {
+        *err = common::make_error("Protocol error, bad bulk length");
+        return PARSE_MORE;
+      }
+
+      if (len == -1) {
+        *value = common::Value::CreateNullValue();
+        pos_ = next;
+        return PARSE_VALUE;
+      }
+
+      // the payload is copied once, from the socket buffer into the value
+      const size_t payload_end = next + static_cast<size_t>(len);
+      if (payload_end + 2 > buf_.size()) {
+        return PARSE_MORE;
+      }
+
+      const char* payload = buf_.data() + next;
+      size_t payload_len = len;
+      if (type == '=' && payload_len >= 4) {  // "txt:" prefix
+        payload += 4;
+        payload_len -= 4;
+      }
+
+      if (type == '!') {
+        if (!reply_err_) {
+          reply_err_ = common::make_error(std::string(payload, payload_len));
+        }
+        *value = common::Value::CreateNullValue();
+      } else {
+        *value = common::Value::CreateStringValue(GEN_CMD_STRING_SIZE(payload, payload_len));
+      }
+      pos_ = payload_end + 2;
+      return PARSE_VALUE;
+    }
+    case '*':
+    case '~':
+    case '>':
+    case '%':
+    case '|': {  // array, set, push, map, attribute
+      int64_t count;
+      if (!ParseInteger(line, line_len, &count) || count < -1) {
+        *err = common::make_error("Protocol error, bad aggregate length");
+        return PARSE_MORE;
+      }
+      pos_ = next;
+
+      if (count == -1) {
+        *value = common::Value::CreateNullValue();
+        return PARSE_VALUE;
+      }
+
+      if (type == '%' || type == '|') {
+        count *= 2;
+      }
+
+      const bool is_skipped = type == '|';
+      if (count == 0) {
+        if (is_skipped) {
+          return PARSE_AGGREGATE;
+        }
+        // an empty streamed aggregate has no elements to hand out
+        *value = stack_.empty() && on_element_ ? nullptr : common::Value::CreateArrayValue();
+        return PARSE_VALUE;
+      }
+
+      if (stack_.size() >= max_depth) {
+        *err = common::make_error("Protocol error, nesting is too deep");
+        return PARSE_MORE;
+      }
+
+      Frame frame;
+      frame.remaining = count;
+      frame.index = 0;
+      frame.is_skipped = is_skipped;
+      frame.is_streamed = !is_skipped && stack_.empty() && on_element_;
+      frame.array = frame.is_skipped || frame.is_streamed ? nullptr : common::Value::CreateArrayValue();
+      stack_.push_back(frame);
+      return PARSE_AGGREGATE;
+    }
+    default:
+      break;
+  }
+
+  *err = common::make_error(std::string("Protocol error, unexpected type byte: ") + type);
+  return PARSE_MORE;
+}
+
+bool RespReader::Emit(common::Value* value, common::Value** out) {
+  while (!stack_.empty()) {
+    Frame& top = stack_.back();
+    if (top.is_skipped) {
+      delete value;
+    } else if (top.is_streamed) {
+      on_element_(top.index, value);
+    } else {
+      top.array->Append(value);
+    }
+    top.index++;
+
+    if (--top.remaining > 0) {
+      return false;
+    }
+
+    // aggregate is complete, it becomes an element of its parent
+    const Frame done = top;
+    stack_.pop_back();
+    if (done.is_skipped) {  // the attributed value follows
+      return false;
+    }
+    value = done.array;
+    if (done.is_streamed) {
+      break;
+    }
+  }
+
+  *out = value;
+  return true;
+}
+
+bool RespReader::FindLine(size_t from, size_t* end) const {
+  for (size_t i = from; i + 1 < buf_.size(); ++i) {
+    if (buf_[i] == '\r' && buf_[i + 1] == '\n') {
+      *end = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+void RespReader::Reset() {
+  for (const Frame& frame : stack_) {
+    delete frame.array;
+  }
+  stack_.clear();
+  buf_.clear();
+  pos_ = 0;
+  reply_err_ = common::Error();
+}
+
+common::Error ExecRedisCommandToValue(redisContext* context,
+                                      const commands_args_t& argv,
+                                      common::Value** out,
+                                      RespReader::element_callback_t on_element) {
+  if (!context || argv.empty() || !out) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  std::vector<const char*> argvc(argv.size());
+  std::vector<size_t> argvlen(argv.size());
+  for (size_t i = 0; i < argv.size(); ++i) {
+    argvc[i] = argv[i].data();
+    argvlen[i] = argv[i].size();
+  }
+
+  if (redisAppendCommandArgv(context, argv.size(), argvc.data(), argvlen.data()) == REDIS_ERR) {
+    return PrintRedisContextError(context);
+  }
+
+  int done = 0;
+  while (!done) {
+    if (redisBufferWrite(context, &done) == REDIS_ERR) {
+      return PrintRedisContextError(context);
+    }
+  }
+
+  // bypass the hiredis reader, bytes go from the socket (or ssh channel) into the values
+  RespReader reader(on_element);
+  char chunk[16 * 1024];
+  while (true) {
+    bool complete = false;
+    common::Error err = reader.GetReply(out, &complete);
+    if (err || complete) {
+      return err;
+    }
+
+    ssize_t nread = 0;
+    if (redisReadToBuffer(context, chunk, sizeof(chunk), &nread) == REDIS_ERR) {
+      return PrintRedisContextError(context);
+    }
+    reader.Feed(chunk, nread);
+  }
+}
+
+common::Error ExecRedisPipelineToValues(redisContext* context,
+                                        const std::vector<commands_args_t>& cmds,
+                                        size_t window,
+                                        pipeline_value_callback_t on_value) {
+  if (!context || window == 0 || !on_value) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  // the reader keeps bytes of the next replies between GetReply calls
+  RespReader reader;
+  char chunk[16 * 1024];
+  std::vector<const char*> argvc;
+  std::vector<size_t> argvlen;
+  for (size_t start = 0; start < cmds.size(); start += window) {
+    const size_t stop = std::min(cmds.size(), start + window);
+    for (size_t i = start; i < stop; ++i) {
+      const commands_args_t& argv = cmds[i];
+      argvc.resize(argv.size());
+      argvlen.resize(argv.size());
+      for (size_t j = 0; j < argv.size(); ++j) {
+        argvc[j] = argv[j].data();
+        argvlen[j] = argv[j].size();
+      }
+      if (redisAppendCommandArgv(context, argv.size(), argvc.data(), argvlen.data()) == REDIS_ERR) {
+        return PrintRedisContextError(context);
+      }
+    }
+
+    int done = 0;
+    while (!done) {
+      if (redisBufferWrite(context, &done) == REDIS_ERR) {
+        return PrintRedisContextError(context);
+      }
+    }
+
+    // the whole window is read even after an error reply so the context stays usable
+    common::Error first_err;
+    for (size_t i = start; i < stop; ++i) {
+      common::Value* value = nullptr;
+      common::Error reply_err;
+      while (true) {
+        bool complete = false;
+        common::Error err = reader.GetReply(&value, &complete);
+        if (complete) {
+          reply_err = err;
+          break;
+        }
+        if (err) {
+          return err;
+        }
+
+        ssize_t nread = 0;
+        if (redisReadToBuffer(context, chunk, sizeof(chunk), &nread) == REDIS_ERR) {
+          return PrintRedisContextError(context);
+        }
+        reader.Feed(chunk, nread);
+      }
+
+      if (first_err || reply_err) {
+        delete value;
+        if (!first_err) {
+          first_err = reply_err;
+        }
+        continue;
+      }
+      first_err = on_value(i, value);
+    }
+
+    if (first_err) {
+      return first_err;
+    }
+  }
+
+  return common::Error();
+}
+
+}  // namespace redis_compatible
+}  // namespace core
+}  // namespace fastonosql
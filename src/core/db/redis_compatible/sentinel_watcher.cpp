@@ -0,0 +1,305 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <fastonosql/core/db/redis_compatible/sentinel_watcher.h>
+
+#include <algorithm>
+#include <vector>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#define poll WSAPoll
+#else
+#include <poll.h>
+#endif
+
+extern "C" {
+#include <hiredis/hiredis.h>
+}
+
+#include <common/convert2string.h>
+
+#include <fastonosql/core/db/redis_compatible/db_connection.h>
+
+namespace fastonosql {
+namespace core {
+namespace redis_compatible {
+
+namespace {
+const char kSwitchMasterChannel[] = "+switch-master";
+const std::chrono::milliseconds kMinSubscribeBackoff(500);
+const std::chrono::milliseconds kMaxSubscribeBackoff(30000);
+
+// "<name> <old ip> <old port> <new ip> <new port>"
+bool ParseSwitchMaster(const std::string& message, std::string* name, common::net::HostAndPort* master) {
+  std::vector<std::string> parts;
+  size_t start = 0;
+  while (start < message.size()) {
+    size_t stop = message.find(' ', start);
+    if (stop == std::string::npos) {
+      stop = message.size();
+    }
+    parts.push_back(message.substr(start, stop - start));
+    start = stop + 1;
+  }
+
+  uint16_t port;
+  if (parts.size() != 5 || !common::ConvertFromString(parts[4], &port)) {
+    return false;
+  }
+
+  *name = parts[0];
+  *master = common::net::HostAndPort(parts[3], port);
+  return true;
+}
+}  // namespace
+
+common::Error GetSentinelMaster(redisContext* sentinel, const std::string& name, common::net::HostAndPort* master) {
+  if (!sentinel || name.empty() || !master) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  redisReply* reply = nullptr;
+  const commands_args_t cmd = {GEN_CMD_STRING("SENTINEL"), GEN_CMD_STRING("get-master-addr-by-name"),
+                               common::ConvertToCharBytes(name)};
+  common::Error err = ExecRedisCommand(sentinel, cmd, &reply);
+  if (err) {
+    return err;
+  }
+
+  // [ip, port] or nil for an unknown name
+  if (reply->type != REDIS_REPLY_ARRAY || reply->elements != 2 || reply->element[0]->type != REDIS_REPLY_STRING ||
+      reply->element[1]->type != REDIS_REPLY_STRING) {
+    freeReplyObject(reply);
+    return common::make_error("Sentinel doesn't monitor master: " + name);
+  }
+
+  uint16_t port;
+  if (!common::ConvertFromString(std::string(reply->element[1]->str, reply->element[1]->len), &port)) {
+    freeReplyObject(reply);
+    return common::make_error("Invalid master port");
+  }
+
+  *master = common::net::HostAndPort(std::string(reply->element[0]->str, reply->element[0]->len), port);
+  freeReplyObject(reply);
+  return common::Error();
+}
+
+SentinelWatcher::SentinelWatcher(const Config& config, const SSHInfo& sinfo)
+    : config_(config),
+      sinfo_(sinfo),
+      query_(nullptr),
+      subscriber_(nullptr),
+      master_(),
+      next_subscribe_(),
+      subscribe_backoff_(kMinSubscribeBackoff) {}
+
+SentinelWatcher::~SentinelWatcher() {
+  Stop();
+}
+
+common::Error SentinelWatcher::Start(common::net::HostAndPort* master) {
+  if (!master) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  Stop();
+  common::Error err = OpenContext(&query_);
+  if (err) {
+    return err;
+  }
+
+  err = Resolve(master);
+  if (err) {
+    Stop();
+    return err;
+  }
+
+  err = Subscribe();
+  if (err) {
+    Stop();
+    return err;
+  }
+
+  return common::Error();
+}
+
+common::Error SentinelWatcher::Resolve(common::net::HostAndPort* master) {
+  if (!master) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  if (!query_) {
+    common::Error err = OpenContext(&query_);
+    if (err) {
+      return err;
+    }
+  }
+
+  common::net::HostAndPort lmaster;
+  common::Error err = GetSentinelMaster(query_, config_.sentinel_master, &lmaster);
+  if (err) {
+    if (query_->err) {  // reopen next time
+      redisFree(query_);
+      query_ = nullptr;
+    }
+    return err;
+  }
+
+  master_ = lmaster;
+  *master = lmaster;
+  return common::Error();
+}
+
+common::Error SentinelWatcher::Poll(bool* switched) {
+  if (!switched) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  *switched = false;
+  if (!subscriber_) {
+    return Resubscribe(switched);
+  }
+
+  while (true) {
+    void* reply = nullptr;
+    if (redisGetReplyFromReader(subscriber_, &reply) == REDIS_ERR) {
+      common::Error err = PrintRedisContextError(subscriber_);
+      DropSubscriber();
+      return err;
+    }
+
+    if (reply) {
+      // ["message", channel, payload]
+      redisReply* rreply = static_cast<redisReply*>(reply);
+      std::string name;
+      common::net::HostAndPort master;
+      if (rreply->type == REDIS_REPLY_ARRAY && rreply->elements == 3 &&
+          rreply->element[2]->type == REDIS_REPLY_STRING &&
+          ParseSwitchMaster(std::string(rreply->element[2]->str, rreply->element[2]->len), &name, &master) &&
+          name == config_.sentinel_master) {
+        master_ = master;
+        *switched = true;
+      }
+      freeReplyObject(rreply);
+      continue;
+    }
+
+    // nothing parsed yet, read only what already arrived
+    struct pollfd fd;
+    fd.fd = subscriber_->fd;
+    fd.events = POLLIN;
+    fd.revents = 0;
+    if (poll(&fd, 1, 0) <= 0) {
+      return common::Error();
+    }
+
+    if (redisBufferRead(subscriber_) == REDIS_ERR) {
+      common::Error err = PrintRedisContextError(subscriber_);
+      DropSubscriber();
+      return err;
+    }
+  }
+}
+
+common::net::HostAndPort SentinelWatcher::GetMaster() const {
+  return master_;
+}
+
+common::Error SentinelWatcher::OpenContext(redisContext** context) {
+  // config auth and database belong to the master, sentinels get neither
+  redisContext* lcontext = nullptr;
+  common::Error err = CreateConnection(config_, sinfo_, &lcontext);
+  if (err) {
+    return err;
+  }
+
+  *context = lcontext;
+  return common::Error();
+}
+
+common::Error SentinelWatcher::Subscribe() {
+  redisContext* lcontext = nullptr;
+  common::Error err = OpenContext(&lcontext);
+  if (err) {
+    return err;
+  }
+
+  redisReply* reply = nullptr;
+  const commands_args_t subscribe_cmd = {GEN_CMD_STRING("SUBSCRIBE"), GEN_CMD_STRING(kSwitchMasterChannel)};
+  err = ExecRedisCommand(lcontext, subscribe_cmd, &reply);
+  if (err) {
+    redisFree(lcontext);
+    return err;
+  }
+
+  freeReplyObject(reply);
+  subscriber_ = lcontext;
+  subscribe_backoff_ = kMinSubscribeBackoff;
+  return common::Error();
+}
+
+common::Error SentinelWatcher::Resubscribe(bool* switched) {
+  const auto now = std::chrono::steady_clock::now();
+  if (now < next_subscribe_) {
+    return common::make_error("Not subscribed to sentinel");
+  }
+
+  common::Error err = Subscribe();
+  if (err) {
+    next_subscribe_ = now + subscribe_backoff_;
+    subscribe_backoff_ = std::min(subscribe_backoff_ * 2, kMaxSubscribeBackoff);
+    return err;
+  }
+
+  // a failover may have happened while nobody was listening
+  const common::net::HostAndPort old_master = master_;
+  common::net::HostAndPort master;
+  err = Resolve(&master);
+  if (err) {
+    return err;
+  }
+
+  *switched = master.GetHost() != old_master.GetHost() || master.GetPort() != old_master.GetPort();
+  return common::Error();
+}
+
+void SentinelWatcher::DropSubscriber() {
+  redisFree(subscriber_);
+  subscriber_ = nullptr;
+  next_subscribe_ = std::chrono::steady_clock::now();
+}
+
+void SentinelWatcher::Stop() {
+  if (query_) {
+    redisFree(query_);
+    query_ = nullptr;
+  }
+  if (subscriber_) {
+    redisFree(subscriber_);
+    subscriber_ = nullptr;
+  }
+}
+
+}  // namespace redis_compatible
+}  // namespace core
+}  // namespace fastonosql
@@ -18,6 +18,8 @@
 
 #include <fastonosql/core/db/rocksdb/db_connection.h>
 
+#include <algorithm>
+
 #include <common/convert2string.h>
 #include <common/file_system/string_path_utils.h>
 
@@ -148,14 +150,23 @@ const ConstantCommandsArray kCommands = {CommandHolder(GEN_CMD_STRING(DB_HELP_CO
                                                        0,
                                                        CommandInfo::Native,
                                                        &CommandsApi::Keys),
+                                         CommandHolder(GEN_CMD_STRING(DB_REVERSE_KEYS_COMMAND),
+                                                       "<key_start> <key_end> <limit>",
+                                                       "Find keys matching the given limits in descending order.",
+                                                       UNDEFINED_SINCE,
+                                                       DB_REVERSE_KEYS_COMMAND " a z 10",
+                                                       3,
+                                                       0,
+                                                       CommandInfo::Native,
+                                                       &CommandsApi::ReverseKeys),
                                          CommandHolder(GEN_CMD_STRING(DB_DBKCOUNT_COMMAND),
-                                                       "-",
+                                                       "[" DB_DBKCOUNT_APPROX_ARG "]",
                                                        "Return the number of keys in the "
                                                        "selected database",
                                                        UNDEFINED_SINCE,
                                                        DB_DBKCOUNT_COMMAND,
                                                        0,
-                                                       0,
+                                                       1,
                                                        CommandInfo::Native,
                                                        &CommandsApi::DBKeysCount),
                                          CommandHolder(GEN_CMD_STRING(DB_FLUSHDB_COMMAND),
@@ -331,7 +342,8 @@ class rocksdb_handle {
   std::vector<::rocksdb::Status> MultiGet(const ::rocksdb::ReadOptions& options,
                                           const std::vector<::rocksdb::Slice>& keys,
                                           std::vector<std::string>* values) {
-    return db_->MultiGet(options, handles_, keys, values);
+    const std::vector<::rocksdb::ColumnFamilyHandle*> columns(keys.size(), GetCurrentColumn());
+    return db_->MultiGet(options, columns, keys, values);
   }
 
   ::rocksdb::Status Merge(const ::rocksdb::WriteOptions& options,
@@ -350,11 +362,22 @@ class rocksdb_handle {
     return db_->Delete(options, GetCurrentColumn(), key);
   }
 
+  ::rocksdb::Status DeleteRange(const ::rocksdb::WriteOptions& options,
+                                const ::rocksdb::Slice& begin_key,
+                                const ::rocksdb::Slice& end_key) {
+    return db_->DeleteRange(options, GetCurrentColumn(), begin_key, end_key);
+  }
+
+  ::rocksdb::Status CompactRange(const ::rocksdb::Slice* begin_key, const ::rocksdb::Slice* end_key) {
+    return db_->CompactRange(::rocksdb::CompactRangeOptions(), GetCurrentColumn(), begin_key, end_key);
+  }
+
   ::rocksdb::Iterator* NewIterator(const ::rocksdb::ReadOptions& options) {
     return db_->NewIterator(options, GetCurrentColumn());
   }
 
   ::rocksdb::ColumnFamilyHandle* GetCurrentColumn() const { return handles_[current_db_index_]; }
+  const ::rocksdb::Comparator* GetComparator() const { return GetCurrentColumn()->GetComparator(); }
   std::string GetCurrentDBName() const {
     ::rocksdb::ColumnFamilyHandle* fam = GetCurrentColumn();
     return fam->GetName();
@@ -796,20 +819,48 @@ common::Error DBConnection::DelInner(const raw_key_t& key) {
   return CheckResultCommand(DB_DELETE_KEY_COMMAND, connection_.handle_->Delete(wo, key_slice));
 }
 
-common::Error DBConnection::ScanImpl(cursor_t cursor_in,
+common::Error DBConnection::ScanImpl(const cursor_t& cursor_in,
                                      const pattern_t& pattern,
                                      keys_limit_t count_keys,
                                      raw_keys_t* keys_out,
                                      cursor_t* cursor_out) {
+  const ScanPattern matcher(pattern);
+  const raw_key_t& prefix = matcher.GetPrefix();
+  const ::rocksdb::Slice prefix_slice(prefix.data(), prefix.size());
+  // in bytewise order all keys with the literal prefix are adjacent
+  const bool is_prefix_range =
+      !prefix.empty() && connection_.handle_->GetComparator() == ::rocksdb::BytewiseComparator();
   ::rocksdb::ReadOptions ro;
   ::rocksdb::Iterator* it = connection_.handle_->NewIterator(ro);  // keys(key_start, key_end, limit, ret);
-  cursor_t offset_pos = cursor_in;
-  cursor_t lcursor_out = 0;
+  cursor_t::position_t offset_pos = cursor_in.GetPosition();
+  if (cursor_in.HasToken()) {  // continue right after the last returned key
+    const raw_key_t last_key = cursor_in.GetToken();
+    const ::rocksdb::Slice last_key_slice(last_key.data(), last_key.size());
+    if (is_prefix_range && last_key_slice.compare(prefix_slice) < 0) {
+      it->Seek(prefix_slice);
+    } else {
+      it->Seek(last_key_slice);
+      if (it->Valid() && it->key() == last_key_slice) {
+        it->Next();
+      }
+    }
+    offset_pos = 0;
+  } else if (is_prefix_range) {
+    it->Seek(prefix_slice);
+  } else {
+    it->SeekToFirst();
+  }
+
+  cursor_t lcursor_out;
   std::vector<command_buffer_t> lkeys_out;
-  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+  for (; it->Valid(); it->Next()) {
     const ::rocksdb::Slice key_slice = it->key();
+    if (is_prefix_range && !key_slice.starts_with(prefix_slice)) {  // the rest of db is out of the pattern
+      break;
+    }
+
     if (lkeys_out.size() < count_keys) {
-      if (IsKeyMatchPattern(key_slice.data(), key_slice.size(), pattern)) {
+      if (matcher.IsMatch(key_slice.data(), key_slice.size())) {
         if (offset_pos == 0) {
           const raw_key_t key = GEN_CMD_STRING_SIZE(key_slice.data(), key_slice.size());
           lkeys_out.push_back(key);
@@ -818,7 +869,8 @@ common::Error DBConnection::ScanImpl(cursor_t cursor_in,
         }
       }
     } else {
-      lcursor_out = cursor_in + count_keys;
+      lcursor_out =
+          lkeys_out.empty() ? cursor_in : cursor_t(cursor_in.GetPosition() + count_keys, lkeys_out.back());
       break;
     }
   }
@@ -840,19 +892,30 @@ common::Error DBConnection::KeysImpl(const raw_key_t& key_start,
                                      const raw_key_t& key_end,
                                      keys_limit_t limit,
                                      raw_keys_t* ret) {
+  const ::rocksdb::Comparator* cmp = connection_.handle_->GetComparator();
   const ::rocksdb::Slice key_start_slice(key_start.data(), key_start.size());
+  const ::rocksdb::Slice key_end_slice(key_end.data(), key_end.size());
+  const bool is_end_limited = key_end != kRangeKeyEnd;
   ::rocksdb::ReadOptions ro;
+  // key_end is inclusive, iterate_upper_bound is not: in bytewise order key_end + '\0' is the next possible key
+  std::string upper_bound;
+  ::rocksdb::Slice upper_bound_slice;
+  if (is_end_limited && cmp == ::rocksdb::BytewiseComparator()) {
+    upper_bound.assign(key_end.data(), key_end.size());
+    upper_bound.push_back('\0');
+    upper_bound_slice = upper_bound;
+    ro.iterate_upper_bound = &upper_bound_slice;
+  }
   ::rocksdb::Iterator* it = connection_.handle_->NewIterator(ro);  // keys(key_start, key_end, limit, ret);
-  for (it->Seek(key_start_slice); it->Valid(); it->Next()) {
+  for (it->Seek(key_start_slice); it->Valid() && ret->size() < limit; it->Next()) {
     auto slice = it->key();
-    command_buffer_t key = GEN_CMD_STRING_SIZE(slice.data(), slice.size());
-    if (ret->size() < limit) {
-      if (IsKeyInEndRange(key, key_end)) {
-        ret->push_back(key);
-      }
-    } else {
+    if (is_end_limited && cmp->Compare(slice, key_end_slice) > 0) {  // the rest of db is out of range
       break;
     }
+
+    if (!slice.empty()) {
+      ret->push_back(GEN_CMD_STRING_SIZE(slice.data(), slice.size()));
+    }
   }
 
   auto st = it->status();
@@ -860,22 +923,39 @@ common::Error DBConnection::KeysImpl(const raw_key_t& key_start,
   return CheckResultCommand(DB_KEYS_COMMAND, st);
 }
 
-common::Error DBConnection::DBKeysCountImpl(keys_limit_t* size) {
-  keys_limit_t sz = 0;
-  common::Error err;
-#if 0
-  std::string ret;
-  err = GetProperty(ROCKSDB_KEYS_COUNT_PROPERTY, &ret);
-  if (!err) {
-    if (common::ConvertFromString(ret, &sz)) {
-      *size = sz;
-      return common::Error();
+common::Error DBConnection::ReverseKeysImpl(const raw_key_t& key_start,
+                                            const raw_key_t& key_end,
+                                            keys_limit_t limit,
+                                            raw_keys_t* ret) {
+  const ::rocksdb::Slice key_start_slice(key_start.data(), key_start.size());
+  const ::rocksdb::Slice key_end_slice(key_end.data(), key_end.size());
+  ::rocksdb::ReadOptions ro;
+  if (key_start != kRangeKeyStart) {
+    ro.iterate_lower_bound = &key_start_slice;  // inclusive
+  }
+  ::rocksdb::Iterator* it = connection_.handle_->NewIterator(ro);
+  if (key_end == kRangeKeyEnd) {
+    it->SeekToLast();
+  } else {
+    it->SeekForPrev(key_end_slice);
+  }
+
+  for (; it->Valid() && ret->size() < limit; it->Prev()) {
+    auto slice = it->key();
+    if (!slice.empty()) {
+      ret->push_back(GEN_CMD_STRING_SIZE(slice.data(), slice.size()));
     }
   }
-#endif
 
-  // old calc
+  auto st = it->status();
+  delete it;
+  return CheckResultCommand(DB_REVERSE_KEYS_COMMAND, st);
+}
+
+common::Error DBConnection::DBKeysCountImpl(keys_limit_t* size) {
+  keys_limit_t sz = 0;
   ::rocksdb::ReadOptions ro;
+  ro.fill_cache = false;
   ::rocksdb::Iterator* it = connection_.handle_->NewIterator(ro);
   for (it->SeekToFirst(); it->Valid(); it->Next()) {
     sz++;
@@ -884,7 +964,7 @@ common::Error DBConnection::DBKeysCountImpl(keys_limit_t* size) {
   auto st = it->status();
   delete it;
 
-  err = CheckResultCommand(DB_DBKCOUNT_COMMAND, st);
+  common::Error err = CheckResultCommand(DB_DBKCOUNT_COMMAND, st);
   if (err) {
     return err;
   }
@@ -893,22 +973,64 @@ common::Error DBConnection::DBKeysCountImpl(keys_limit_t* size) {
   return common::Error();
 }
 
+common::Error DBConnection::ApproximateDBKeysCountImpl(keys_limit_t* size) {
+  std::string ret;
+  common::Error err = GetProperty(ROCKSDB_KEYS_COUNT_PROPERTY, &ret);
+  if (err) {
+    return err;
+  }
+
+  uint64_t sz = 0;
+  if (!common::ConvertFromString(ret, &sz)) {
+    return common::make_error_inval();
+  }
+
+  *size = static_cast<keys_limit_t>(std::min<uint64_t>(sz, std::numeric_limits<keys_limit_t>::max()));
+  return common::Error();
+}
+
 common::Error DBConnection::FlushDBImpl() {
   ::rocksdb::ReadOptions ro;
-  ::rocksdb::WriteOptions wo;
+  ro.fill_cache = false;
   ::rocksdb::Iterator* it = connection_.handle_->NewIterator(ro);
-  for (it->SeekToFirst(); it->Valid(); it->Next()) {
-    std::string key = it->key().ToString();
-    common::Error err = CheckResultCommand(DB_FLUSHDB_COMMAND, connection_.handle_->Delete(wo, key));
-    if (err) {
-      delete it;
-      return err;
+  std::string first_key;
+  std::string last_key;
+  it->SeekToFirst();
+  const bool is_empty = !it->Valid();
+  if (!is_empty) {
+    first_key = it->key().ToString();
+    it->SeekToLast();
+    if (it->Valid()) {
+      last_key = it->key().ToString();
     }
   }
 
   auto st = it->status();
   delete it;
-  return CheckResultCommand(DB_FLUSHDB_COMMAND, st);
+
+  common::Error err = CheckResultCommand(DB_FLUSHDB_COMMAND, st);
+  if (err) {
+    return err;
+  }
+
+  if (is_empty) {
+    return common::Error();
+  }
+
+  // one range tombstone instead of a tombstone per key, end of range is exclusive
+  ::rocksdb::WriteOptions wo;
+  err = CheckResultCommand(DB_FLUSHDB_COMMAND, connection_.handle_->DeleteRange(wo, first_key, last_key));
+  if (err) {
+    return err;
+  }
+
+  err = CheckResultCommand(DB_FLUSHDB_COMMAND, connection_.handle_->Delete(wo, last_key));
+  if (err) {
+    return err;
+  }
+
+  // drop the covered files now instead of waiting for background compaction
+  return CheckResultCommand(DB_FLUSHDB_COMMAND, connection_.handle_->CompactRange(nullptr, nullptr));
 }
 
 common::Error DBConnection::CreateDBImpl(const db_name_t& name, IDataBaseInfo** info) {
@@ -941,7 +1063,7 @@ common::Error DBConnection::SelectImpl(const db_name_t& name, IDataBaseInfo** in
   }
 
   keys_limit_t kcount = 0;
-  err = DBKeysCount(&kcount);
+  err = ApproximateDBKeysCount(&kcount);  // exact count walks the whole db
   DCHECK(!err) << err->GetDescription();
   *info = new DataBaseInfo(name, true, kcount);
   return common::Error();
@@ -975,6 +1097,40 @@ common::Error DBConnection::GetImpl(const NKey& key, NDbKValue* loaded_key) {
   return common::Error();
 }
 
+common::Error DBConnection::GetUniManyImpl(const NKeys& keys, std::vector<NDbKValue>* loaded_keys) {
+  std::vector<raw_key_t> rkeys;
+  std::vector<::rocksdb::Slice> rslice;
+  rkeys.reserve(keys.size());
+  rslice.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    const auto key_str = keys[i].GetKey();
+    rkeys.push_back(key_str.GetData());
+    rslice.push_back(::rocksdb::Slice(rkeys.back().data(), rkeys.back().size()));
+  }
+
+  std::vector<std::string> ret_values;
+  ::rocksdb::ReadOptions ro;
+  const auto sts = connection_.handle_->MultiGet(ro, rslice, &ret_values);
+  std::vector<NDbKValue> lloaded_keys;
+  lloaded_keys.reserve(keys.size());
+  for (size_t i = 0; i < sts.size(); ++i) {
+    if (sts[i].IsNotFound()) {  // removed after the scan, skipped
+      continue;
+    }
+
+    common::Error err = CheckResultCommand(DB_GET_KEY_COMMAND, sts[i]);
+    if (err) {
+      return err;
+    }
+
+    NValue val(common::Value::CreateStringValue(common::ConvertToCharBytes(ret_values[i])));
+    lloaded_keys.push_back(NDbKValue(keys[i], val));
+  }
+
+  *loaded_keys = lloaded_keys;
+  return common::Error();
+}
+
 common::Error DBConnection::DeleteImpl(const NKeys& keys, NKeys* deleted_keys) {
   for (size_t i = 0; i < keys.size(); ++i) {
     const NKey key = keys[i];
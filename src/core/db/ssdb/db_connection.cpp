@@ -1786,7 +1786,7 @@ common::Error DBConnection::ConfigGetDatabasesImpl(db_names_t* dbs) {
   return common::Error();
 }
 
-common::Error DBConnection::ScanImpl(cursor_t cursor_in,
+common::Error DBConnection::ScanImpl(const cursor_t& cursor_in,
                                      const pattern_t& pattern,
                                      keys_limit_t count_keys,
                                      raw_keys_t* keys_out,
@@ -1798,12 +1798,13 @@ common::Error DBConnection::ScanImpl(cursor_t cursor_in,
     return err;
   }
 
-  cursor_t offset_pos = cursor_in;
-  cursor_t lcursor_out = 0;
+  const ScanPattern matcher(pattern);
+  cursor_t::position_t offset_pos = cursor_in.GetPosition();
+  cursor_t::position_t lcursor_out = 0;
   raw_keys_t lkeys_out;
   for (size_t i = 0; i < ret.size(); ++i) {
     if (lkeys_out.size() < count_keys) {
-      if (IsKeyMatchPattern(ret[i].data(), ret[i].size(), pattern)) {
+      if (matcher.IsMatch(ret[i].data(), ret[i].size())) {
         if (offset_pos == 0) {
           lkeys_out.push_back(common::ConvertToCharBytes(ret[i]));
         } else {
@@ -1811,13 +1812,13 @@ common::Error DBConnection::ScanImpl(cursor_t cursor_in,
         }
       }
     } else {
-      lcursor_out = cursor_in + count_keys;
+      lcursor_out = cursor_in.GetPosition() + count_keys;
       break;
     }
   }
 
   *keys_out = lkeys_out;
-  *cursor_out = lcursor_out;
+  *cursor_out = cursor_t(lcursor_out);
   return common::Error();
 }
 
@@ -18,6 +18,8 @@
 
 #include <fastonosql/core/db/unqlite/db_connection.h>
 
+#include <algorithm>
+
 extern "C" {
 #include <unqlite.h>
 }
@@ -190,13 +192,13 @@ const ConstantCommandsArray kCommands = {CommandHolder(GEN_CMD_STRING(DB_HELP_CO
                                                        CommandInfo::Native,
                                                        &CommandsApi::Keys),
                                          CommandHolder(GEN_CMD_STRING(DB_DBKCOUNT_COMMAND),
-                                                       "-",
+                                                       "[" DB_DBKCOUNT_APPROX_ARG "]",
                                                        "Return the number of keys in the "
                                                        "selected database",
                                                        UNDEFINED_SINCE,
                                                        DB_DBKCOUNT_COMMAND,
                                                        0,
-                                                       0,
+                                                       1,
                                                        CommandInfo::Native,
                                                        &CommandsApi::DBKeysCount),
                                          CommandHolder(GEN_CMD_STRING(DB_FLUSHDB_COMMAND),
@@ -272,6 +274,9 @@ const ConstantCommandsArray kCommands = {CommandHolder(GEN_CMD_STRING(DB_HELP_CO
                                                        0,
                                                        CommandInfo::Native,
                                                        &CommandsApi::Quit)};
+
+const keys_limit_t kApproximateCountSamples = 1024;
+const uint64_t kRecordHeaderSize = 26;  // lhash cell header: key size, data size, next cell and overflow page
 }  // namespace
 }  // namespace unqlite
 
@@ -407,7 +412,7 @@ common::Error DBConnection::GetInner(const raw_key_t& key, raw_value_t* ret_val)
                                                                           unqlite_data_callback_get_value, ret_val));
 }
 
-common::Error DBConnection::ScanImpl(cursor_t cursor_in,
+common::Error DBConnection::ScanImpl(const cursor_t& cursor_in,
                                      const pattern_t& pattern,
                                      keys_limit_t count_keys,
                                      raw_keys_t* keys_out,
@@ -417,18 +422,27 @@ common::Error DBConnection::ScanImpl(cursor_t cursor_in,
   if (err) {
     return err;
   }
-  /* Point to the first record */
-  unqlite_kv_cursor_first_entry(cursor);
+  const ScanPattern matcher(pattern);  // records are hash ordered, so no prefix seek here
+  cursor_t::position_t offset_pos = cursor_in.GetPosition();
+  const raw_key_t last_key = cursor_in.GetToken();
+  if (!last_key.empty() &&
+      unqlite_kv_cursor_seek(cursor, last_key.data(), last_key.size(), UNQLITE_CURSOR_MATCH_EXACT) == UNQLITE_OK) {
+    /* Continue right after the last returned record */
+    unqlite_kv_cursor_next_entry(cursor);
+    offset_pos = 0;
+  } else {
+    /* Point to the first record */
+    unqlite_kv_cursor_first_entry(cursor);
+  }
 
   /* Iterate over the entries */
-  cursor_t offset_pos = cursor_in;
-  cursor_t lcursor_out = 0;
+  cursor_t lcursor_out;
   std::vector<command_buffer_t> lkeys_out;
   while (unqlite_kv_cursor_valid_entry(cursor)) {
     if (lkeys_out.size() < count_keys) {
       raw_key_t skey;
       unqlite_kv_cursor_key_callback(cursor, unqlite_data_callback_get_key, &skey);
-      if (IsKeyMatchPattern(skey.data(), skey.size(), pattern)) {
+      if (matcher.IsMatch(skey.data(), skey.size())) {
         if (offset_pos == 0) {
           lkeys_out.push_back(skey);
         } else {
@@ -436,7 +450,8 @@ common::Error DBConnection::ScanImpl(cursor_t cursor_in,
         }
       }
     } else {
-      lcursor_out = cursor_in + count_keys;
+      lcursor_out =
+          lkeys_out.empty() ? cursor_in : cursor_t(cursor_in.GetPosition() + count_keys, lkeys_out.back());
       break;
     }
 
@@ -506,10 +521,57 @@ common::Error DBConnection::DBKeysCountImpl(keys_limit_t* size) {
   return common::Error();
 }
 
+common::Error DBConnection::ApproximateDBKeysCountImpl(keys_limit_t* size) {
+  unqlite_kv_cursor* cursor; /* Cursor handle */
+  common::Error err = CheckResultCommand(DB_DBKCOUNT_COMMAND, unqlite_kv_cursor_init(connection_.handle_, &cursor));
+  if (err) {
+    return err;
+  }
+
+  /* Records are hash ordered, so the first ones are a fair sample of the file */
+  unqlite_kv_cursor_first_entry(cursor);
+  keys_limit_t sampled = 0;
+  uint64_t sampled_bytes = 0;
+  while (sampled < kApproximateCountSamples && unqlite_kv_cursor_valid_entry(cursor)) {
+    int key_size = 0;
+    unqlite_int64 data_size = 0;
+    unqlite_kv_cursor_key(cursor, nullptr, &key_size);
+    unqlite_kv_cursor_data(cursor, nullptr, &data_size);
+    sampled++;
+    sampled_bytes += kRecordHeaderSize + key_size + data_size;
+    unqlite_kv_cursor_next_entry(cursor);
+  }
+  const bool is_sampled_all = !unqlite_kv_cursor_valid_entry(cursor);
+  unqlite_kv_cursor_release(connection_.handle_, cursor);
+
+  if (is_sampled_all) {
+    *size = sampled;
+    return common::Error();
+  }
+
+  auto conf = GetConfig();
+  off_t db_bytes = 0;
+  common::ErrnoError errn = common::file_system::get_file_size_by_path(conf->db_path, &db_bytes);
+  if (errn || db_bytes <= 0) {  // in-memory db
+    return DBKeysCountImpl(size);
+  }
+
+  const uint64_t estimation = std::max<uint64_t>(static_cast<uint64_t>(db_bytes) * sampled / sampled_bytes, sampled);
+  *size = static_cast<keys_limit_t>(std::min<uint64_t>(estimation, std::numeric_limits<keys_limit_t>::max()));
+  return common::Error();
+}
+
 common::Error DBConnection::FlushDBImpl() {
+  /* No bulk delete in UnQLite, at least write all of them in a single transaction */
+  common::Error err = CheckResultCommand(DB_FLUSHDB_COMMAND, unqlite_begin(connection_.handle_));
+  if (err) {
+    return err;
+  }
+
   unqlite_kv_cursor* cursor; /* Cursor handle */
-  common::Error err = CheckResultCommand(DB_FLUSHDB_COMMAND, unqlite_kv_cursor_init(connection_.handle_, &cursor));
+  err = CheckResultCommand(DB_FLUSHDB_COMMAND, unqlite_kv_cursor_init(connection_.handle_, &cursor));
   if (err) {
+    unqlite_rollback(connection_.handle_);
     return err;
   }
   /* Point to the first record */
@@ -519,8 +581,10 @@ common::Error DBConnection::FlushDBImpl() {
   while (unqlite_kv_cursor_valid_entry(cursor)) {
     raw_key_t key;
     unqlite_kv_cursor_key_callback(cursor, unqlite_data_callback_get_key, &key);
-    common::Error err = DelInner(key);
+    err = DelInner(key);
     if (err) {
+      unqlite_kv_cursor_release(connection_.handle_, cursor);
+      unqlite_rollback(connection_.handle_);
       return err;
     }
     /* Point to the next entry */
@@ -529,7 +593,7 @@ common::Error DBConnection::FlushDBImpl() {
 
   /* Finally, Release our cursor */
   unqlite_kv_cursor_release(connection_.handle_, cursor);
-  return common::Error();
+  return CheckResultCommand(DB_FLUSHDB_COMMAND, unqlite_commit(connection_.handle_));
 }
 
 common::Error DBConnection::SelectImpl(const db_name_t& name, IDataBaseInfo** info) {
@@ -538,7 +602,7 @@ common::Error DBConnection::SelectImpl(const db_name_t& name, IDataBaseInfo** in
   }
 
   keys_limit_t kcount = 0;
-  common::Error err = DBKeysCount(&kcount);
+  common::Error err = ApproximateDBKeysCount(&kcount);  // exact count walks the whole db
   DCHECK(!err) << err->GetDescription();
   *info = new DataBaseInfo(name, true, kcount);
   return common::Error();
@@ -71,6 +71,14 @@ void FastoObject::AddChildren(child_t child) {
   }
 }
 
+void FastoObject::TrimChildrens(size_t keep) {
+  if (childrens_.size() <= keep) {
+    return;
+  }
+
+  childrens_.erase(childrens_.begin(), childrens_.end() - keep);
+}
+
 FastoObject* FastoObject::GetParent() const {
   return parent_;
 }
@@ -18,20 +18,79 @@
 
 #include <fastonosql/core/icommand_translator.h>
 
+#include <string.h>
+
+#include <algorithm>
+
 #include <common/convert2string.h>
 #include <common/sprintf.h>
 
 namespace fastonosql {
 namespace core {
+namespace {
+
+const size_t kMaxCommandNameLength = 256;
+
+char FoldASCII(char c) {
+  return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+std::string_view MakeNameView(const command_buffer_t& name) {
+  return std::string_view(name.data(), name.size());
+}
+
+common::Error SplitCommandLine(const command_buffer_t& cmdstring, commands_args_t* argv) {
+  commands_args_t standart_argv;
+  if (!ParseCommandLine(cmdstring, &standart_argv)) {
+    return ICommandTranslator::InvalidInputArguments(cmdstring);
+  }
+
+  *argv = standart_argv;
+  return common::Error();
+}
+
+}  // namespace
 
-command_buffer_t GetKeysPattern(cursor_t cursor_in, const pattern_t& pattern, keys_limit_t count_keys) {
+command_buffer_t GetKeysPattern(const cursor_t& cursor_in, const pattern_t& pattern, keys_limit_t count_keys) {
   command_buffer_writer_t wr;
-  wr << DB_SCAN_COMMAND SPACE_STR << common::ConvertToBytes(cursor_in) << " MATCH " << pattern << " COUNT "
+  wr << DB_SCAN_COMMAND SPACE_STR << common::ConvertToBytes(cursor_in.GetPosition()) << " MATCH " << pattern << " COUNT "
      << common::ConvertToBytes(count_keys);
   return wr.str();
 }
 
-ICommandTranslator::ICommandTranslator(const std::vector<CommandHolder>& commands) : commands_(commands) {}
+size_t ICommandTranslator::CommandNameHash::operator()(std::string_view name) const {
+  uint64_t hash = 14695981039346656037ULL;  // fnv-1a over folded bytes
+  for (char c : name) {
+    hash ^= static_cast<unsigned char>(FoldASCII(c));
+    hash *= 1099511628211ULL;
+  }
+  return static_cast<size_t>(hash);
+}
+
+bool ICommandTranslator::CommandNameEqual::operator()(std::string_view lhs, std::string_view rhs) const {
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < lhs.size(); ++i) {
+    if (FoldASCII(lhs[i]) != FoldASCII(rhs[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+ICommandTranslator::ICommandTranslator(const std::vector<CommandHolder>& commands)
+    : commands_(commands), names_index_(), first_names_index_(), max_name_words_(0) {
+  for (size_t i = 0; i < commands_.size(); ++i) {
+    const std::string_view name = MakeNameView(commands_[i].name);
+    DCHECK(name.size() <= kMaxCommandNameLength) << "Command (" << name << ") name is too long.";
+    // keep the first holder for duplicated names, as the linear scan did
+    names_index_.emplace(name, i);
+    first_names_index_.emplace(name.substr(0, name.find(' ')), i);
+    max_name_words_ = std::max(max_name_words_, static_cast<size_t>(std::count(name.begin(), name.end(), ' ')) + 1);
+  }
+}
 
 ICommandTranslator::~ICommandTranslator() {}
 
@@ -149,6 +208,64 @@ common::Error ICommandTranslator::LoadKeyTTLCommand(const NKey& key, command_buf
   return LoadKeyTTLCommandImpl(key, cmdstring);
 }
 
+common::Error ICommandTranslator::CreateKeyCommand(const NDbKValue& key, commands_args_t* argv) const {
+  if (!argv) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  return CreateKeyCommandArgsImpl(key, argv);
+}
+
+common::Error ICommandTranslator::LoadKeyCommand(const NKey& key,
+                                                 common::Value::Type type,
+                                                 commands_args_t* argv) const {
+  if (!argv) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  return LoadKeyCommandArgsImpl(key, type, argv);
+}
+
+common::Error ICommandTranslator::DeleteKeyCommand(const NKey& key, commands_args_t* argv) const {
+  if (!argv) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  return DeleteKeyCommandArgsImpl(key, argv);
+}
+
+common::Error ICommandTranslator::RenameKeyCommand(const NKey& key,
+                                                   const trans_key_t& new_name,
+                                                   commands_args_t* argv) const {
+  if (!argv) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  return RenameKeyCommandArgsImpl(key, new_name, argv);
+}
+
+common::Error ICommandTranslator::ChangeKeyTTLCommand(const NKey& key, ttl_t ttl, commands_args_t* argv) const {
+  if (!argv) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  return ChangeKeyTTLCommandArgsImpl(key, ttl, argv);
+}
+
+common::Error ICommandTranslator::LoadKeyTTLCommand(const NKey& key, commands_args_t* argv) const {
+  if (!argv) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  return LoadKeyTTLCommandArgsImpl(key, argv);
+}
+
 bool ICommandTranslator::IsLoadKeyCommand(const command_buffer_t& cmd, command_buffer_t* key) const {
   if (!key) {
     DNOTREACHED();
@@ -189,6 +306,17 @@ common::Error ICommandTranslator::GetTypeCommand(const NKey& key, command_buffer
   return common::Error();
 }
 
+common::Error ICommandTranslator::GetTypeCommand(const NKey& key, commands_args_t* argv) const {
+  if (!argv) {
+    DNOTREACHED();
+    return common::make_error_inval();
+  }
+
+  const auto key_str = key.GetKey();
+  *argv = {GEN_CMD_STRING(DB_KEY_TYPE_COMMAND), key_str.GetData()};
+  return common::Error();
+}
+
 common::Error ICommandTranslator::PublishCommand(const trans_ps_channel_t& channel,
                                                  const std::string& message,
                                                  command_buffer_t* cmdstring) const {
@@ -253,12 +381,10 @@ common::Error ICommandTranslator::FindCommandFirstName(const command_buffer_t& c
     return common::make_error_inval();
   }
 
-  for (size_t i = 0; i < commands_.size(); ++i) {
-    const CommandHolder* cmd = &commands_[i];
-    if (cmd->IsEqualFirstName(command_first_name)) {
-      *info = cmd;
-      return common::Error();
-    }
+  const auto it = first_names_index_.find(MakeNameView(command_first_name));
+  if (it != first_names_index_.end()) {
+    *info = &commands_[it->second];
+    return common::Error();
   }
 
   return UnknownCommand(command_first_name);
@@ -289,27 +415,51 @@ common::Error ICommandTranslator::FindCommand(const command_buffer_t& command,
   return common::Error();
 }
 
-common::Error ICommandTranslator::FindCommand(commands_args_t argv, const CommandHolder** info, size_t* off) const {
+common::Error ICommandTranslator::FindCommand(const commands_args_t& argv,
+                                              const CommandHolder** info,
+                                              size_t* off) const {
   if (!info || argv.empty()) {
     return common::make_error_inval();
   }
 
-  for (size_t i = 0; i < commands_.size(); ++i) {
-    const CommandHolder* cmd = &commands_[i];
-    size_t loff = 0;
-    if (cmd->IsCommand(argv, &loff)) {
-      *info = cmd;
-      if (off) {
-        *off = loff;
-      }
-      return common::Error();
+  // join the leading words on the stack and probe every word count, earliest table entry wins
+  char name[kMaxCommandNameLength];
+  size_t name_len = 0;
+  size_t found = commands_.size();
+  size_t found_off = 0;
+  for (size_t i = 0; i < argv.size() && i < max_name_words_; ++i) {
+    const command_buffer_t& word = argv[i];
+    const size_t sep = i == 0 ? 0 : 1;
+    if (name_len + sep + word.size() > kMaxCommandNameLength || memchr(word.data(), ' ', word.size())) {
+      break;
+    }
+
+    if (sep) {
+      name[name_len++] = ' ';
+    }
+    memcpy(name + name_len, word.data(), word.size());
+    name_len += word.size();
+
+    const auto it = names_index_.find(std::string_view(name, name_len));
+    if (it != names_index_.end() && it->second < found) {
+      found = it->second;
+      found_off = i + 1;
     }
   }
 
-  return UnknownSequence(argv);
+  if (found == commands_.size()) {
+    return UnknownSequence(argv);
+  }
+
+  *info = &commands_[found];
+  if (off) {
+    *off = found_off;
+  }
+  return common::Error();
 }
 
-common::Error ICommandTranslator::TestCommandArgs(const CommandHolder* cmd, commands_args_t argv) const {
+common::Error ICommandTranslator::TestCommandArgs(const CommandHolder* cmd,
+                                                  const command_args_views_t& argv) const {
   if (!cmd) {
     DNOTREACHED();
     return common::make_error_inval();
@@ -339,7 +489,7 @@ common::Error ICommandTranslator::TestCommandLine(const command_buffer_t& cmd) c
   return common::Error();
 }
 
-common::Error ICommandTranslator::TestCommandLineArgs(commands_args_t argv,
+common::Error ICommandTranslator::TestCommandLineArgs(const commands_args_t& argv,
                                                       const CommandHolder** info,
                                                       size_t* off) const {
   const CommandHolder* cmd = nullptr;
@@ -349,9 +499,10 @@ common::Error ICommandTranslator::TestCommandLineArgs(commands_args_t argv,
     return err;
   }
 
-  commands_args_t stabled;
+  command_args_views_t stabled;
+  stabled.reserve(argv.size() - loff);
   for (size_t i = loff; i < argv.size(); ++i) {
-    stabled.push_back(argv[i]);
+    stabled.push_back(command_arg_view_t(argv[i].data(), argv[i].size()));
   }
 
   err = TestCommandArgs(cmd, stabled);
@@ -364,5 +515,71 @@ common::Error ICommandTranslator::TestCommandLineArgs(commands_args_t argv,
   return common::Error();
 }
 
+common::Error ICommandTranslator::CreateKeyCommandArgsImpl(const NDbKValue& key, commands_args_t* argv) const {
+  command_buffer_t cmdstring;
+  common::Error err = CreateKeyCommandImpl(key, &cmdstring);
+  if (err) {
+    return err;
+  }
+
+  return SplitCommandLine(cmdstring, argv);
+}
+
+common::Error ICommandTranslator::LoadKeyCommandArgsImpl(const NKey& key,
+                                                         common::Value::Type type,
+                                                         commands_args_t* argv) const {
+  command_buffer_t cmdstring;
+  common::Error err = LoadKeyCommandImpl(key, type, &cmdstring);
+  if (err) {
+    return err;
+  }
+
+  return SplitCommandLine(cmdstring, argv);
+}
+
+common::Error ICommandTranslator::DeleteKeyCommandArgsImpl(const NKey& key, commands_args_t* argv) const {
+  command_buffer_t cmdstring;
+  common::Error err = DeleteKeyCommandImpl(key, &cmdstring);
+  if (err) {
+    return err;
+  }
+
+  return SplitCommandLine(cmdstring, argv);
+}
+
+common::Error ICommandTranslator::RenameKeyCommandArgsImpl(const NKey& key,
+                                                           const trans_key_t& new_name,
+                                                           commands_args_t* argv) const {
+  command_buffer_t cmdstring;
+  common::Error err = RenameKeyCommandImpl(key, new_name, &cmdstring);
+  if (err) {
+    return err;
+  }
+
+  return SplitCommandLine(cmdstring, argv);
+}
+
+common::Error ICommandTranslator::ChangeKeyTTLCommandArgsImpl(const NKey& key,
+                                                              ttl_t ttl,
+                                                              commands_args_t* argv) const {
+  command_buffer_t cmdstring;
+  common::Error err = ChangeKeyTTLCommandImpl(key, ttl, &cmdstring);
+  if (err) {
+    return err;
+  }
+
+  return SplitCommandLine(cmdstring, argv);
+}
+
+common::Error ICommandTranslator::LoadKeyTTLCommandArgsImpl(const NKey& key, commands_args_t* argv) const {
+  command_buffer_t cmdstring;
+  common::Error err = LoadKeyTTLCommandImpl(key, &cmdstring);
+  if (err) {
+    return err;
+  }
+
+  return SplitCommandLine(cmdstring, argv);
+}
+
 }  // namespace core
 }  // namespace fastonosql
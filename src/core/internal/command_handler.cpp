@@ -18,6 +18,8 @@
 
 #include <fastonosql/core/internal/command_handler.h>
 
+#include <utility>
+
 #include <fastonosql/core/command_holder.h>
 
 namespace fastonosql {
@@ -32,7 +34,7 @@ common::Error CommandHandler::Execute(const command_buffer_t& command, FastoObje
     return common::make_error_inval();
   }
 
-  return Execute(standart_argv, out);
+  return Execute(std::move(standart_argv), out);
 }
 
 common::Error CommandHandler::Execute(commands_args_t argv, FastoObject* out) {
@@ -43,11 +45,9 @@ common::Error CommandHandler::Execute(commands_args_t argv, FastoObject* out) {
     return err;
   }
 
-  commands_args_t stabled;
-  for (size_t i = off; i < argv.size(); ++i) {
-    stabled.push_back(argv[i]);
-  }
-  return cmd->func_(this, stabled, out);
+  // drop the command name in place, the arguments are handed over without copying
+  argv.erase(argv.begin(), argv.begin() + off);
+  return cmd->func_(this, std::move(argv), out);
 }
 
 }  // namespace internal
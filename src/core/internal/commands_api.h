@@ -21,6 +21,7 @@
 #include <string>
 
 #include <common/convert2string.h>
+#include <common/string_util.h>
 
 #include <fastonosql/core/cdb_connection.h>
 #include <fastonosql/core/global.h>
@@ -38,6 +39,7 @@ struct ApiTraits {
 
   static common::Error Scan(CommandHandler* handler, commands_args_t argv, FastoObject* out);         // complex array
   static common::Error Keys(CommandHandler* handler, commands_args_t argv, FastoObject* out);         // array of keys
+  static common::Error ReverseKeys(CommandHandler* handler, commands_args_t argv, FastoObject* out);  // array of keys
   static common::Error DBKeysCount(CommandHandler* handler, commands_args_t argv, FastoObject* out);  // keys_limit_t
   static common::Error CreateDatabase(CommandHandler* handler,
                                       commands_args_t argv,
@@ -98,18 +100,18 @@ common::Error ApiTraits<CDBConnection>::Scan(internal::CommandHandler* handler,
                                              commands_args_t argv,
                                              FastoObject* out) {
   cursor_t cursor_in;
-  if (!common::ConvertFromBytes(argv[0], &cursor_in)) {
+  if (!cursor_t::FromString(argv[0], &cursor_in)) {
     return common::make_error_inval();
   }
 
   const size_t argc = argv.size();
   const pattern_t pattern = argc >= 3 ? argv[2].as_string() : ALL_KEYS_PATTERNS;
-  cursor_t count_keys = NO_KEYS_LIMIT;
+  keys_limit_t count_keys = NO_KEYS_LIMIT;
   if (argc >= 5 && !common::ConvertFromBytes(argv[4], &count_keys)) {
     return common::make_error_inval();
   }
 
-  cursor_t cursor_out = 0;
+  cursor_t cursor_out;
   raw_keys_t keys_out;
   CDBConnection* cdb = static_cast<CDBConnection*>(handler);
 
@@ -125,7 +127,7 @@ common::Error ApiTraits<CDBConnection>::Scan(internal::CommandHandler* handler,
   }
 
   common::ArrayValue* mar = common::Value::CreateArrayValue();
-  common::FundamentalValue* val = common::Value::CreateUInteger32Value(cursor_out);
+  common::StringValue* val = common::Value::CreateStringValue(cursor_out.ToString());
   mar->Append(val);
   mar->Append(ar);
 
@@ -162,15 +164,47 @@ common::Error ApiTraits<CDBConnection>::Keys(internal::CommandHandler* handler,
 }
 
 template <class CDBConnection>
-common::Error ApiTraits<CDBConnection>::DBKeysCount(internal::CommandHandler* handler,
+common::Error ApiTraits<CDBConnection>::ReverseKeys(internal::CommandHandler* handler,
                                                     commands_args_t argv,
                                                     FastoObject* out) {
-  UNUSED(argv);
+  CDBConnection* cdb = static_cast<CDBConnection*>(handler);
+
+  keys_limit_t limit;
+  if (!common::ConvertFromBytes(argv[2], &limit)) {
+    return common::make_error_inval();
+  }
 
+  raw_keys_t keysout;
+  common::Error err = cdb->ReverseKeys(argv[0], argv[1], limit, &keysout);
+  if (err) {
+    return err;
+  }
+
+  common::ArrayValue* ar = common::Value::CreateArrayValue();
+  for (size_t i = 0; i < keysout.size(); ++i) {
+    common::StringValue* val = common::Value::CreateStringValue(keysout[i]);
+    ar->Append(val);
+  }
+  FastoObject* child = new FastoObject(out, ar, cdb->GetDelimiter());
+  out->AddChildren(child);
+  return common::Error();
+}
+
+template <class CDBConnection>
+common::Error ApiTraits<CDBConnection>::DBKeysCount(internal::CommandHandler* handler,
+                                                    commands_args_t argv,
+                                                    FastoObject* out) {
   CDBConnection* cdb = static_cast<CDBConnection*>(handler);
 
   keys_limit_t dbkcount = 0;
-  common::Error err = cdb->DBKeysCount(&dbkcount);
+  common::Error err;
+  if (argv.empty()) {
+    err = cdb->DBKeysCount(&dbkcount);
+  } else if (common::FullEqualsASCII(argv[0], GEN_CMD_STRING(DB_DBKCOUNT_APPROX_ARG), false)) {
+    err = cdb->ApproximateDBKeysCount(&dbkcount);
+  } else {
+    return common::make_error_inval();
+  }
   if (err) {
     return err;
   }
@@ -462,7 +496,7 @@ template <class CDBConnection>
 common::Error ApiTraits<CDBConnection>::JsonDump(CommandHandler* handler, commands_args_t argv, FastoObject* out) {
   cursor_t cursor_in;
   const size_t argc = argv.size();
-  if (argc < 3 || !common::ConvertFromBytes(argv[0], &cursor_in)) {
+  if (argc < 3 || !cursor_t::FromString(argv[0], &cursor_in)) {
     return common::make_error_inval();
   }
 
@@ -474,19 +508,19 @@ common::Error ApiTraits<CDBConnection>::JsonDump(CommandHandler* handler, comman
   common::file_system::ascii_file_string_path path(json_path);
 
   const pattern_t pattern = argc >= 5 ? argv[4].as_string() : ALL_KEYS_PATTERNS;
-  cursor_t count_keys = NO_KEYS_LIMIT;
+  keys_limit_t count_keys = NO_KEYS_LIMIT;
   if (argc == 7 && !common::ConvertFromBytes(argv[6], &count_keys)) {
     return common::make_error_inval();
   }
 
-  cursor_t cursor_out = 0;
+  cursor_t cursor_out;
   CDBConnection* cdb = static_cast<CDBConnection*>(handler);
   common::Error err = cdb->JsonDump(cursor_in, pattern, count_keys, path, &cursor_out);
   if (err) {
     return err;
   }
 
-  common::FundamentalValue* val = common::Value::CreateUInteger32Value(cursor_out);
+  common::StringValue* val = common::Value::CreateStringValue(cursor_out.ToString());
   FastoObject* child = new FastoObject(out, val, cdb->GetDelimiter());
   out->AddChildren(child);
   return common::Error();
@@ -496,7 +530,7 @@ template <class CDBConnection>
 common::Error ApiTraits<CDBConnection>::CsvDump(CommandHandler* handler, commands_args_t argv, FastoObject* out) {
   cursor_t cursor_in;
   const size_t argc = argv.size();
-  if (argc < 3 || !common::ConvertFromBytes(argv[0], &cursor_in)) {
+  if (argc < 3 || !cursor_t::FromString(argv[0], &cursor_in)) {
     return common::make_error_inval();
   }
 
@@ -508,19 +542,19 @@ common::Error ApiTraits<CDBConnection>::CsvDump(CommandHandler* handler, command
   common::file_system::ascii_file_string_path path(json_path);
 
   const pattern_t pattern = argc >= 5 ? argv[4].as_string() : ALL_KEYS_PATTERNS;
-  cursor_t count_keys = NO_KEYS_LIMIT;
+  keys_limit_t count_keys = NO_KEYS_LIMIT;
   if (argc == 7 && !common::ConvertFromBytes(argv[6], &count_keys)) {
     return common::make_error_inval();
   }
 
-  cursor_t cursor_out = 0;
+  cursor_t cursor_out;
   CDBConnection* cdb = static_cast<CDBConnection*>(handler);
   common::Error err = cdb->CsvDump(cursor_in, pattern, count_keys, path, &cursor_out);
   if (err) {
     return err;
   }
 
-  common::FundamentalValue* val = common::Value::CreateUInteger32Value(cursor_out);
+  common::StringValue* val = common::Value::CreateStringValue(cursor_out.ToString());
   FastoObject* child = new FastoObject(out, val, cdb->GetDelimiter());
   out->AddChildren(child);
   return common::Error();
@@ -18,7 +18,15 @@
 
 #include <fastonosql/core/types.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 #include <algorithm>
+#include <utility>
 
 #include <common/string_util.h>
 
@@ -29,24 +37,186 @@
 namespace fastonosql {
 namespace core {
 
+namespace {
+
+// characters the state machine has to look at, everything else is copied as is
+inline bool IsSpecialChar(command_buffer_char_t ch) {
+  return ch == ' ' || ch == SINGLE_QUOTES_CHAR || ch == DOUBLE_QUOTES_CHAR || ch == '\\' || ch == JSON_START_CHAR ||
+         ch == JSON_END_CHAR || ch == JSON_START_ARRAY_CHAR || ch == JSON_END_ARRAY_CHAR;
+}
+
+#if defined(__SSE2__)
+inline int SpecialCharsMask(__m128i chunk) {
+  // '[' ']' '{' '}' differ only by 0x20, fold them with one or
+  const __m128i folded = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+  __m128i hits = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '));
+  hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(SINGLE_QUOTES_CHAR)));
+  hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(DOUBLE_QUOTES_CHAR)));
+  hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')));
+  hits = _mm_or_si128(hits, _mm_cmpeq_epi8(folded, _mm_set1_epi8(JSON_START_CHAR)));
+  hits = _mm_or_si128(hits, _mm_cmpeq_epi8(folded, _mm_set1_epi8(JSON_END_CHAR)));
+  return _mm_movemask_epi8(hits);
+}
+#endif
+
+#if defined(__AVX2__)
+inline uint32_t SpecialCharsMask(__m256i chunk) {
+  const __m256i folded = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+  __m256i hits = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' '));
+  hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(SINGLE_QUOTES_CHAR)));
+  hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(DOUBLE_QUOTES_CHAR)));
+  hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\')));
+  hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(folded, _mm256_set1_epi8(JSON_START_CHAR)));
+  hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(folded, _mm256_set1_epi8(JSON_END_CHAR)));
+  return static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+}
+#endif
+
+// position of the first special char in [pos, size), size if none
+size_t FindSpecialChar(const command_buffer_char_t* data, size_t pos, size_t size) {
+#if defined(__AVX2__)
+  for (; pos + 32 <= size; pos += 32) {
+    const uint32_t mask = SpecialCharsMask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos)));
+    if (mask) {
+      return pos + __builtin_ctz(mask);
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  for (; pos + 16 <= size; pos += 16) {
+    const int mask = SpecialCharsMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos)));
+    if (mask) {
+      return pos + __builtin_ctz(mask);
+    }
+  }
+#endif
+  for (; pos < size; ++pos) {
+    if (IsSpecialChar(data[pos])) {
+      return pos;
+    }
+  }
+  return size;
+}
+
+// argument being built, stays a range of the command line until an escape or a quote splits it
+class ArgBuilder {
+ public:
+  explicit ArgBuilder(const command_buffer_t& command_line)
+      : command_line_(command_line), begin_(0), size_(0), owned_(false), buffer_() {}
+
+  bool IsEmpty() const { return size_ == 0; }
+
+  void AppendAt(size_t pos) {
+    if (!owned_) {
+      if (size_ == 0) {
+        begin_ = pos;
+        size_ = 1;
+        return;
+      }
+
+      if (begin_ + size_ == pos) {
+        size_++;
+        return;
+      }
+
+      MakeOwned();
+    }
+
+    buffer_.push_back(command_line_[pos]);
+    size_++;
+  }
+
+  void AppendRange(size_t pos, size_t count) {
+    if (count == 0) {
+      return;
+    }
+
+    if (!owned_ && (size_ == 0 || begin_ + size_ == pos)) {
+      if (size_ == 0) {
+        begin_ = pos;
+      }
+      size_ += count;
+      return;
+    }
+
+    if (!owned_) {
+      MakeOwned();
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+      buffer_.push_back(command_line_[pos + i]);
+    }
+    size_ += count;
+  }
+
+  void AppendChar(command_buffer_char_t ch) {
+    if (!owned_) {
+      MakeOwned();
+    }
+
+    buffer_.push_back(ch);
+    size_++;
+  }
+
+  void Flush(command_args_views_t* out, commands_args_t* unescaped) {
+    if (owned_) {
+      unescaped->push_back(std::move(buffer_));
+      const command_buffer_t& arg = unescaped->back();
+      out->push_back(command_arg_view_t(arg.data(), arg.size()));
+    } else {
+      out->push_back(command_arg_view_t(command_line_.data() + begin_, size_));
+    }
+
+    begin_ = 0;
+    size_ = 0;
+    owned_ = false;
+    buffer_ = command_buffer_t();
+  }
+
+ private:
+  void MakeOwned() {
+    buffer_ = GEN_CMD_STRING_SIZE(command_line_.data() + begin_, size_);
+    owned_ = true;
+  }
+
+  const command_buffer_t& command_line_;
+  size_t begin_;
+  size_t size_;
+  bool owned_;
+  command_buffer_t buffer_;
+};
+
+}  // namespace
+
 // CARRIGE_RETURN_CHAR
-bool ParseCommandLine(const command_buffer_t& command_line, commands_args_t* out) {
-  if (command_line.empty() || !out) {
+bool ParseCommandLine(const command_buffer_t& command_line, command_args_views_t* out, commands_args_t* unescaped) {
+  if (command_line.empty() || !out || !unescaped) {
     return false;
   }
 
-  commands_args_t result;
-  command_buffer_t current_string;
+  command_args_views_t result;
+  commands_args_t owned;
+  ArgBuilder current_string(command_line);
   size_t in_single_quotes = 0;
   size_t in_double_quotes = 0;
   size_t in_json = 0;
   size_t in_json_array = 0;
 
   for (size_t i = 0; i < command_line.size(); ++i) {
+    // plain bytes inside an argument or quotes never change the state, take the whole run at once
+    if (!current_string.IsEmpty() || in_single_quotes || in_double_quotes) {
+      const size_t special = FindSpecialChar(command_line.data(), i, command_line.size());
+      current_string.AppendRange(i, special - i);
+      i = special;
+      if (i == command_line.size()) {
+        break;
+      }
+    }
+
     command_buffer_char_t ch = command_line[i];
     const bool is_last = command_line.size() - 1 == i;
 
-    if (current_string.empty() && !in_double_quotes && !in_single_quotes) {
+    if (current_string.IsEmpty() && !in_double_quotes && !in_single_quotes) {
       in_single_quotes = 0;
       in_double_quotes = 0;
       in_json = 0;
@@ -67,7 +237,7 @@ bool ParseCommandLine(const command_buffer_t& command_line, commands_args_t* out
 
     if (in_single_quotes) {
       if (ch == '\\' && !is_last && command_line[i + 1] == SINGLE_QUOTES_CHAR) {
-        current_string += command_line[i + 1];
+        current_string.AppendAt(i + 1);
         ++i;
         continue;
       }
@@ -79,7 +249,7 @@ bool ParseCommandLine(const command_buffer_t& command_line, commands_args_t* out
           char ch = command_line[i + 2];
           char ch2 = command_line[i + 3];
           unsigned char total = common::HexDigitToInt(ch) * 16 + common::HexDigitToInt(ch2);
-          current_string.push_back(total);
+          current_string.AppendChar(total);
           i += 3;
           continue;
         }
@@ -87,15 +257,14 @@ bool ParseCommandLine(const command_buffer_t& command_line, commands_args_t* out
 
       // common cases
       if (ch == SINGLE_QUOTES_CHAR) {
-        result.push_back(current_string);
-        current_string.clear();
+        current_string.Flush(&result, &owned);
         in_single_quotes--;
         continue;
       }
-      current_string += ch;
+      current_string.AppendAt(i);
     } else if (in_double_quotes) {
       if (ch == '\\' && !is_last && command_line[i + 1] == DOUBLE_QUOTES_CHAR) {
-        current_string += command_line[i + 1];
+        current_string.AppendAt(i + 1);
         ++i;
         continue;
       }
@@ -107,7 +276,7 @@ bool ParseCommandLine(const command_buffer_t& command_line, commands_args_t* out
           char ch = command_line[i + 2];
           char ch2 = command_line[i + 3];
           unsigned char total = common::HexDigitToInt(ch) * 16 + common::HexDigitToInt(ch2);
-          current_string += total;
+          current_string.AppendChar(total);
           i += 3;
           continue;
         }
@@ -115,16 +284,15 @@ bool ParseCommandLine(const command_buffer_t& command_line, commands_args_t* out
 
       // common cases
       if (ch == DOUBLE_QUOTES_CHAR) {
-        result.push_back(current_string);
-        current_string.clear();
+        current_string.Flush(&result, &owned);
         in_double_quotes--;
         continue;
       }
-      current_string += ch;
+      current_string.AppendAt(i);
     } else if (in_json) {
-      current_string += ch;
+      current_string.AppendAt(i);
       if (ch == '\\' && !is_last && (command_line[i + 1] == JSON_START_CHAR || command_line[i + 1] == JSON_END_CHAR)) {
-        current_string += command_line[i + 1];
+        current_string.AppendAt(i + 1);
         ++i;
         continue;
       }
@@ -134,17 +302,16 @@ bool ParseCommandLine(const command_buffer_t& command_line, commands_args_t* out
         in_json++;
       } else if (ch == JSON_END_CHAR) {
         if (in_json == 1) {
-          result.push_back(current_string);
-          current_string.clear();
+          current_string.Flush(&result, &owned);
         }
         in_json--;
         continue;
       }
     } else if (in_json_array) {
-      current_string += ch;
+      current_string.AppendAt(i);
       if (ch == '\\' && !is_last &&
           (command_line[i + 1] == JSON_START_ARRAY_CHAR || command_line[i + 1] == JSON_END_ARRAY_CHAR)) {
-        current_string += command_line[i + 1];
+        current_string.AppendAt(i + 1);
         ++i;
         continue;
       }
@@ -154,41 +321,60 @@ bool ParseCommandLine(const command_buffer_t& command_line, commands_args_t* out
         in_json_array++;
       } else if (ch == JSON_END_ARRAY_CHAR) {
         if (in_json_array == 1) {
-          result.push_back(current_string);
-          current_string.clear();
+          current_string.Flush(&result, &owned);
         }
         in_json_array--;
         continue;
       }
     } else {
       if (ch == ' ') {
-        result.push_back(current_string);
-        current_string.clear();
+        current_string.Flush(&result, &owned);
       } else if (ch == SINGLE_QUOTES_CHAR) {
         in_single_quotes = 1;  // skip symbol
       } else if (ch == DOUBLE_QUOTES_CHAR) {
         in_double_quotes = 1;  // skip symbol
       } else if (ch == JSON_START_CHAR) {
         in_json = 1;
-        current_string += ch;
+        current_string.AppendAt(i);
       } else if (ch == JSON_START_ARRAY_CHAR) {
         in_json_array = 1;
-        current_string += ch;
+        current_string.AppendAt(i);
       } else {
-        current_string += ch;
+        current_string.AppendAt(i);
       }
     }
   }
 
-  if (!current_string.empty()) {
-    result.push_back(current_string);
+  if (!current_string.IsEmpty()) {
+    current_string.Flush(&result, &owned);
   }
 
   if (in_single_quotes || in_double_quotes || in_json) {
     return false;
   }
 
-  *out = result;
+  out->swap(result);
+  unescaped->swap(owned);
+  return true;
+}
+
+bool ParseCommandLine(const command_buffer_t& command_line, commands_args_t* out) {
+  if (!out) {
+    return false;
+  }
+
+  command_args_views_t views;
+  commands_args_t unescaped;
+  if (!ParseCommandLine(command_line, &views, &unescaped)) {
+    return false;
+  }
+
+  commands_args_t result;
+  for (const command_arg_view_t& view : views) {
+    result.push_back(GEN_CMD_STRING_SIZE(view.data(), view.size()));
+  }
+
+  out->swap(result);
   return true;
 }
 
@@ -0,0 +1,222 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#if defined(BUILD_WITH_REDIS) && !defined(_WIN32)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+extern "C" {
+#include <hiredis/hiredis.h>
+}
+
+#include <fastonosql/core/db/redis/command_translator.h>
+#include <fastonosql/core/db/redis_compatible/async_connection.h>
+
+namespace {
+// a fake server driven from the test thread between loop iterations
+class FakeServer {
+ public:
+  FakeServer() : listen_fd_(socket(AF_INET, SOCK_STREAM, 0)), client_fd_(-1), port_(0) {
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    CHECK(bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    CHECK(listen(listen_fd_, 1) == 0);
+    socklen_t len = sizeof(addr);
+    CHECK(getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) == 0);
+    port_ = ntohs(addr.sin_port);
+  }
+
+  ~FakeServer() {
+    CloseClient();
+    close(listen_fd_);
+  }
+
+  uint16_t GetPort() const { return port_; }
+
+  void Accept() { client_fd_ = accept(listen_fd_, nullptr, nullptr); }
+
+  // appends what the client wrote so far, never blocks
+  size_t Read() {
+    char buff[1024];
+    ssize_t nread = 0;
+    while ((nread = recv(client_fd_, buff, sizeof(buff), MSG_DONTWAIT)) > 0) {
+      received_.append(buff, nread);
+    }
+    return received_.size();
+  }
+
+  std::string TakeReceived() {
+    std::string received;
+    received.swap(received_);
+    return received;
+  }
+
+  void Write(const std::string& data) {
+    ASSERT_EQ(static_cast<size_t>(send(client_fd_, data.data(), data.size(), 0)), data.size());
+  }
+
+  void CloseClient() {
+    if (client_fd_ != -1) {
+      close(client_fd_);
+      client_fd_ = -1;
+    }
+  }
+
+ private:
+  const int listen_fd_;
+  int client_fd_;
+  uint16_t port_;
+  std::string received_;
+};
+
+template <typename Pred>
+bool RunUntil(fastonosql::core::redis_compatible::AsyncEventLoop* loop, Pred done) {
+  for (size_t i = 0; i < 50 && !done(); ++i) {
+    loop->RunOnce(100);
+  }
+  return done();
+}
+
+std::shared_ptr<fastonosql::core::redis_compatible::CommandTranslator> MakeTranslator() {
+  return std::make_shared<fastonosql::core::redis::CommandTranslator>(std::vector<fastonosql::core::CommandHolder>());
+}
+
+fastonosql::core::redis_compatible::Config MakeConfig(uint16_t port) {
+  return fastonosql::core::redis_compatible::Config(common::net::HostAndPort("127.0.0.1", port));
+}
+
+const char kPing[] = "*1\r\n$4\r\nPING\r\n";
+const char kGet[] = "*2\r\n$3\r\nGET\r\n$3\r\nkey\r\n";
+}  // namespace
+
+TEST(AsyncConnection, ConnectAndReplies) {
+  FakeServer server;
+  fastonosql::core::redis_compatible::AsyncEventLoop loop;
+  fastonosql::core::redis_compatible::AsyncConnection connection(&loop, MakeTranslator());
+
+  bool connected = false;
+  common::Error connect_err;
+  ASSERT_FALSE(connection.Connect(MakeConfig(server.GetPort()), [&](common::Error err) {
+    connected = true;
+    connect_err = err;
+  }));
+  server.Accept();
+
+  // nothing to set up, on_connected waits for the PING
+  ASSERT_TRUE(RunUntil(&loop, [&]() { return server.Read() >= strlen(kPing); }));
+  ASSERT_EQ(server.TakeReceived(), kPing);
+  ASSERT_FALSE(connected);
+  server.Write("+PONG\r\n");
+  ASSERT_TRUE(RunUntil(&loop, [&]() { return connected; }));
+  ASSERT_FALSE(connect_err);
+  ASSERT_TRUE(connection.IsConnected());
+
+  // replies are dispatched in the order the commands were sent
+  std::string value;
+  common::Error value_err;
+  size_t replies = 0;
+  const fastonosql::core::commands_args_t get_cmd = {GEN_CMD_STRING("GET"), GEN_CMD_STRING("key")};
+  ASSERT_FALSE(connection.ExecCommand(get_cmd, [&](common::Error err, redisReply* reply) {
+    replies++;
+    ASSERT_FALSE(err);
+    ASSERT_EQ(reply->type, REDIS_REPLY_STRING);
+    value.assign(reply->str, reply->len);
+  }));
+  ASSERT_FALSE(connection.ExecCommand(get_cmd, [&](common::Error err, redisReply* reply) {
+    replies++;
+    value_err = err;
+    ASSERT_TRUE(reply);
+    ASSERT_EQ(reply->type, REDIS_REPLY_ERROR);
+  }));
+  ASSERT_TRUE(RunUntil(&loop, [&]() { return server.Read() >= 2 * strlen(kGet); }));
+  ASSERT_EQ(server.TakeReceived(), std::string(kGet) + kGet);
+
+  server.Write("$5\r\nvalue\r\n-WRONGTYPE Operation against a key holding the wrong kind of value\r\n");
+  ASSERT_TRUE(RunUntil(&loop, [&]() { return replies == 2; }));
+  ASSERT_EQ(value, "value");
+  ASSERT_TRUE(value_err);
+  ASSERT_EQ(value_err->GetDescription(), "WRONGTYPE Operation against a key holding the wrong kind of value");
+}
+
+TEST(AsyncConnection, DisconnectFailsPending) {
+  FakeServer server;
+  fastonosql::core::redis_compatible::AsyncEventLoop loop;
+  fastonosql::core::redis_compatible::AsyncConnection connection(&loop, MakeTranslator());
+
+  bool connected = false;
+  ASSERT_FALSE(connection.Connect(MakeConfig(server.GetPort()), [&](common::Error err) {
+    connected = !err;
+  }));
+  server.Accept();
+  ASSERT_TRUE(RunUntil(&loop, [&]() { return server.Read() >= strlen(kPing); }));
+  server.TakeReceived();
+  server.Write("+PONG\r\n");
+  ASSERT_TRUE(RunUntil(&loop, [&]() { return connected; }));
+
+  // the server goes away with a command in flight
+  bool called = false;
+  common::Error pending_err;
+  ASSERT_FALSE(connection.ExecCommand({GEN_CMD_STRING("GET"), GEN_CMD_STRING("key")},
+                                      [&](common::Error err, redisReply* reply) {
+                                        called = true;
+                                        pending_err = err;
+                                        ASSERT_FALSE(reply);
+                                      }));
+  ASSERT_TRUE(RunUntil(&loop, [&]() { return server.Read() >= strlen(kGet); }));
+  server.CloseClient();
+
+  ASSERT_TRUE(RunUntil(&loop, [&]() { return called; }));
+  ASSERT_TRUE(pending_err);
+  ASSERT_FALSE(connection.IsConnected());
+  ASSERT_TRUE(connection.ExecCommand({GEN_CMD_STRING("PING")}, [](common::Error, redisReply*) {}));
+}
+
+TEST(AsyncConnection, ConnectRefused) {
+  uint16_t port = 0;
+  {
+    FakeServer closed;  // a port nobody listens on once it is destroyed
+    port = closed.GetPort();
+  }
+
+  fastonosql::core::redis_compatible::AsyncEventLoop loop;
+  fastonosql::core::redis_compatible::AsyncConnection connection(&loop, MakeTranslator());
+
+  bool called = false;
+  common::Error connect_err;
+  common::Error err = connection.Connect(MakeConfig(port), [&](common::Error lerr) {
+    called = true;
+    connect_err = lerr;
+  });
+  if (err) {  // refused synchronously
+    return;
+  }
+
+  ASSERT_TRUE(RunUntil(&loop, [&]() { return called; }));
+  ASSERT_TRUE(connect_err);
+  ASSERT_FALSE(connection.IsConnected());
+}
+#endif
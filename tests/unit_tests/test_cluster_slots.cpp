@@ -0,0 +1,102 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#ifdef BUILD_WITH_REDIS
+#include <string.h>
+
+#include <fastonosql/core/db/redis_compatible/cluster_router.h>
+
+namespace {
+uint16_t Slot(const char* key) {
+  return fastonosql::core::redis_compatible::KeyHashSlot(key, strlen(key));
+}
+}  // namespace
+
+TEST(ClusterSlots, Crc16) {
+  const char* check = "123456789";
+  ASSERT_EQ(fastonosql::core::redis_compatible::Crc16(check, strlen(check)), 0x31C3);
+}
+
+TEST(ClusterSlots, KeyHashSlot) {
+  ASSERT_EQ(Slot("foo"), 12182);
+  ASSERT_EQ(Slot("bar"), 5061);
+  ASSERT_EQ(Slot("hello"), 866);
+
+  ASSERT_EQ(Slot("{user1000}.following"), Slot("{user1000}.followers"));
+  ASSERT_EQ(Slot("{user1000}.following"), Slot("user1000"));
+  ASSERT_EQ(Slot("foo{}{bar}"), fastonosql::core::redis_compatible::Crc16("foo{}{bar}", 10) & 16383);
+  ASSERT_EQ(Slot("foo{{bar}}zap"), Slot("{bar"));
+  ASSERT_EQ(Slot("foo{bar}{zap}"), Slot("bar"));
+}
+
+TEST(ClusterSlots, KeyArgIndex) {
+  using fastonosql::core::commands_args_t;
+  using fastonosql::core::redis_compatible::KeyArgIndex;
+
+  ASSERT_EQ(KeyArgIndex(commands_args_t{GEN_CMD_STRING("GET"), GEN_CMD_STRING("key")}), 1);
+  ASSERT_EQ(KeyArgIndex(commands_args_t{GEN_CMD_STRING("info"), GEN_CMD_STRING("keyspace")}), 0);
+  ASSERT_EQ(KeyArgIndex(commands_args_t{GEN_CMD_STRING("SCAN"), GEN_CMD_STRING("0")}), 0);
+  ASSERT_EQ(KeyArgIndex(commands_args_t{GEN_CMD_STRING("EVALSHA"), GEN_CMD_STRING("sha"), GEN_CMD_STRING("1"),
+                                        GEN_CMD_STRING("key")}),
+            3);
+  ASSERT_EQ(KeyArgIndex(commands_args_t{GEN_CMD_STRING("EVAL"), GEN_CMD_STRING("return 1"), GEN_CMD_STRING("0")}), 0);
+  ASSERT_EQ(KeyArgIndex(commands_args_t{GEN_CMD_STRING("OBJECT"), GEN_CMD_STRING("ENCODING"), GEN_CMD_STRING("key")}),
+            2);
+  ASSERT_EQ(KeyArgIndex(commands_args_t{GEN_CMD_STRING("XREAD"), GEN_CMD_STRING("COUNT"), GEN_CMD_STRING("2"),
+                                        GEN_CMD_STRING("STREAMS"), GEN_CMD_STRING("stream"), GEN_CMD_STRING("0")}),
+            4);
+}
+
+TEST(ClusterSlots, IsReadOnlyCommand) {
+  using fastonosql::core::commands_args_t;
+  using fastonosql::core::redis_compatible::IsReadOnlyCommand;
+
+  ASSERT_TRUE(IsReadOnlyCommand(commands_args_t{GEN_CMD_STRING("get"), GEN_CMD_STRING("key")}));
+  ASSERT_TRUE(IsReadOnlyCommand(commands_args_t{GEN_CMD_STRING("TYPE"), GEN_CMD_STRING("key")}));
+  ASSERT_FALSE(IsReadOnlyCommand(commands_args_t{GEN_CMD_STRING("SET"), GEN_CMD_STRING("key"), GEN_CMD_STRING("1")}));
+  ASSERT_FALSE(IsReadOnlyCommand(commands_args_t{GEN_CMD_STRING("EVALSHA"), GEN_CMD_STRING("sha")}));
+  ASSERT_FALSE(IsReadOnlyCommand(commands_args_t()));
+}
+
+TEST(ClusterSlots, ClusterCursor) {
+  using fastonosql::core::cursor_t;
+  using fastonosql::core::redis_compatible::node_cursors_t;
+
+  ASSERT_TRUE(fastonosql::core::redis_compatible::MakeClusterCursor(node_cursors_t()).IsFinished());
+
+  node_cursors_t nodes;
+  nodes.push_back(std::make_pair(common::net::HostAndPort("127.0.0.1", 7000), 17));
+  nodes.push_back(std::make_pair(common::net::HostAndPort("127.0.0.1", 7001), 0));
+  const cursor_t cursor = fastonosql::core::redis_compatible::MakeClusterCursor(nodes);
+  ASSERT_FALSE(cursor.IsFinished());
+
+  cursor_t restored;
+  ASSERT_TRUE(cursor_t::FromString(cursor.ToString(), &restored));
+  node_cursors_t parsed;
+  ASSERT_TRUE(fastonosql::core::redis_compatible::ParseClusterCursor(restored, &parsed));
+  ASSERT_EQ(parsed.size(), 2);
+  ASSERT_EQ(parsed[0].first.GetPort(), 7000);
+  ASSERT_EQ(parsed[0].second, 17);
+  ASSERT_EQ(parsed[1].first.GetHost(), "127.0.0.1");
+  ASSERT_EQ(parsed[1].second, 0);
+
+  ASSERT_FALSE(fastonosql::core::redis_compatible::ParseClusterCursor(cursor_t(5), &parsed));
+}
+#endif
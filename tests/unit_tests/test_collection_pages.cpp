@@ -0,0 +1,80 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#ifdef BUILD_WITH_REDIS
+#include <fastonosql/core/db/redis/command_translator.h>
+
+namespace {
+fastonosql::core::NKey MakeKey(const char* name) {
+  return fastonosql::core::NKey(fastonosql::core::nkey_t(GEN_CMD_STRING(name)));
+}
+
+fastonosql::core::commands_args_t MakeArgs(std::initializer_list<const char*> args) {
+  fastonosql::core::commands_args_t argv;
+  for (const char* arg : args) {
+    argv.push_back(GEN_CMD_STRING(arg));
+  }
+  return argv;
+}
+}  // namespace
+
+TEST(CollectionPages, ListWindows) {
+  fastonosql::core::redis::CommandTranslator tran({});
+  fastonosql::core::commands_args_t argv;
+
+  ASSERT_FALSE(tran.CollectionScan(MakeKey("list"), common::Value::TYPE_ARRAY, 0, 1000, &argv));
+  ASSERT_EQ(argv, MakeArgs({"LRANGE", "list", "0", "999"}));
+
+  // the position of a list cursor is the index of the next element
+  ASSERT_FALSE(tran.CollectionScan(MakeKey("list"), common::Value::TYPE_ARRAY, 2000, 1000, &argv));
+  ASSERT_EQ(argv, MakeArgs({"LRANGE", "list", "2000", "2999"}));
+
+  ASSERT_FALSE(tran.CollectionSize(MakeKey("list"), common::Value::TYPE_ARRAY, &argv));
+  ASSERT_EQ(argv, MakeArgs({"LLEN", "list"}));
+}
+
+TEST(CollectionPages, Scans) {
+  fastonosql::core::redis::CommandTranslator tran({});
+  fastonosql::core::commands_args_t argv;
+
+  ASSERT_FALSE(tran.CollectionScan(MakeKey("set"), common::Value::TYPE_SET, 17, 100, &argv));
+  ASSERT_EQ(argv, MakeArgs({"SSCAN", "set", "17", "COUNT", "100"}));
+  ASSERT_FALSE(tran.CollectionScan(MakeKey("hash"), common::Value::TYPE_HASH, 0, 100, &argv));
+  ASSERT_EQ(argv, MakeArgs({"HSCAN", "hash", "0", "COUNT", "100"}));
+  ASSERT_FALSE(tran.CollectionScan(MakeKey("zset"), common::Value::TYPE_ZSET, 0, 100, &argv));
+  ASSERT_EQ(argv, MakeArgs({"ZSCAN", "zset", "0", "COUNT", "100"}));
+
+  ASSERT_FALSE(tran.CollectionSize(MakeKey("set"), common::Value::TYPE_SET, &argv));
+  ASSERT_EQ(argv, MakeArgs({"SCARD", "set"}));
+  ASSERT_FALSE(tran.CollectionSize(MakeKey("hash"), common::Value::TYPE_HASH, &argv));
+  ASSERT_EQ(argv, MakeArgs({"HLEN", "hash"}));
+  ASSERT_FALSE(tran.CollectionSize(MakeKey("zset"), common::Value::TYPE_ZSET, &argv));
+  ASSERT_EQ(argv, MakeArgs({"ZCARD", "zset"}));
+}
+
+TEST(CollectionPages, Unsupported) {
+  fastonosql::core::redis::CommandTranslator tran({});
+  fastonosql::core::commands_args_t argv;
+
+  ASSERT_TRUE(tran.CollectionScan(MakeKey("str"), common::Value::TYPE_STRING, 0, 100, &argv));
+  ASSERT_TRUE(tran.CollectionSize(MakeKey("str"), common::Value::TYPE_STRING, &argv));
+  ASSERT_TRUE(tran.CollectionScan(MakeKey("set"), common::Value::TYPE_SET, 0, 0, &argv));
+}
+#endif
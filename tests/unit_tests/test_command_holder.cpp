@@ -184,6 +184,27 @@ TEST(CommandHolder, execute) {
   ASSERT_FALSE(err);
   ASSERT_EQ(hld->name, JSON_GET_UPPER_CMD);
 
+  size_t off = 0;
+  const core::commands_args_t cmd_get_config_lower = {GEN_CMD_STRING("get"), GEN_CMD_STRING("Config"),
+                                                       GEN_CMD_STRING("alex")};
+  err = ft->FindCommand(cmd_get_config_lower, &hld, &off);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(hld->name, GET_CONFIG);
+  ASSERT_EQ(off, 2u);
+
+  const core::commands_args_t cmd_config_only = {CONFIG, GEN_CMD_STRING("alex")};
+  err = ft->FindCommand(cmd_config_only, &hld, &off);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(hld->name, CONFIG);
+  ASSERT_EQ(off, 1u);
+
+  err = ft->FindCommandFirstName(GEN_CMD_STRING("get"), &hld);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(hld->name, GET_CONFIG);
+
+  err = ft->FindCommandFirstName(GEN_CMD_STRING("CONFIGE"), &hld);
+  ASSERT_TRUE(err);
+
   err = hand->Execute(cmd_not_exists, NULL);
   ASSERT_TRUE(err);
 
@@ -112,6 +112,15 @@ TEST(Connection, redis) {
   conf.auth = "pass";
   conf.is_ssl = true;
   Checker(conf);
+
+  conf.read_from = fastonosql::core::redis::Config::READ_FROM_REPLICA_LEAST_LATENCY;
+  Checker(conf);
+
+  conf.sentinel_master = "mymaster";
+  Checker(conf);
+
+  conf.near_cache_size = 10000;
+  Checker(conf);
 }
 #endif
 
@@ -82,3 +82,68 @@ TEST(Keys, Ranges) {
   in_range = core::IsKeyInRange(bkey, a1key, ckey);
   ASSERT_FALSE(in_range);
 }
+
+TEST(Keys, ScanCursor) {
+  namespace core = fastonosql::core;
+  const core::cursor_t start;
+  ASSERT_TRUE(start.IsFinished());
+  ASSERT_EQ(start.ToString(), GEN_CMD_STRING("0"));
+
+  core::cursor_t parsed;
+  ASSERT_TRUE(core::cursor_t::FromString(GEN_CMD_STRING("0"), &parsed));
+  ASSERT_EQ(parsed, start);
+
+  const core::cursor_t server_cursor(UINT64_C(18446744073709551615));
+  ASSERT_FALSE(server_cursor.IsFinished());
+  ASSERT_FALSE(server_cursor.HasToken());
+  ASSERT_TRUE(core::cursor_t::FromString(server_cursor.ToString(), &parsed));
+  ASSERT_EQ(parsed, server_cursor);
+
+  const core::cursor_t key_cursor(10, core::raw_key_t({'k', 0, ':', 1}));
+  ASSERT_TRUE(key_cursor.HasToken());
+  ASSERT_EQ(key_cursor.ToString(), GEN_CMD_STRING("10:6b003a01"));
+  ASSERT_TRUE(core::cursor_t::FromString(key_cursor.ToString(), &parsed));
+  ASSERT_EQ(parsed, key_cursor);
+  ASSERT_EQ(parsed.GetPosition(), 10);
+
+  ASSERT_FALSE(core::cursor_t::FromString(core::readable_string_t(), &parsed));
+  ASSERT_FALSE(core::cursor_t::FromString(GEN_CMD_STRING("abc"), &parsed));
+  ASSERT_FALSE(core::cursor_t::FromString(GEN_CMD_STRING("10:"), &parsed));
+  ASSERT_FALSE(core::cursor_t::FromString(GEN_CMD_STRING("10:zz"), &parsed));
+}
+
+TEST(Keys, ScanPattern) {
+  namespace core = fastonosql::core;
+  const core::ScanPattern all("*");
+  ASSERT_TRUE(all.IsMatchAll());
+  ASSERT_TRUE(all.GetPrefix().empty());
+  ASSERT_TRUE(all.IsMatch("key", 3));
+  ASSERT_FALSE(all.IsMatch("", 0));
+
+  const core::ScanPattern user("user:1234:*");
+  ASSERT_FALSE(user.IsMatchAll());
+  ASSERT_EQ(user.GetPrefix(), GEN_CMD_STRING("user:1234:"));
+  ASSERT_TRUE(user.IsMatch("user:1234:", 10));
+  ASSERT_TRUE(user.IsMatch("user:1234:name", 14));
+  ASSERT_FALSE(user.IsMatch("user:1235:name", 14));
+  ASSERT_TRUE(user.HasPrefix("user:1234:name", 14));
+  ASSERT_FALSE(user.HasPrefix("user:12", 7));
+
+  const core::ScanPattern glob("h?llo*[^0-9]\\*");
+  ASSERT_EQ(glob.GetPrefix(), GEN_CMD_STRING("h"));
+  ASSERT_TRUE(glob.IsMatch("hello world*", 12));
+  ASSERT_TRUE(glob.IsMatch("hallox*", 7));
+  ASSERT_FALSE(glob.IsMatch("hllox*", 6));
+  ASSERT_FALSE(glob.IsMatch("hello1*", 7));
+  ASSERT_FALSE(glob.IsMatch("hellox", 6));
+
+  const core::ScanPattern range("[a-c]*z");
+  ASSERT_TRUE(range.GetPrefix().empty());
+  ASSERT_TRUE(range.IsMatch("bz", 2));
+  ASSERT_TRUE(range.IsMatch("azzz", 4));
+  ASSERT_FALSE(range.IsMatch("dz", 2));
+  ASSERT_FALSE(range.IsMatch("az1", 3));
+
+  ASSERT_TRUE(core::IsKeyMatchPattern("hello", 5, "h?llo"));
+  ASSERT_FALSE(core::IsKeyMatchPattern("hllo", 4, "h?llo"));
+}
@@ -0,0 +1,63 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#ifdef BUILD_WITH_REDIS
+#include <vector>
+
+#include <fastonosql/core/db/redis_compatible/message_ring.h>
+
+TEST(MessageRing, BatchesInOrder) {
+  fastonosql::core::redis_compatible::MessageRing ring(8);
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(ring.Push(common::Value::CreateInteger64Value(i)));
+  }
+  ASSERT_EQ(ring.GetSize(), 3);
+
+  std::vector<common::Value*> batch;
+  ASSERT_EQ(ring.PopBatch(2, &batch), 2);
+  ASSERT_EQ(ring.PopBatch(2, &batch), 1);
+  ASSERT_EQ(ring.PopBatch(2, &batch), 0);
+  for (size_t i = 0; i < batch.size(); ++i) {
+    int64_t value = 0;
+    ASSERT_TRUE(batch[i]->GetAsInteger64(&value));
+    ASSERT_EQ(value, static_cast<int64_t>(i));
+    delete batch[i];
+  }
+  ASSERT_EQ(ring.GetDroppedCount(), 0);
+}
+
+TEST(MessageRing, SamplesAndDropsUnderOverload) {
+  fastonosql::core::redis_compatible::MessageRing ring(8);
+  for (int i = 0; i < 100; ++i) {
+    ring.Push(common::Value::CreateInteger64Value(i));
+  }
+
+  ASSERT_EQ(ring.GetReceivedCount(), 100);
+  ASSERT_LE(ring.GetSize(), ring.GetCapacity());
+  ASSERT_EQ(ring.GetDroppedCount(), 100 - ring.GetSize());
+
+  std::vector<common::Value*> batch;
+  ring.PopBatch(ring.GetCapacity(), &batch);  // the ring keeps accepting once drained
+  for (common::Value* message : batch) {
+    delete message;
+  }
+  ASSERT_TRUE(ring.Push(common::Value::CreateInteger64Value(100)));
+}
+#endif
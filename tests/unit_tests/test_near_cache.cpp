@@ -0,0 +1,65 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#ifdef BUILD_WITH_REDIS
+#include <fastonosql/core/db/redis_compatible/near_cache.h>
+
+namespace {
+fastonosql::core::NKey MakeKey(const char* name) {
+  return fastonosql::core::NKey(fastonosql::core::nkey_t(GEN_CMD_STRING(name)));
+}
+}  // namespace
+
+TEST(NearCache, LeastRecentlyUsedEviction) {
+  fastonosql::core::redis_compatible::Config config;
+  fastonosql::core::redis_compatible::NearCache cache(config, fastonosql::core::SSHInfo(), 2);
+
+  cache.SetType(MakeKey("a"), GEN_CMD_STRING("string"));
+  cache.SetType(MakeKey("b"), GEN_CMD_STRING("hash"));
+  fastonosql::core::readable_string_t type;
+  ASSERT_TRUE(cache.GetType(MakeKey("a"), &type));  // a is the most recent now
+  ASSERT_EQ(type, GEN_CMD_STRING("string"));
+
+  cache.SetType(MakeKey("c"), GEN_CMD_STRING("list"));
+  ASSERT_EQ(cache.GetSize(), 2);
+  ASSERT_FALSE(cache.GetType(MakeKey("b"), &type));
+  ASSERT_TRUE(cache.GetType(MakeKey("a"), &type));
+  ASSERT_TRUE(cache.GetType(MakeKey("c"), &type));
+}
+
+TEST(NearCache, Invalidate) {
+  fastonosql::core::redis_compatible::Config config;
+  fastonosql::core::redis_compatible::NearCache cache(config, fastonosql::core::SSHInfo(), 10);
+
+  cache.SetTTL(MakeKey("a"), NO_TTL);
+  fastonosql::core::ttl_t ttl = 0;
+  ASSERT_TRUE(cache.GetTTL(MakeKey("a"), &ttl));
+  ASSERT_EQ(ttl, NO_TTL);
+
+  cache.Invalidate(GEN_CMD_STRING("a"));
+  ASSERT_FALSE(cache.GetTTL(MakeKey("a"), &ttl));
+
+  cache.SetTTL(MakeKey("b"), 100);
+  ASSERT_TRUE(cache.GetTTL(MakeKey("b"), &ttl));
+  ASSERT_LE(ttl, 100);
+  cache.Clear();
+  ASSERT_EQ(cache.GetSize(), 0);
+}
+#endif
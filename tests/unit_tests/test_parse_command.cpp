@@ -132,3 +132,40 @@ TEST(Parse, Other) {
   ASSERT_EQ(args[3], GEN_CMD_STRING("-1"));
   ASSERT_EQ(args.size(), 4);
 }
+
+TEST(Parse, Views) {
+  const fastonosql::core::command_buffer_t line = GEN_CMD_STRING("SET 'sp ace' \"\\x41B\" {\"a\": 1}");
+  fastonosql::core::command_args_views_t args;
+  fastonosql::core::commands_args_t unescaped;
+  bool is_ok = fastonosql::core::ParseCommandLine(line, &args, &unescaped);
+  ASSERT_TRUE(is_ok);
+  ASSERT_EQ(args.size(), 4);
+  ASSERT_EQ(args[0], "SET");
+  ASSERT_EQ(args[1], "sp ace");
+  ASSERT_EQ(args[2], "AB");
+  ASSERT_EQ(args[3], "{\"a\": 1}");
+
+  // only the hex escaped argument is copied
+  ASSERT_EQ(unescaped.size(), 1);
+  ASSERT_EQ(args[0].data(), line.data());
+  ASSERT_EQ(args[1].data(), line.data() + 5);
+  ASSERT_EQ(args[2].data(), unescaped[0].data());
+
+  is_ok = fastonosql::core::ParseCommandLine(GEN_CMD_STRING("SET 'unclosed"), &args, &unescaped);
+  ASSERT_FALSE(is_ok);
+}
+
+TEST(Parse, LongArguments) {
+  const std::string key(40, 'k');
+  const std::string value(70, 'v');
+  fastonosql::core::commands_args_t args;
+  const std::string line = "MSET " + key + " '" + value + " \\x41" + value + "' " + key + "{\"a\": [1, 2]} " + value;
+  bool is_ok = fastonosql::core::ParseCommandLine(GEN_CMD_STRING_SIZE(line.data(), line.size()), &args);
+  ASSERT_TRUE(is_ok);
+  ASSERT_EQ(args.size(), 5);
+  ASSERT_EQ(args[0], GEN_CMD_STRING("MSET"));
+  ASSERT_EQ(args[1].as_string(), key);
+  ASSERT_EQ(args[2].as_string(), value + " A" + value);
+  ASSERT_EQ(args[3].as_string(), key + "{\"a\": [1, 2]}");
+  ASSERT_EQ(args[4].as_string(), value);
+}
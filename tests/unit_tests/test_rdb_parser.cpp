@@ -0,0 +1,240 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#ifdef BUILD_WITH_REDIS
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+
+#include <fastonosql/core/db/redis_compatible/rdb_parser.h>
+
+namespace {
+const char kFarExpire[] = "\xFC\x00\x68\x50\xD4\xBB\x03\x00\x00";   // 2100 year in msec
+const char kPastExpire[] = "\xFC\xE8\x03\x00\x00\x00\x00\x00\x00";  // 1000 msec
+
+std::string MakeSnapshot() {
+  std::string rdb("REDIS0011", 9);
+  rdb += std::string("\xFA\x09redis-ver\x05" "7.0.0", 17);    // aux
+  rdb += std::string("\xFE\x00\xFB\x06\x01", 5);                 // select db 0, resize db
+  rdb += std::string("\x00\x01" "a\x05hello", 9);              // string
+  rdb += std::string(kFarExpire, 9);
+  rdb += std::string("\x00\x01" "b\xC0\x7B", 5);               // int encoded string 123
+  rdb += std::string(kPastExpire, 9);
+  rdb += std::string("\x00\x01" "x\x01y", 5);                  // expired
+  rdb += std::string("\x00\x01" "c\xC3\x05\x0A\x00" "a\xE0\x00\x00", 11);  // lzf "aaaaaaaaaa"
+  // intset {1, -2}
+  rdb += std::string("\x0B\x01s\x0C\x02\x00\x00\x00\x02\x00\x00\x00\x01\x00\xFE\xFF", 16);
+  // listpack hash {f: 7}
+  rdb += std::string("\x10\x01h\x0C\x0C\x00\x00\x00\x02\x00\x81" "f\x02\x07\x01\xFF", 16);
+  // quicklist with one packed node [x, 300]
+  rdb += std::string("\x12\x01l\x01\x02\x0D\x0D\x00\x00\x00\x02\x00\x81x\x02\xC1\x2C\x02\xFF", 19);
+  // ziplist zset {m: 2}
+  rdb += std::string("\x0C\x01z\x10\x10\x00\x00\x00\x0D\x00\x00\x00\x02\x00\x00\x01m\x03\xF3\xFF", 20);
+  rdb += std::string("\xFF\x00\x00\x00\x00\x00\x00\x00\x00", 9);  // eof, checksum
+  return rdb;
+}
+}  // namespace
+
+TEST(RdbParser, Encodings) {
+  const std::string rdb = MakeSnapshot() + "+PING\r\n";
+  size_t offset = 0;
+  auto read = [&rdb, &offset](char* buf, size_t size, size_t* nread) -> common::Error {
+    const size_t chunk = std::min<size_t>(std::min<size_t>(size, 3), rdb.size() - offset);  // small reads
+    if (!chunk) {
+      return common::make_error("eof");
+    }
+    memcpy(buf, rdb.data() + offset, chunk);
+    offset += chunk;
+    *nread = chunk;
+    return common::Error();
+  };
+
+  std::map<std::string, common::Value*> keys;
+  std::map<std::string, fastonosql::core::ttl_t> ttls;
+  auto on_key = [&keys, &ttls](int db_num, const fastonosql::core::NKey& key, common::Value* value) {
+    ASSERT_EQ(db_num, 0);
+    const std::string name = key.GetKey().GetData().as_string();
+    keys[name] = value;
+    ttls[name] = key.GetTTL();
+  };
+
+  fastonosql::core::redis_compatible::RdbParser parser(read, on_key);
+  ASSERT_FALSE(parser.Parse());
+  ASSERT_EQ(parser.GetVersion(), 11);
+  ASSERT_EQ(parser.GetKeysCount(), 7);
+  ASSERT_EQ(parser.GetSkippedKeysCount(), 1);
+  ASSERT_EQ(keys.count("x"), 0);
+
+  common::Value::string_t str;
+  ASSERT_TRUE(keys["a"]->GetAsString(&str));
+  ASSERT_EQ(str, GEN_CMD_STRING("hello"));
+  ASSERT_EQ(ttls["a"], NO_TTL);
+  ASSERT_TRUE(keys["b"]->GetAsString(&str));
+  ASSERT_EQ(str, GEN_CMD_STRING("123"));
+  ASSERT_GT(ttls["b"], 0);
+  ASSERT_TRUE(keys["c"]->GetAsString(&str));
+  ASSERT_EQ(str, GEN_CMD_STRING("aaaaaaaaaa"));
+
+  ASSERT_EQ(keys["s"]->GetType(), common::Value::TYPE_SET);
+  ASSERT_EQ(keys["h"]->GetType(), common::Value::TYPE_HASH);
+  ASSERT_EQ(keys["z"]->GetType(), common::Value::TYPE_ZSET);
+  common::ArrayValue* list = nullptr;
+  ASSERT_TRUE(keys["l"]->GetAsList(&list));
+  ASSERT_EQ(list->GetSize(), 2);
+  common::Value* element = nullptr;
+  ASSERT_TRUE(list->Get(1, &element));
+  ASSERT_TRUE(element->GetAsString(&str));
+  ASSERT_EQ(str, GEN_CMD_STRING("300"));
+
+  std::vector<char> left = parser.GetUnconsumed();
+  const std::string tail(left.begin(), left.end());
+  ASSERT_EQ(tail + rdb.substr(offset), "+PING\r\n");
+
+  for (auto& key : keys) {
+    delete key.second;
+  }
+}
+
+TEST(RdbParser, BadSignature) {
+  const std::string rdb("NOTRDB0011", 10);
+  size_t offset = 0;
+  auto read = [&rdb, &offset](char* buf, size_t size, size_t* nread) -> common::Error {
+    const size_t chunk = std::min<size_t>(size, rdb.size() - offset);
+    memcpy(buf, rdb.data() + offset, chunk);
+    offset += chunk;
+    *nread = chunk;
+    return common::Error();
+  };
+
+  auto on_key = [](int db_num, const fastonosql::core::NKey& key, common::Value* value) {
+    UNUSED(db_num);
+    UNUSED(key);
+    delete value;
+  };
+  fastonosql::core::redis_compatible::RdbParser parser(read, on_key);
+  ASSERT_TRUE(parser.Parse());
+}
+
+TEST(RdbParser, Diskless) {
+  // diskless SYNC: no payload size, the snapshot is followed by the 40 bytes eof mark
+  const std::string mark(40, 'e');
+  const std::string rdb = MakeSnapshot() + mark;
+  size_t offset = 0;
+  auto read = [&rdb, &offset](char* buf, size_t size, size_t* nread) -> common::Error {
+    const size_t chunk = std::min<size_t>(size, rdb.size() - offset);  // reads ahead into the mark
+    memcpy(buf, rdb.data() + offset, chunk);
+    offset += chunk;
+    *nread = chunk;
+    return common::Error();
+  };
+
+  size_t keys_count = 0;
+  auto on_key = [&keys_count](int db_num, const fastonosql::core::NKey& key, common::Value* value) {
+    UNUSED(db_num);
+    UNUSED(key);
+    keys_count++;
+    delete value;
+  };
+
+  fastonosql::core::redis_compatible::RdbParser parser(read, on_key);
+  ASSERT_FALSE(parser.Parse());
+  ASSERT_EQ(keys_count, 7);
+  std::vector<char> left = parser.GetUnconsumed();
+  const std::string tail(left.begin(), left.end());
+  ASSERT_EQ(tail + rdb.substr(offset), mark);
+}
+
+TEST(RdbParser, ListpackLongEntry) {
+  // listpack hash {<16378 bytes field>: 7}, the field entry is 16383 bytes long and has a 3 bytes backlen
+  const std::string field(16378, 'f');
+  std::string lp("\x0B\x40\x00\x00\x02\x00", 6);  // 16395 bytes, 2 entries
+  lp += std::string("\xF0\xFA\x3F\x00\x00", 5) + field + std::string("\xFF\xFF\x00", 3);
+  lp += std::string("\x07\x01\xFF", 3);
+  ASSERT_EQ(lp.size(), 16395);
+
+  std::string rdb("REDIS0011", 9);
+  rdb += std::string("\xFE\x00", 2);
+  rdb += std::string("\x10\x01h\x80\x00\x00\x40\x0B", 8) + lp;
+  rdb += std::string("\xFF\x00\x00\x00\x00\x00\x00\x00\x00", 9);
+  size_t offset = 0;
+  auto read = [&rdb, &offset](char* buf, size_t size, size_t* nread) -> common::Error {
+    const size_t chunk = std::min<size_t>(size, rdb.size() - offset);
+    memcpy(buf, rdb.data() + offset, chunk);
+    offset += chunk;
+    *nread = chunk;
+    return common::Error();
+  };
+
+  common::Value* hash = nullptr;
+  auto on_key = [&hash](int db_num, const fastonosql::core::NKey& key, common::Value* value) {
+    UNUSED(db_num);
+    UNUSED(key);
+    hash = value;
+  };
+
+  fastonosql::core::redis_compatible::RdbParser parser(read, on_key);
+  ASSERT_FALSE(parser.Parse());
+  ASSERT_TRUE(hash);
+  ASSERT_EQ(hash->GetType(), common::Value::TYPE_HASH);
+  delete hash;
+}
+
+TEST(RdbParser, SkipsStreamsAndFieldsTTL) {
+  std::string rdb("REDIS0012", 9);
+  rdb += std::string("\xFE\x00", 2);
+  // stream v3 with one listpack and a group holding one pending entry and one consumer
+  rdb += std::string("\x15\x01q\x01\x02id\x02lp", 10);
+  rdb += std::string("\x01\x05\x00\x05\x00\x00\x00\x01", 8);  // length, last, first, max deleted ids, added
+  rdb += std::string("\x01\x01g\x05\x00\x01", 6);                    // group g, last id, entries read
+  rdb += std::string("\x01", 1) + std::string(16 + 8, '\0') + std::string("\x01", 1);  // pending entry
+  rdb += std::string("\x01\x01" "c", 3) + std::string(16, '\0');          // consumer c, seen and active time
+  rdb += std::string("\x01", 1) + std::string(16, '\0');                // consumer pending id
+  // hash with field expiry: min expire, one [ttl, field, value]
+  rdb += std::string("\x18\x01h", 3) + std::string(8, '\0') + std::string("\x01\x00\x01" "f\x01v", 7);
+  // listpack hash with field expiry: min expire, blob
+  rdb += std::string("\x19\x01l", 3) + std::string(8, '\0') + std::string("\x02lp", 3);
+  rdb += std::string("\x00\x01" "a\x01" "b", 5);
+  rdb += std::string("\xFF\x00\x00\x00\x00\x00\x00\x00\x00", 9);
+  size_t offset = 0;
+  auto read = [&rdb, &offset](char* buf, size_t size, size_t* nread) -> common::Error {
+    const size_t chunk = std::min<size_t>(size, rdb.size() - offset);
+    memcpy(buf, rdb.data() + offset, chunk);
+    offset += chunk;
+    *nread = chunk;
+    return common::Error();
+  };
+
+  std::string name;
+  auto on_key = [&name](int db_num, const fastonosql::core::NKey& key, common::Value* value) {
+    UNUSED(db_num);
+    name = key.GetKey().GetData().as_string();
+    delete value;
+  };
+
+  fastonosql::core::redis_compatible::RdbParser parser(read, on_key);
+  ASSERT_FALSE(parser.Parse());
+  ASSERT_EQ(parser.GetKeysCount(), 1);
+  ASSERT_EQ(parser.GetSkippedKeysCount(), 3);
+  ASSERT_EQ(name, "a");
+  ASSERT_FALSE(parser.IsStoppedOnUnsupported());
+}
+#endif
@@ -0,0 +1,168 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#ifdef BUILD_WITH_REDIS
+#include <string>
+#include <vector>
+
+#include <fastonosql/core/db/redis_compatible/resp_reader.h>
+
+namespace {
+void Feed(fastonosql::core::redis_compatible::RespReader* reader, const std::string& data) {
+  reader->Feed(data.data(), data.size());
+}
+}  // namespace
+
+TEST(RespReader, SplitFeed) {
+  fastonosql::core::redis_compatible::RespReader reader;
+  common::Value* val = nullptr;
+  bool complete = false;
+
+  Feed(&reader, "$5\r\nhel");
+  ASSERT_FALSE(reader.GetReply(&val, &complete));
+  ASSERT_FALSE(complete);
+
+  Feed(&reader, "lo\r");
+  ASSERT_FALSE(reader.GetReply(&val, &complete));
+  ASSERT_FALSE(complete);
+
+  Feed(&reader, "\n:42\r\n");
+  ASSERT_FALSE(reader.GetReply(&val, &complete));
+  ASSERT_TRUE(complete);
+  common::Value::string_t str;
+  ASSERT_TRUE(val->GetAsString(&str));
+  ASSERT_EQ(str, GEN_CMD_STRING("hello"));
+  delete val;
+
+  ASSERT_FALSE(reader.GetReply(&val, &complete));
+  ASSERT_TRUE(complete);
+  int64_t integer = 0;
+  ASSERT_TRUE(val->GetAsInteger64(&integer));
+  ASSERT_EQ(integer, 42);
+  delete val;
+}
+
+TEST(RespReader, NestedAggregates) {
+  fastonosql::core::redis_compatible::RespReader reader;
+  Feed(&reader, "*3\r\n*2\r\n+a\r\n$-1\r\n*0\r\n%1\r\n$1\r\nk\r\n,1.5\r\n");
+  common::Value* val = nullptr;
+  bool complete = false;
+  ASSERT_FALSE(reader.GetReply(&val, &complete));
+  ASSERT_TRUE(complete);
+
+  common::ArrayValue* arr = nullptr;
+  ASSERT_TRUE(val->GetAsList(&arr));
+  ASSERT_EQ(arr->GetSize(), 3);
+
+  common::Value* element = nullptr;
+  common::ArrayValue* inner = nullptr;
+  ASSERT_TRUE(arr->Get(0, &element));
+  ASSERT_TRUE(element->GetAsList(&inner));
+  ASSERT_EQ(inner->GetSize(), 2);
+  ASSERT_TRUE(inner->Get(1, &element));
+  ASSERT_EQ(element->GetType(), common::Value::TYPE_NULL);
+
+  ASSERT_TRUE(arr->Get(1, &element));
+  ASSERT_TRUE(element->GetAsList(&inner));
+  ASSERT_EQ(inner->GetSize(), 0);
+
+  ASSERT_TRUE(arr->Get(2, &element));  // map is flattened to [key, value]
+  ASSERT_TRUE(element->GetAsList(&inner));
+  ASSERT_EQ(inner->GetSize(), 2);
+  ASSERT_TRUE(inner->Get(1, &element));
+  double number = 0;
+  ASSERT_TRUE(element->GetAsDouble(&number));
+  ASSERT_EQ(number, 1.5);
+  delete val;
+}
+
+TEST(RespReader, Resp3Scalars) {
+  fastonosql::core::redis_compatible::RespReader reader;
+  Feed(&reader, "|1\r\n+ttl\r\n:3\r\n#t\r\n_\r\n=8\r\ntxt:text\r\n");
+  common::Value* val = nullptr;
+  bool complete = false;
+
+  ASSERT_FALSE(reader.GetReply(&val, &complete));  // attribute is skipped
+  ASSERT_TRUE(complete);
+  bool flag = false;
+  ASSERT_TRUE(val->GetAsBoolean(&flag));
+  ASSERT_TRUE(flag);
+  delete val;
+
+  ASSERT_FALSE(reader.GetReply(&val, &complete));
+  ASSERT_TRUE(complete);
+  ASSERT_EQ(val->GetType(), common::Value::TYPE_NULL);
+  delete val;
+
+  ASSERT_FALSE(reader.GetReply(&val, &complete));
+  ASSERT_TRUE(complete);
+  common::Value::string_t str;
+  ASSERT_TRUE(val->GetAsString(&str));
+  ASSERT_EQ(str, GEN_CMD_STRING("text"));
+  delete val;
+}
+
+TEST(RespReader, StreamedElements) {
+  std::vector<common::Value::string_t> elements;
+  auto on_element = [&elements](size_t index, common::Value* element) {
+    ASSERT_EQ(index, elements.size());
+    common::Value::string_t str;
+    ASSERT_TRUE(element->GetAsString(&str));
+    elements.push_back(str);
+    delete element;
+  };
+
+  fastonosql::core::redis_compatible::RespReader reader(on_element);
+  common::Value* val = nullptr;
+  bool complete = false;
+  Feed(&reader, "*3\r\n$1\r\na\r\n$1\r\nb");
+  ASSERT_FALSE(reader.GetReply(&val, &complete));
+  ASSERT_FALSE(complete);
+  ASSERT_EQ(elements.size(), 1);  // handed out before the rest arrived
+
+  Feed(&reader, "\r\n$1\r\nc\r\n");
+  ASSERT_FALSE(reader.GetReply(&val, &complete));
+  ASSERT_TRUE(complete);
+  ASSERT_EQ(val, nullptr);
+  ASSERT_EQ(elements.size(), 3);
+  ASSERT_EQ(elements[2], GEN_CMD_STRING("c"));
+}
+
+TEST(RespReader, Errors) {
+  fastonosql::core::redis_compatible::RespReader reader;
+  common::Value* val = nullptr;
+  bool complete = false;
+
+  Feed(&reader, "-WRONGTYPE Operation\r\n*2\r\n:1\r\n-ERR nested\r\n");
+  common::Error err = reader.GetReply(&val, &complete);
+  ASSERT_TRUE(err);
+  ASSERT_TRUE(complete);
+
+  err = reader.GetReply(&val, &complete);  // whole reply is read before it fails
+  ASSERT_TRUE(err);
+  ASSERT_TRUE(complete);
+  ASSERT_EQ(val, nullptr);
+
+  Feed(&reader, "?\r\n");
+  err = reader.GetReply(&val, &complete);
+  ASSERT_TRUE(err);
+  ASSERT_FALSE(complete);
+}
+#endif
@@ -0,0 +1,39 @@
+/*  Copyright (C) 2014-2020 FastoGT. All right reserved.
+
+    This file is part of FastoNoSQL.
+
+    FastoNoSQL is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    FastoNoSQL is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with FastoNoSQL.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#ifdef BUILD_WITH_REDIS
+#include <fastonosql/core/db/redis_compatible/db_connection.h>
+
+using fastonosql::core::redis_compatible::IsScriptingUnavailableError;
+
+TEST(ScriptingErrors, Unavailable) {
+  ASSERT_TRUE(IsScriptingUnavailableError("ERR unknown command 'SCRIPT'"));
+  ASSERT_TRUE(IsScriptingUnavailableError("ERR unknown or unsupported command 'script'"));  // pika
+  ASSERT_TRUE(IsScriptingUnavailableError("NOPERM this user has no permissions to run the 'evalsha' command"));
+  ASSERT_TRUE(IsScriptingUnavailableError("ERR command not supported"));
+}
+
+TEST(ScriptingErrors, Transient) {
+  ASSERT_FALSE(IsScriptingUnavailableError("BUSY Redis is busy running a script."));
+  ASSERT_FALSE(IsScriptingUnavailableError("LOADING Redis is loading the dataset in memory"));
+  ASSERT_FALSE(IsScriptingUnavailableError("OOM command not allowed when used memory > 'maxmemory'."));
+  ASSERT_FALSE(IsScriptingUnavailableError("NOSCRIPT No matching script. Please use EVAL."));
+}
+#endif